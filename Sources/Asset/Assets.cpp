@@ -1,6 +1,7 @@
 #include "Assets.h"
 
 #include "Mod/ModLoader.h"
+#include "Core/Engine.h"
 
 AssetRef Assets::_Load(AssetGUID guid) {
 	//Asset not loaded load from file
@@ -22,6 +23,14 @@ AssetRef Assets::_Load(AssetGUID guid) {
 }
 
 void Assets::CreateAsset(AssetRef asset, const std::string& path) {
+	_CreateAsset(asset, path, nullptr);
+}
+
+void Assets::CreateAsset(AssetRef asset, const std::string& path, const std::vector<uint8>& data) {
+	_CreateAsset(asset, path, &data);
+}
+
+void Assets::_CreateAsset(AssetRef asset, const std::string& path, const std::vector<uint8>* data) {
 	//TODO: Check path validity
 	std::string ensurePath = (Mod::MODS / path).parent_path().generic_string();
 	std::filesystem::create_directory(ensurePath);
@@ -34,11 +43,20 @@ void Assets::CreateAsset(AssetRef asset, const std::string& path) {
 
 	{
 		FileWriter fr(relPath);
-		asset->Serialize(fr);
+		if (data != nullptr) {
+			fr.Serialize((void*)data->data(), data->size());
+		}
+		else {
+			asset->Serialize(fr);
+		}
 	}
 
 	Get()._AssetsCache[asset->_GUID] = asset;
 	ModLoader::Get().AddPath(path);
+
+	AssetCreatedEvent e;
+	e.path = path;
+	Engine::Get().DispatchEvent(e);
 }
 
 void Assets::SaveAsset(AssetRef asset) {
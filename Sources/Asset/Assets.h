@@ -7,6 +7,7 @@
 #include <filesystem>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include <functional>
 
 // Represent as hashed path asset
@@ -112,9 +113,10 @@ public:
 		return *this;
 	}
 	
-	inline bool IsValid() { return _Asset != nullptr; }
+	inline bool IsValid() const { return _Asset != nullptr; }
 
-	Asset* operator ->() {
+	// Const like a pointer, the asset itself can still be changed
+	Asset* operator ->() const {
 		CHECK(_Asset != nullptr);
 		return _Asset;
 	}
@@ -133,11 +135,62 @@ public:
 	}
 	AssetRefT(T* asset) : AssetRef(asset) { }
 
-	T* operator ->() {
+	T* operator ->() const {
 		return (T*)_Asset;
 	}
 };
 
+// Global class to load and manage Assets
+class Assets : public ModuleDef<Assets> {
+	std::unordered_map<AssetGUID, AssetRef> _AssetsCache;
+
+	static AssetGUID _GenerateGUID(void* seed) {
+		std::hash<void*> h;
+		return h(seed);
+	}
+
+	AssetRef _Load(AssetGUID GUID);
+	// Writes data or asset->Serialize when is nullptr
+	static void _CreateAsset(AssetRef asset, const std::string& path, const std::vector<uint8>* data);
+
+
+public:
+
+	static AssetGUID Hash(const std::string& assetPath) {
+		std::hash<std::string> h;
+		return h(assetPath);
+	}
+
+	// Create a asset in a file in the @path
+	// after created the Asset._GUID will be defined
+	// also caches it
+	// [Editor Only]
+	static void CreateAsset(AssetRef asset, const std::string& path);
+	// The same but writes data, the bytes of asset->Serialize already written somewhere else, so they aren't serialized again
+	// [Editor Only]
+	static void CreateAsset(AssetRef asset, const std::string& path, const std::vector<uint8>& data);
+
+	// Saves a already existing asset 
+	// [Editor Only]
+	static void SaveAsset(AssetRef asset);
+
+	// Delete an existing file asset
+	// [Editor Only]
+	static void DeleteAsset(AssetGUID guid);
+
+	//Load an asset from any Mod by its GUID
+	static AssetRef Load(AssetGUID GUID) { return Get()._Load(GUID); }
+	//Load an asset from any Mod by its name relative to Mods folder
+	static AssetRef Load(const std::string& name) { return Get()._Load(Hash(name)); }
+
+	// Tries to free memory
+	// It only frees memory that are mapped to files (with GUID)
+	// Runtime assets are not freed
+	static void GarbageCollect() {
+		//TODO: Try to clean assets that are not used Both Runtime and Loaded ones
+		CHECK(0);
+	}
+};
 // Used to reference an Asset that has a Mod/Path even though it may be not loaded
 // Also used to save the asset reference
 template<class T, typename = std::enable_if<std::is_base_of_v<Asset, T>>>
@@ -190,52 +243,6 @@ public:
 };
 
 
-// Global class to load and manage Assets
-class Assets : public ModuleDef<Assets> {
-	std::unordered_map<AssetGUID, AssetRef> _AssetsCache;
-
-	static AssetGUID _GenerateGUID(void* seed) {
-		std::hash<void*> h;
-		return h(seed);
-	}
-
-	AssetRef _Load(AssetGUID GUID);
-
-
-public:
-
-	static AssetGUID Hash(const std::string& assetPath) {
-		std::hash<std::string> h;
-		return h(assetPath);
-	}
-
-	// Create a asset in a file in the @path
-	// after created the Asset._GUID will be defined
-	// also caches it
-	// [Editor Only]
-	static void CreateAsset(AssetRef asset, const std::string& path);
-
-	// Saves a already existing asset 
-	// [Editor Only]
-	static void SaveAsset(AssetRef asset);
-
-	// Delete an existing file asset
-	// [Editor Only]
-	static void DeleteAsset(AssetGUID guid);
-
-	//Load an asset from any Mod by its GUID
-	static AssetRef Load(AssetGUID GUID) { return Get()._Load(GUID); }
-	//Load an asset from any Mod by its name relative to Mods folder
-	static AssetRef Load(const std::string& name) { return Get()._Load(Hash(name)); }
-
-	// Tries to free memory
-	// It only frees memory that are mapped to files (with GUID)
-	// Runtime assets are not freed
-	static void GarbageCollect() {
-		//TODO: Try to clean assets that are not used Both Runtime and Loaded ones
-		CHECK(0);
-	}
-};
 
 class AssetSerializer {
 public:
@@ -2,19 +2,28 @@
 
 #include "stb/stb_image.h"
 
+#include <vector>
+
 void ImageAsset::Serialize(Stream& S) {
 	if (!S.IsLoading()) {
 		Log::critical("ImageAsset saving not supported!");
 		CHECK(0);
 	}
 
-	void* data = malloc(S.GetSize());
-	S.Serialize(data, S.GetSize());
+	//Decoded in place from mapped files
+	size_t size = S.GetSize();
+	std::vector<uint8> bytes;
+	const uint8* data = S.ReadView(size);
+	if (data == nullptr) {
+		bytes.resize(size);
+		S.Serialize(bytes.data(), size);
+		data = bytes.data();
+	}
 
 	int w = 0;
 	int h = 0;
 	int c = 0;
-	stbi_uc* result = stbi_load_from_memory((const stbi_uc*)data, S.GetSize(), &w, &h, &c, 4);
+	stbi_uc* result = stbi_load_from_memory((const stbi_uc*)data, (int)size, &w, &h, &c, 4);
 
 	if (result == nullptr) {
 		Log::error("Failed to load Image {}", S.GetIdentifier());
@@ -22,8 +31,9 @@ void ImageAsset::Serialize(Stream& S) {
 	else {
 		_Image = Image::Create(Image::Info(Format::R8G8B8A8Unorm, { (uint32)w, (uint32)h }));
 		
-		Buffer staging = Buffer::Create(w*h*c);
-		staging.update(result, w*h*c);
+		//Always decoded with 4 channels, c is the channels in the file
+		Buffer staging = Buffer::Create(w * h * 4);
+		staging.update(result, w * h * 4);
 
 		Graphics::Transfer([&](CmdBuffer& cmd) {
 			cmd.barrier(_Image, ImageLayout::Undefined, ImageLayout::TransferDst);
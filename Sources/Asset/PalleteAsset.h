@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Assets.h"
+#include "Core/Engine.h"
 #include "IO/Stream.h"
 #include "Vox/PalleteCache.h"
 
@@ -39,6 +40,8 @@ class PalleteAsset : public Asset {
 	int32 PalleteIndex = -1; //Index in PalleteCache Global
 
 	virtual void OnLoad() {
+		//Headless has no PalleteCache, the index stays -1
+		if (Engine::IsHeadless())return;
 		PalleteIndex = PalleteCache::AllocatePalleteIndex(this);
 		Upload();
 	}
@@ -48,12 +51,12 @@ public:
 		OnLoad();
 	}
 	~PalleteAsset(){
-		PalleteCache::FreePalleteIndex(this);
+		if (PalleteIndex != -1)PalleteCache::FreePalleteIndex(this);
 	}
 
 	//Should be called after Pallete.Data has been changed
 	void Upload() {
-		PalleteCache::UploadPallete(this);
+		if (PalleteIndex != -1)PalleteCache::UploadPallete(this);
 	}
 
 	int32 GetPalleteIndex() { return PalleteIndex; }
@@ -134,6 +134,25 @@ entt::entity PrefabAsset::Spawn(World* W, entt::entity parentEntity) {
 				Character c;
 				R.emplace_or_replace<Character>(e, c);
 			}
+			else if (component.first == "CharacterController") {
+				CharacterController c;
+				c.HalfExtents = readVec3(component.second["HalfExtents"].string_value());
+				c.Offset = readVec3(component.second["Offset"].string_value());
+				c.StepHeight = component.second["StepHeight"].number_value();
+				R.emplace_or_replace<CharacterController>(e, c);
+			}
+			else if (component.first == "RigidBody") {
+				RigidBody c;
+				c.VoxelMass = component.second["VoxelMass"].number_value();
+				c.Friction = component.second["Friction"].number_value();
+				c.Restitution = component.second["Restitution"].number_value();
+				R.emplace_or_replace<RigidBody>(e, c);
+			}
+			else if (component.first == "Collider") {
+				Collider c;
+				c.Layers = (uint32)component.second["Layers"].int_value();
+				R.emplace_or_replace<Collider>(e, c);
+			}
 		}
 	}
 
@@ -227,6 +246,34 @@ void PrefabAsset::FromWorld(World* W, entt::entity entityToSave) {
 			auto cjson = Json::object();
 			entity.emplace("Character", cjson);
 		}
+		if (R.has<CharacterController>(child)) {
+			auto& c = R.get<CharacterController>(child);
+			auto cjson = Json::object();
+
+			cjson.emplace("HalfExtents", writeVec3(c.HalfExtents).c_str());
+			cjson.emplace("Offset", writeVec3(c.Offset).c_str());
+			cjson.emplace("StepHeight", c.StepHeight);
+
+			entity.emplace("CharacterController", cjson);
+		}
+		if (R.has<RigidBody>(child)) {
+			auto& c = R.get<RigidBody>(child);
+			auto cjson = Json::object();
+
+			cjson.emplace("VoxelMass", c.VoxelMass);
+			cjson.emplace("Friction", c.Friction);
+			cjson.emplace("Restitution", c.Restitution);
+
+			entity.emplace("RigidBody", cjson);
+		}
+		if (R.has<Collider>(child)) {
+			auto& c = R.get<Collider>(child);
+			auto cjson = Json::object();
+
+			cjson.emplace("Layers", (int)c.Layers);
+
+			entity.emplace("Collider", cjson);
+		}
 
 		entities.push_back(entity);
 
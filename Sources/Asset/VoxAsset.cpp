@@ -1,64 +1,507 @@
 #include "VoxAsset.h"
 
-void VoxAsset::Upload() {
+#include "Core/Engine.h"
+#include "Job/Jobs.h"
+#include "Vox/VoxCodec.h"
 
-	// MipMaps
-	Buffer buffer = Buffer::Create(SizeX * SizeY * SizeZ, BufferUsage::TransferSrc);
-	int parentSizeX = SizeX, parentSizeY = SizeY, parentSizeZ = SizeZ;
-	uint8_t* parentData = (uint8_t*)malloc(SizeX * SizeY * SizeZ);
-	uint8_t* data = (uint8_t*)buffer.getData();
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
-	//Copy First mip level
-	std::memcpy(data, Data.data(), Data.size());
+VoxAsset::VoxAsset(VoxGrid&& grid) : VoxAsset(std::move(grid), std::vector<VoxGrid>()) {
+}
 
-	//TODO: Correct Mip
+VoxAsset::VoxAsset(VoxGrid&& grid, std::vector<VoxGrid>&& lods) : Grid(std::move(grid)), Lods(std::move(lods)) {
+	glm::ivec3 size = Grid.GetSize();
+	CHECK(size == AlignSize(size));
+	SizeX = size.x;
+	SizeY = size.y;
+	SizeZ = size.z;
 
-	for (int mip = 0; mip < _Image.getMipCount(); mip++) {
+	if (Lods.empty()) {
+		BuildLods(Grid, Lods);
+	}
+	CHECK(Lods.size() == LodCount - 1);
+	CreateImage();
+}
 
-		if (mip > 0) {
-			int mipSizeX = parentSizeX > 1 ? parentSizeX / 2 : 1;
-			int mipSizeY = parentSizeY > 1 ? parentSizeY / 2 : 1;
-			int mipSizeZ = parentSizeZ > 1 ? parentSizeZ / 2 : 1;
+void VoxAsset::CreateImage() {
+	//Headless (--cook, --test) has no Graphics, only the CPU data is built
+	if (Engine::IsHeadless())return;
+	_Image = Image::Create(Image::Info(Format::R8Uint, { SizeX, SizeY, SizeZ }).setMipCount(LodCount).setFilter(Filter::Nearest));
+}
 
-			//Swap
-			std::memcpy(parentData, data, parentSizeX * parentSizeY * parentSizeZ);
+void VoxAsset::OnLoad() {
+	CreateImage();
+	Upload();
+}
 
-			for (int x = 0; x < mipSizeX; x++) {
-				for (int y = 0; y < mipSizeY; y++) {
-					for (int z = 0; z < mipSizeZ; z++) {
-						uint8_t vox = 0;
+void VoxAsset::Write(Stream& S, const VoxGrid& grid, const std::vector<VoxGrid>& lods) {
+	CHECK(lods.size() == LodCount - 1);
+	uint32 marker = 0;
+	uint32 version = LodVersion;
+	glm::uvec3 size = grid.GetSize();
+	S | marker | version | size.x | size.y | size.z;
+	VoxCodec::Write(S, grid);
+	for (const VoxGrid& lod : lods) {
+		VoxCodec::Write(S, lod);
+	}
+}
 
-						for (int vi = 0; vi < 9; vi++) {
-							uint8_t upperVox = *(
-								parentData +
-								(2 * x + ((vi >> 0) & 1)) +
-								(2 * y + ((vi >> 1) & 1)) * parentSizeX +
-								(2 * z + ((vi >> 2) & 1)) * parentSizeX * parentSizeY
-								);
+void VoxAsset::Serialize(Stream& S) {
+	if (!S.IsLoading()) {
+		Write(S, Grid, Lods);
+		return;
+	}
 
-							if (upperVox) {
-								vox = upperVox;
-								break;
-							}
-						}
+	uint32 marker = 0;
+	uint32 version = CompressedVersion;
+	S | marker;
+
+	if (marker != 0) {
+		SizeX = marker;
+		S | SizeY | SizeZ;
+		glm::ivec3 size(SizeX, SizeY, SizeZ);
+		size_t bytes = (size_t)SizeX * SizeY * SizeZ;
+
+		std::vector<uint8> dense;
+		const uint8* data = S.ReadView(bytes);
+		if (data == nullptr) {
+			dense.resize(bytes);
+			S.Serialize(dense.data(), bytes);
+			data = dense.data();
+		}
+		Grid.CopyFromDense(data, size);
+		BuildLods(Grid, Lods);
+		return;
+	}
+
+	S | version | SizeX | SizeY | SizeZ;
+	glm::ivec3 size(SizeX, SizeY, SizeZ);
+
+	Grid.Resize(size);
+	bool valid = (version == CompressedVersion || version == LodVersion) && VoxCodec::Read(S, Grid);
+	if (!valid) {
+		Log::error("Corrupted vox asset {} version {}", S.GetIdentifier(), version);
+		Grid.Resize(size);
+	}
 
-						*(data + x + y * mipSizeX + z * mipSizeX * mipSizeY) = vox;
+	//The older files only have the grid, their LOD chain is built once here
+	if (valid && version >= LodVersion) {
+		Lods.resize(LodCount - 1);
+		for (int32 level = 1; level < LodCount && valid; level++) {
+			Lods[level - 1].Resize(size >> level);
+			valid = VoxCodec::Read(S, Lods[level - 1]);
+		}
+		if (valid)return;
+		Log::error("Corrupted LOD chain of vox asset {}", S.GetIdentifier());
+	}
+	BuildLods(Grid, Lods);
+}
+
+// Most common value not 0 of the children, the first in x, y, z order on a tie, 0 when all of them are 0
+static uint8 MajorityValue(const uint8 (&children)[8]) {
+	uint8 best = 0;
+	int32 bestCount = 0;
+	for (int32 i = 0; i < 8; i++) {
+		if (children[i] == 0 || children[i] == best)continue;
+		int32 count = 1;
+		for (int32 j = i + 1; j < 8; j++) {
+			count += children[j] == children[i];
+		}
+		if (count > bestCount) {
+			best = children[i];
+			bestCount = count;
+		}
+	}
+	return best;
+}
+
+// Reduces the voxels of lod from min to max (inclusive) from the level before it
+// serially when the caller already runs in the Jobs threads
+static void ReduceLod(const VoxGrid& parent, VoxGrid& lod, const glm::ivec3& min, const glm::ivec3& max, bool parallel) {
+	glm::ivec3 lo = glm::max(min, glm::ivec3(0));
+	glm::ivec3 hi = glm::min(max, lod.GetSize() - 1);
+	if (glm::any(glm::lessThan(hi, lo)))return;
+
+	//The bricks are reduced in parallel and written after
+	glm::ivec3 brickLo = lo >> VoxGrid::BrickShift;
+	glm::ivec3 count = (hi >> VoxGrid::BrickShift) - brickLo + 1;
+	int32 brickCount = count.x * count.y * count.z;
+	std::vector<uint8> cells((size_t)brickCount * VoxGrid::BrickCells);
+	std::vector<uint8> reduced(brickCount, 0);
+	glm::ivec3 parentBricks = parent.GetBrickCount();
+
+	auto reduce = [&](int32 index) {
+		glm::ivec3 brick = brickLo + glm::ivec3(index % count.x, (index / count.x) % count.y, index / (count.x * count.y));
+
+		//Nothing to do when the brick and its 2^3 children bricks are empty
+		bool empty = lod.IsBrickEmpty(brick);
+		for (int32 i = 0; i < 8 && empty; i++) {
+			glm::ivec3 child = brick * 2 + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+			empty = glm::any(glm::greaterThanEqual(child, parentBricks)) || parent.IsBrickEmpty(child);
+		}
+		if (empty)return;
+
+		uint8* dst = cells.data() + (size_t)index * VoxGrid::BrickCells;
+		memcpy(dst, lod.GetBrick(brick).Cells, VoxGrid::BrickCells);
+		glm::ivec3 from = glm::max(brick * VoxGrid::BrickSize, lo);
+		glm::ivec3 to = glm::min(brick * VoxGrid::BrickSize + VoxGrid::BrickSize - 1, hi);
+		for (int32 z = from.z; z <= to.z; z++) {
+			for (int32 y = from.y; y <= to.y; y++) {
+				for (int32 x = from.x; x <= to.x; x++) {
+					glm::ivec3 voxel(x, y, z);
+					uint8 children[8];
+					for (int32 i = 0; i < 8; i++) {
+						children[i] = parent.Get(voxel * 2 + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2));
 					}
+					dst[VoxGrid::CellIndex(voxel & (VoxGrid::BrickSize - 1))] = MajorityValue(children);
 				}
 			}
+		}
+		reduced[index] = 1;
+	};
 
-			if (parentSizeX > 1) parentSizeX /= 2;
-			if (parentSizeY > 1) parentSizeY /= 2;
-			if (parentSizeZ > 1) parentSizeZ /= 2;
+	if (parallel) {
+		Jobs::Context context;
+		Jobs::ParallelFor(brickCount, [&](int index, int /*group*/) { reduce(index); }, context);
+		Jobs::Complete(context);
+	}
+	else {
+		for (int32 index = 0; index < brickCount; index++) {
+			reduce(index);
 		}
+	}
+
+	for (int32 index = 0; index < brickCount; index++) {
+		if (!reduced[index])continue;
+		glm::ivec3 brick = brickLo + glm::ivec3(index % count.x, (index / count.x) % count.y, index / (count.x * count.y));
+		memcpy(lod.WriteBrick(brick), cells.data() + (size_t)index * VoxGrid::BrickCells, VoxGrid::BrickCells);
+		lod.UpdateBrick(brick);
+	}
+}
+
+void VoxAsset::BuildLods(const VoxGrid& grid, std::vector<VoxGrid>& lods, bool parallel) {
+	lods.resize(LodCount - 1);
+	for (int32 level = 1; level < LodCount; level++) {
+		const VoxGrid& parent = level == 1 ? grid : lods[level - 2];
+		VoxGrid& lod = lods[level - 1];
+		lod.Resize(parent.GetSize() / 2);
+		ReduceLod(parent, lod, glm::ivec3(0), lod.GetSize() - 1, parallel);
+	}
+}
+
+void VoxAsset::UpdateLods(const glm::ivec3& min, const glm::ivec3& max) {
+	glm::ivec3 lo = min;
+	glm::ivec3 hi = max;
+	for (int32 level = 1; level < LodCount; level++) {
+		lo = lo >> 1;
+		hi = hi >> 1;
+		ReduceLod(GetLod(level - 1), Lods[level - 1], lo, hi, true);
+	}
+}
+
+void VoxAsset::Upload() {
+	Upload(std::vector<VoxAsset*>{ this });
+}
+
+void VoxAsset::Upload(const std::vector<VoxAsset*>& assets) {
+	if (assets.empty())return;
+
+	//The CPU data is built while the levels are copied and uploaded
+	Jobs::Context context;
+	for (VoxAsset* asset : assets) {
+		Jobs::Run([asset]() {
+			asset->_Occupancy.Build(asset->Grid);
+			asset->_MassProperties = MassProperties::FromOccupancy(asset->_Occupancy);
+		}, context);
+		Jobs::Run([asset]() {
+			std::shared_ptr<VoxSurface> surface = std::make_shared<VoxSurface>();
+			surface->Build(asset->Grid, ShadowMinValue);
+			asset->_Surface = surface;
+		}, context);
+
+		//The levels are only copied, the edits are reduced first
+		if (!asset->_DirtyBricks.empty()) {
+			asset->UpdateLods(asset->_DirtyMin, asset->_DirtyMax);
+		}
+	}
+
+	if (!Engine::IsHeadless()) {
+		UploadLevels(assets);
+	}
+	Jobs::Complete(context);
+
+	//The bounds of the previous edits don't cover the whole change
+	for (VoxAsset* asset : assets) {
+		asset->ClearDirty();
+		asset->_EditHistory.clear();
+		asset->_Revision++;
+	}
+	_EditCount++;
+}
+
+void VoxAsset::UploadLevels(const std::vector<VoxAsset*>& assets) {
+	//Every level of every asset one after another in the same staging buffer
+	std::vector<std::vector<ImageRegion>> regions(assets.size());
+	size_t total = 0;
+	for (size_t i = 0; i < assets.size(); i++) {
+		for (int32 mip = 0; mip < assets[i]->_Image.getMipCount(); mip++) {
+			glm::ivec3 size = assets[i]->GetLod(mip).GetSize();
+			regions[i].push_back(ImageRegion{ 0, 0, 0, (uint32)size.x, (uint32)size.y, (uint32)size.z, (uint32)mip, 0, (int64_t)total });
+			total += ((size_t)size.x * size.y * size.z + 15) & ~(size_t)15;
+		}
+	}
 
-		Graphics::Transfer([&](CmdBuffer& cmd){
-			cmd.barrier(_Image, ImageLayout::Undefined, ImageLayout::TransferDst, mip);
-			cmd.copy(buffer, _Image, mip);
-			cmd.barrier(_Image, ImageLayout::TransferDst, ImageLayout::ShaderReadOptimal, mip);
-		});
+	Buffer staging = Buffer::Create(total, BufferUsage::TransferSrc);
+	uint8* data = (uint8*)staging.getData();
 
+	Jobs::Context copyContext;
+	for (size_t i = 0; i < assets.size(); i++) {
+		for (const ImageRegion& region : regions[i]) {
+			Jobs::Run([&, i]() {
+				assets[i]->GetLod(region.mip).CopyToDense(data + region.bufferOffset);
+			}, copyContext);
+		}
 	}
+	Jobs::Complete(copyContext);
+
+	Graphics::Transfer([&](CmdBuffer& cmd) {
+		for (size_t i = 0; i < assets.size(); i++) {
+			Image& image = assets[i]->_Image;
+			cmd.barrier(image, ImageLayout::Undefined, ImageLayout::TransferDst, 0, image.getMipCount());
+			cmd.copy(staging, image, regions[i]);
+			cmd.barrier(image, ImageLayout::TransferDst, ImageLayout::ShaderReadOptimal, 0, image.getMipCount());
+		}
+	});
+}
+
+void VoxAsset::MarkDirty(const glm::ivec3& min, const glm::ivec3& max) {
+	glm::ivec3 lo = glm::max(min, glm::ivec3(0));
+	glm::ivec3 hi = glm::min(max, Grid.GetSize() - 1);
+	if (glm::any(glm::lessThan(hi, lo)))return;
+
+	_DirtyMin = glm::min(_DirtyMin, lo);
+	_DirtyMax = glm::max(_DirtyMax, hi);
+
+	glm::ivec3 bricks = Grid.GetBrickCount();
+	_DirtyFlags.resize((size_t)bricks.x * bricks.y * bricks.z, 0);
+	glm::ivec3 brickLo = lo >> VoxGrid::BrickShift;
+	glm::ivec3 brickHi = hi >> VoxGrid::BrickShift;
+	for (int32 z = brickLo.z; z <= brickHi.z; z++) {
+		for (int32 y = brickLo.y; y <= brickHi.y; y++) {
+			for (int32 x = brickLo.x; x <= brickHi.x; x++) {
+				int32 index = x + y * bricks.x + z * bricks.x * bricks.y;
+				if (_DirtyFlags[index])continue;
+				_DirtyFlags[index] = 1;
+				_DirtyBricks.push_back(index);
+			}
+		}
+	}
+}
+
+void VoxAsset::ClearDirty() {
+	for (int32 index : _DirtyBricks) {
+		_DirtyFlags[index] = 0;
+	}
+	_DirtyBricks.clear();
+	_DirtyMin = glm::ivec3(INT32_MAX);
+	_DirtyMax = glm::ivec3(INT32_MIN);
+}
+
+void VoxAsset::FillBox(const glm::ivec3& min, const glm::ivec3& max, uint8 value) {
+	glm::ivec3 lo = glm::max(min, glm::ivec3(0));
+	glm::ivec3 hi = glm::min(max, Grid.GetSize() - 1);
+	for (int32 z = lo.z; z <= hi.z; z++) {
+		for (int32 y = lo.y; y <= hi.y; y++) {
+			for (int32 x = lo.x; x <= hi.x; x++) {
+				Grid.Set(glm::ivec3(x, y, z), value);
+			}
+		}
+	}
+	MarkDirty(lo, hi);
+}
+
+// Calls callback(voxel) for the voxels with the center inside the sphere, returns the bounds visited
+template<typename T>
+static void ForEachInSphere(const glm::ivec3& size, const glm::vec3& center, float radius, glm::ivec3& lo, glm::ivec3& hi, T callback) {
+	lo = glm::max(glm::ivec3(glm::floor(center - radius)), glm::ivec3(0));
+	hi = glm::min(glm::ivec3(glm::ceil(center + radius)), size - 1);
+	float radius2 = radius * radius;
+	for (int32 z = lo.z; z <= hi.z; z++) {
+		for (int32 y = lo.y; y <= hi.y; y++) {
+			for (int32 x = lo.x; x <= hi.x; x++) {
+				glm::vec3 d = glm::vec3(x, y, z) + 0.5f - center;
+				if (glm::dot(d, d) <= radius2)callback(glm::ivec3(x, y, z));
+			}
+		}
+	}
+}
+
+void VoxAsset::FillSphere(const glm::vec3& center, float radius, uint8 value) {
+	glm::ivec3 lo, hi;
+	ForEachInSphere(Grid.GetSize(), center, radius, lo, hi, [&](const glm::ivec3& voxel) {
+		Grid.Set(voxel, value);
+	});
+	MarkDirty(lo, hi);
+}
+
+void VoxAsset::PaintSphere(const glm::vec3& center, float radius, uint8 value) {
+	if (value == 0)return;
+
+	glm::ivec3 lo, hi;
+	ForEachInSphere(Grid.GetSize(), center, radius, lo, hi, [&](const glm::ivec3& voxel) {
+		if (Grid.Get(voxel) != 0)Grid.Set(voxel, value);
+	});
+	MarkDirty(lo, hi);
+}
+
+VoxGrid VoxAsset::CopyRegion(const glm::ivec3& min, const glm::ivec3& max) const {
+	VoxGrid region(glm::max(max - min + 1, glm::ivec3(0)));
+	glm::ivec3 lo = glm::max(min, glm::ivec3(0));
+	glm::ivec3 hi = glm::min(max, Grid.GetSize() - 1);
+	if (glm::any(glm::lessThan(hi, lo)))return region;
+
+	//The empty bricks are skipped
+	glm::ivec3 brickLo = lo >> VoxGrid::BrickShift;
+	glm::ivec3 brickHi = hi >> VoxGrid::BrickShift;
+	for (int32 bz = brickLo.z; bz <= brickHi.z; bz++) {
+		for (int32 by = brickLo.y; by <= brickHi.y; by++) {
+			for (int32 bx = brickLo.x; bx <= brickHi.x; bx++) {
+				glm::ivec3 brick(bx, by, bz);
+				if (Grid.IsBrickEmpty(brick))continue;
+
+				glm::ivec3 from = glm::max(brick * VoxGrid::BrickSize, lo);
+				glm::ivec3 to = glm::min(brick * VoxGrid::BrickSize + VoxGrid::BrickSize - 1, hi);
+				for (int32 z = from.z; z <= to.z; z++) {
+					for (int32 y = from.y; y <= to.y; y++) {
+						for (int32 x = from.x; x <= to.x; x++) {
+							glm::ivec3 voxel(x, y, z);
+							uint8 value = Grid.Get(voxel);
+							if (value != 0)region.Set(voxel - min, value);
+						}
+					}
+				}
+			}
+		}
+	}
+	return region;
+}
+
+void VoxAsset::PasteRegion(const VoxGrid& region, const glm::ivec3& position, bool replace) {
+	glm::ivec3 max = position + region.GetSize() - 1;
+	if (replace) {
+		FillBox(position, max, 0);
+	}
+	region.ForEachVoxel([&](const glm::ivec3& voxel, uint8 value) {
+		Grid.Set(position + voxel, value);
+	});
+	MarkDirty(position, max);
+}
+
+bool VoxAsset::GetEditedBounds(uint32 revision, glm::ivec3& min, glm::ivec3& max) const {
+	if (_EditHistory.empty() || _EditHistory.front().Revision > revision + 1)return false;
+
+	min = glm::ivec3(INT32_MAX);
+	max = glm::ivec3(INT32_MIN);
+	for (const EditRecord& edit : _EditHistory) {
+		if (edit.Revision <= revision)continue;
+		min = glm::min(min, edit.Min);
+		max = glm::max(max, edit.Max);
+	}
+	return true;
+}
+
+void VoxAsset::ApplyEdits() {
+	if (_DirtyBricks.empty())return;
+
+	//The mips past the brick size mix several bricks
+	if (LodCount > VoxGrid::BrickShift + 1) {
+		Upload();
+		return;
+	}
+
+	_Occupancy.Update(Grid, _DirtyMin, _DirtyMax);
+	_MassProperties = MassProperties::FromOccupancy(_Occupancy);
+	std::shared_ptr<VoxSurface> surface = std::make_shared<VoxSurface>();
+	surface->Rebuild(*_Surface, Grid, ShadowMinValue, _DirtyMin, _DirtyMax);
+	_Surface = surface;
+
+	UpdateLods(_DirtyMin, _DirtyMax);
+	if (!Engine::IsHeadless()) {
+		UploadBricks();
+	}
+
+	_Revision++;
+	_EditHistory.push_back(EditRecord{ _Revision, _DirtyMin, _DirtyMax });
+	if (_EditHistory.size() > MaxEditHistory) {
+		_EditHistory.erase(_EditHistory.begin());
+	}
+	_EditCount++;
+	ClearDirty();
+}
+
+void VoxAsset::UploadBricks() {
+	int32 mipCount = _Image.getMipCount();
+	glm::ivec3 imageSize(SizeX, SizeY, SizeZ);
+	glm::ivec3 bricks = Grid.GetBrickCount();
+
+	//Room for a whole brick and its mips, the edge bricks use less
+	std::vector<size_t> mipOffsets(mipCount);
+	size_t brickBytes = 0;
+	for (int32 mip = 0; mip < mipCount; mip++) {
+		int32 size = VoxGrid::BrickSize >> mip;
+		mipOffsets[mip] = brickBytes;
+		brickBytes += (((size_t)size * size * size) + 15) & ~(size_t)15;
+	}
+
+	Buffer staging = Buffer::Create(brickBytes * _DirtyBricks.size(), BufferUsage::TransferSrc);
+	uint8* data = (uint8*)staging.getData();
+	//A fixed slot per brick and mip, the skipped ones have no size
+	std::vector<ImageRegion> regions(_DirtyBricks.size() * mipCount, ImageRegion{ 0, 0, 0, 0, 0, 0 });
+
+	Jobs::Context context;
+	Jobs::ParallelFor((uint32)_DirtyBricks.size(), [&](int index, int /*group*/) {
+		int32 slot = _DirtyBricks[index];
+		glm::ivec3 brick(slot % bricks.x, (slot / bricks.x) % bricks.y, slot / (bricks.x * bricks.y));
+		const uint8* cells = Grid.GetBrick(brick).Cells;
+		uint8* base = data + brickBytes * index;
+
+		//Tightly packed rows of the part of the brick inside the image
+		glm::ivec3 start = brick * VoxGrid::BrickSize;
+		glm::ivec3 size = glm::min(start + VoxGrid::BrickSize, imageSize) - start;
+		for (int32 z = 0; z < size.z; z++) {
+			for (int32 y = 0; y < size.y; y++) {
+				memcpy(base + (size_t)(y + z * size.y) * size.x, cells + VoxGrid::CellIndex(glm::ivec3(0, y, z)), size.x);
+			}
+		}
+		regions[index * mipCount] = ImageRegion{ start.x, start.y, start.z, (uint32)size.x, (uint32)size.y, (uint32)size.z, 0, 0, (int64_t)(brickBytes * index) };
+
+		//The same part of the levels
+		for (int32 mip = 1; mip < mipCount; mip++) {
+			const VoxGrid& lod = GetLod(mip);
+			uint8* dst = base + mipOffsets[mip];
+			start = start >> 1;
+			size = glm::min(start + (VoxGrid::BrickSize >> mip), lod.GetSize()) - start;
+			if (glm::any(glm::lessThanEqual(size, glm::ivec3(0))))break;
+
+			for (int32 z = 0; z < size.z; z++) {
+				for (int32 y = 0; y < size.y; y++) {
+					for (int32 x = 0; x < size.x; x++) {
+						dst[(size_t)x + (size_t)(y + z * size.y) * size.x] = lod.Get(start + glm::ivec3(x, y, z));
+					}
+				}
+			}
+			regions[index * mipCount + mip] = ImageRegion{ start.x, start.y, start.z, (uint32)size.x, (uint32)size.y, (uint32)size.z, (uint32)mip, 0, (int64_t)(brickBytes * index + mipOffsets[mip]) };
+		}
+	}, context);
+	Jobs::Complete(context);
+
+	regions.erase(std::remove_if(regions.begin(), regions.end(), [](const ImageRegion& r) { return r.width == 0; }), regions.end());
 
-	free(parentData);
+	Graphics::Transfer([&](CmdBuffer& cmd) {
+		cmd.barrier(_Image, ImageLayout::ShaderReadOptimal, ImageLayout::TransferDst, 0, mipCount);
+		cmd.copy(staging, _Image, regions);
+		cmd.barrier(_Image, ImageLayout::TransferDst, ImageLayout::ShaderReadOptimal, 0, mipCount);
+	});
 }
@@ -2,20 +2,64 @@
 
 #include "Assets.h"
 #include "Graphics/Graphics.h"
+#include "Physics/VoxOccupancy.h"
+#include "Physics/RigidBody.h"
+#include "Vox/VoxGrid.h"
+#include "Vox/VoxSurface.h"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 class VoxAsset : public Asset {
 	ASSET(VoxAsset, v)
 
+	// Legacy files start with SizeX, that is never 0, followed by the raw grid
+	// the compressed ones start with 0 and the version, from LodVersion the LOD chain follows the grid
+	inline static constexpr uint32 CompressedVersion = 1;
+	inline static constexpr uint32 LodVersion = 2;
+
 	//Serialized data
 	uint32 SizeX;
 	uint32 SizeY;
 	uint32 SizeZ;
-	std::vector<uint8> Data;
+	VoxGrid Grid;
+	std::vector<VoxGrid> Lods; // Levels 1 to LodCount - 1
 
 	//Runtime Data
 	Image _Image;
+	VoxOccupancy _Occupancy;
+	MassProperties _MassProperties;
+	// Never changed once built, the ShadowVoxSystem keeps the one it wrote to remove it later
+	std::shared_ptr<const VoxSurface> _Surface{ std::make_shared<VoxSurface>() };
+
+	// Bricks of the grid edited since the last ApplyEdits and their voxel bounds
+	std::vector<int32> _DirtyBricks;
+	std::vector<uint8> _DirtyFlags;
+	glm::ivec3 _DirtyMin{ INT32_MAX };
+	glm::ivec3 _DirtyMax{ INT32_MIN };
+
+	// Bounds changed by the last revisions, the ShadowVoxSystem only rewrites them
+	struct EditRecord {
+		uint32 Revision;
+		glm::ivec3 Min;
+		glm::ivec3 Max;
+	};
+	inline static constexpr size_t MaxEditHistory = 32;
+	std::vector<EditRecord> _EditHistory;
+	uint32 _Revision{ 0 };
+	inline static std::atomic<uint32> _EditCount{ 0 };
+
+	void MarkDirty(const glm::ivec3& min, const glm::ivec3& max);
+	void ClearDirty();
+	// Reduces again the voxels of the levels over the grid voxels from min to max
+	void UpdateLods(const glm::ivec3& min, const glm::ivec3& max);
+	// Uploads the dirty bricks with their mips, only when every mip of a brick is inside the brick
+	void UploadBricks();
+	// Copies the grid and the levels of the assets to their images in one transfer
+	static void UploadLevels(const std::vector<VoxAsset*>& assets);
+	// The image of the grid with a mip per level, none when headless
+	void CreateImage();
 
 	void NormalizeSize() {
 
@@ -23,40 +67,87 @@ class VoxAsset : public Asset {
 
 public:
 	VoxAsset(){}
-	VoxAsset(int32 InSizeX, int32 InSizeY, int32 InSizeZ) : SizeX(InSizeX), SizeY(InSizeY), SizeZ(InSizeZ) {
-		SizeX = ((SizeX - 1) & (~0b11)) + 4;
-		SizeY = ((SizeY - 1) & (~0b11)) + 4;
-		SizeZ = ((SizeZ - 1) & (~0b11)) + 4;
-
-		Data.resize(SizeX * SizeY * SizeZ);
-		_Image = Image::Create(Image::Info(Format::R8Uint, {SizeX, SizeY, SizeZ}).setMipCount(3).setFilter(Filter::Nearest));
-	}
-
+	VoxAsset(int32 InSizeX, int32 InSizeY, int32 InSizeZ) : VoxAsset(VoxGrid(AlignSize(glm::ivec3(InSizeX, InSizeY, InSizeZ)))) {}
+	// Takes the voxels of a grid with an aligned size, the LOD chain is built
+	explicit VoxAsset(VoxGrid&& grid);
+	// Takes the grid and its LOD chain built with BuildLods, it's built when empty
+	VoxAsset(VoxGrid&& grid, std::vector<VoxGrid>&& lods);
+
+	// The sizes of the assets are rounded up to multiples of 4
+	static glm::ivec3 AlignSize(const glm::ivec3& size) { return ((size - 1) & ~0b11) + 4; }
+
+	// Levels of the LOD chain with the grid, every one halves the size of the previous, they are the mips of the image
+	// the aligned sizes are divided exactly, so no voxel is lost
+	inline static constexpr int32 LodCount = 3;
+	// A level is used from LodDistance * level voxels of the asset away, the same as the shader
+	inline static constexpr float LodDistance = 1000.0f;
+
+	// Builds the levels 1 to LodCount - 1 of the grid
+	// a voxel is the most common value of its children not 0, so the color of the majority is kept
+	// it's set when any child is, so thin features (walls, poles) never disappear and the mips are conservative
+	// the bricks are reduced with Jobs::ParallelFor unless parallel is false, for the callers already in a job
+	static void BuildLods(const VoxGrid& grid, std::vector<VoxGrid>& lods, bool parallel = true);
+
+	// Voxels under it don't cast shadows (glass)
+	inline static constexpr uint8 ShadowMinValue = 16;
+
+	// Uploads the grid and its LOD chain to the GPU and rebuilds the CPU occupancy, mass and surface, the edits are applied too
+	// headless only rebuilds the CPU data
 	void Upload();
+	// The same as Upload on every asset, with one staging buffer and one transfer
+	static void Upload(const std::vector<VoxAsset*>& assets);
 
-	virtual void OnLoad() {
-		_Image = Image::Create(Image::Info(Format::R8Uint, { SizeX, SizeY, SizeZ }).setMipCount(3).setFilter(Filter::Nearest));
-		Upload();
-	}
+	virtual void OnLoad();
 
-	virtual void Serialize(Stream& S) {
-		S | SizeX | SizeY | SizeZ;
-		//TODO: Compress
-		if (S.IsLoading()) {
-			Data.resize(SizeX * SizeY * SizeZ);
-		}
+	// Saves in the VoxCodec format, loads it and the legacy raw grid
+	virtual void Serialize(Stream& S);
+	// Writes the file of an asset with the grid and its LOD chain, the same bytes as Serialize
+	static void Write(Stream& S, const VoxGrid& grid, const std::vector<VoxGrid>& lods);
 
-		S.Serialize(Data.data(), Data.size());
-	}
+	inline uint8 GetVoxel(int32 X, int32 Y, int32 Z) const { return Grid.Get(glm::ivec3(X, Y, Z)); }
 
-	inline uint8* PixelAt(int32 X, int32 Y, int32 Z) {
-		uint8* pos = Data.data() + ((size_t)X + ((size_t)Y * (size_t)SizeX) + ((size_t)Z * (size_t)SizeX * (size_t)SizeY));
-		//CHECK(pos >= Data.begin()._Ptr && pos < Data.end()._Ptr);
-		return pos;
+	// Edits, the bounds are inclusive voxels and are clamped to the grid
+	// they are seen after ApplyEdits
+	void SetVoxel(int32 X, int32 Y, int32 Z, uint8 Value) {
+		glm::ivec3 voxel(X, Y, Z);
+		Grid.Set(voxel, Value);
+		MarkDirty(voxel, voxel);
 	}
-
-
+	void FillBox(const glm::ivec3& min, const glm::ivec3& max, uint8 value);
+	void FillSphere(const glm::vec3& center, float radius, uint8 value);
+	// Only changes the voxels that are not empty
+	void PaintSphere(const glm::vec3& center, float radius, uint8 value);
+	// Grid of the size of the bounds with its voxels
+	VoxGrid CopyRegion(const glm::ivec3& min, const glm::ivec3& max) const;
+	// Writes region with its first voxel at position, the empty voxels are skipped unless replace
+	void PasteRegion(const VoxGrid& region, const glm::ivec3& position, bool replace = false);
+
+	// Rebuilds the CPU data and uploads only the edited bricks and their mips
+	void ApplyEdits();
+
+	// Incremented by every Upload and ApplyEdits
+	uint32 GetRevision() const { return _Revision; }
+	// Bounds changed after the revision, false when they are not known anymore and everything has to be treated as changed
+	bool GetEditedBounds(uint32 revision, glm::ivec3& min, glm::ivec3& max) const;
+	// Incremented by any asset Upload or ApplyEdits, to know when to look for new revisions
+	static uint32 GetEditCount() { return _EditCount.load(); }
+
+	const VoxGrid& GetGrid() const { return Grid; }
+	// Level 0 is the grid, the levels are updated by Upload and ApplyEdits
+	const VoxGrid& GetLod(int32 level) const { return level == 0 ? Grid : Lods[level - 1]; }
+	// Level of an instance at distance (world units) of the camera, voxelSize is the world size of its voxels
+	static int32 SelectLod(float distance, float voxelSize) {
+		int32 level = (int32)glm::ceil(distance / (voxelSize * LodDistance)) - 1;
+		return glm::clamp(level, 0, LodCount - 1);
+	}
+	// Not created when headless, use GetGrid for the size
 	Image& GetImage() { return _Image; }
+	const VoxOccupancy& GetOccupancy() const { return _Occupancy; }
+	// One unit of mass per solid voxel
+	const MassProperties& GetMassProperties() const { return _MassProperties; }
+	// Surface of the voxels that cast shadows, used by the ShadowVoxSystem
+	// replaced by every Upload and ApplyEdits
+	const std::shared_ptr<const VoxSurface>& GetShadowSurface() const { return _Surface; }
 
 
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <stdexcept>
 #include "IO/Log.h"
 
 /////////
@@ -76,11 +77,20 @@ using uint64 = uint64_t;
 
 #include <assert.h>
 
+// windows.h defines it, the same on MSVC
+#ifndef FORCEINLINE
+#ifdef _MSC_VER
+#define FORCEINLINE __forceinline
+#else
+#define FORCEINLINE inline __attribute__((always_inline))
+#endif
+#endif
+
 /////////////
 // Asserts //
 /////////////
 
 #define CHECK(expression) \
 if ((!(expression))) { \
-Log::critical("Check Error: {} Line: {}" , __FILE__, __LINE__); throw std::exception(__FILE__); \
+Log::critical("Check Error: {} Line: {}" , __FILE__, __LINE__); throw std::runtime_error(__FILE__); \
 } \
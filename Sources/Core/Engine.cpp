@@ -83,6 +83,26 @@ void Engine::Create()
 	Log::info("[Engine] Initialization Done!");
 }
 
+void Engine::CreateHeadless()
+{
+	Engine& e = Get();
+	e._headless = true;
+
+	Log::info("[Engine] Initializing headless...");
+
+	{
+		PreciseTimer t("[Engine] Init Systems");
+
+		//No Graphics, the assets only build their CPU data and the worlds are never rendered
+		Jobs::Initialize();
+		ModLoader::Initialize();
+	}
+
+	Get()._PostInitialize_Callbacks.ExecuteAll();
+
+	Log::info("[Engine] Initialization Done!");
+}
+
 void Engine::Run() {
 	Get().StartEngine();
 }
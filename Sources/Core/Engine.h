@@ -20,6 +20,7 @@ class Engine {
 	CallbackQueue<void> _OnBeforeUpdate_Callbacks;
 	LayerStack _layerStack;
 	float _lastTime;
+	bool _headless{ false };
 
 	void StartEngine();
 	void Update();
@@ -42,6 +43,9 @@ public:
 	}
 
 	static void Create();
+	// Without window and swapchain, only the systems to import and save assets (AssetCooker)
+	static void CreateHeadless();
+	static bool IsHeadless() { return Get()._headless; }
 
 	static void PushLayer(Ref<Layer> layer) { Get()._layerStack.PushLayer(layer); }
 	static void PopLayer(){}
@@ -8,6 +8,7 @@
 #include "Editor/Util/AutoAssetImporter.h"
 #include "Mod/ModLoader.h"
 #include "Profiler/Profiler.h"
+#include "World/Systems/ShadowVoxSystem.h"
 
 EditorLayer::EditorLayer() : Layer("Editor") {
 
@@ -18,6 +19,8 @@ EditorLayer::EditorLayer() : Layer("Editor") {
 	_Assets = RegisterWindow(new AssetsWindow());
 	_Hierarchy = RegisterWindow(new HierarchyWindow());
 	_Properties = RegisterWindow(new PropertiesWindow());
+
+	AutoAssetImporter::Start();
 	
 
 	//AssetImporter::Import("Mods/default/ModernHouse.vox", "default");
@@ -131,6 +134,11 @@ void EditorLayer::OnGui() {
 		ImGui::Text("fps: %f", 1.0f / ImGui::GetIO().DeltaTime);
 		ImGui::Text("benchmark: %f", totalTime / count);
 
+		if (Viewport != nullptr) {
+			const ShadowVoxSystem::UploadStats& stats = Viewport->GetWorld()->ShadowVox->GetUploadStats();
+			ImGui::Text("shadow bricks: %u regions: %u KB: %.1f", stats.Bricks, stats.Regions, stats.Bytes / 1024.0f);
+		}
+
 		if (Graphics::GetTimestamps().size() > 0) {
 			float scale = 0.00001f;
 			for (auto& ts : Graphics::GetTimestamps()) {
@@ -160,8 +168,6 @@ void EditorLayer::OnGui() {
 void EditorLayer::OnUpdate(float dt) {
 	PROFILE_FUNC();
 
-	AutoAssetImporter::CheckForImport();
-	
 	{
 		PROFILE_SCOPE("Update Viewports")
 		//Update Viewports
@@ -0,0 +1,217 @@
+#include "AssetCooker.h"
+
+#include "AssetImporter.h"
+#include "ContentIndex.h"
+#include "Core/Engine.h"
+#include "Job/Jobs.h"
+#include "Mod/Mod.h"
+
+#include <json11/json11.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+// A source as it was when cooked
+struct CookedSource {
+	uint64 Hash;
+	std::vector<std::pair<std::string, uint64>> Assets; // Path relative to Mod::MODS and hash of the created and reused assets
+};
+
+// A source found in the mods
+struct CookSource {
+	std::string Path; // Relative to Mod::MODS
+	uint64 Hash{ 0 };
+	bool Cooked{ false }; // The manifest has its hash and the assets are the same
+	std::vector<std::string> Created; // Assets written or reused by its import
+};
+
+// Assets created or reused by the import running, nullptr between imports
+static std::vector<std::string>* CreatedAssets = nullptr;
+
+// false when the file doesn't exist
+static bool HashFile(const std::filesystem::path& file, uint64& hash) {
+	std::error_code ec;
+	if (!std::filesystem::is_regular_file(file, ec))return false;
+
+	MappedFileReader reader(file.generic_string());
+	hash = ContentIndex::Hash(reader.GetData(), reader.GetSize());
+	return true;
+}
+
+static std::string ToHex(uint64 value) { return fmt::format("{:016X}", value); }
+static uint64 FromHex(const std::string& text) { return std::strtoull(text.c_str(), nullptr, 16); }
+
+static std::unordered_map<std::string, CookedSource> LoadManifest() {
+	std::unordered_map<std::string, CookedSource> manifest;
+
+	std::ifstream file(AssetCooker::MANIFEST);
+	if (!file.is_open())return manifest;
+	std::stringstream text;
+	text << file.rdbuf();
+
+	std::string error;
+	json11::Json json = json11::Json::parse(text.str(), error);
+	if (!error.empty()) {
+		Log::warn("[Cook] Ignoring invalid manifest {}: {}", AssetCooker::MANIFEST.generic_string(), error);
+		return manifest;
+	}
+	//Written by another version, everything is cooked again
+	if (json["Version"].int_value() != AssetCooker::Version)return manifest;
+
+	for (auto& [path, source] : json["Sources"].object_items()) {
+		CookedSource& cooked = manifest[path];
+		cooked.Hash = FromHex(source["Hash"].string_value());
+		for (auto& [asset, hash] : source["Assets"].object_items()) {
+			cooked.Assets.emplace_back(asset, FromHex(hash.string_value()));
+		}
+	}
+	return manifest;
+}
+
+static void SaveManifest(const std::unordered_map<std::string, CookedSource>& manifest) {
+	json11::Json::object sources;
+	for (auto& [path, cooked] : manifest) {
+		json11::Json::object assets;
+		for (auto& [asset, hash] : cooked.Assets) {
+			assets.emplace(asset, ToHex(hash));
+		}
+		sources.emplace(path, json11::Json::object{ { "Hash", ToHex(cooked.Hash) }, { "Assets", assets } });
+	}
+	json11::Json json = json11::Json::object{ { "Version", AssetCooker::Version }, { "Sources", sources } };
+
+	//Replaced at once, an interrupted cook keeps the previous manifest
+	std::filesystem::path temp = AssetCooker::MANIFEST;
+	temp += ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		file << json.dump();
+	}
+	std::error_code ec;
+	std::filesystem::rename(temp, AssetCooker::MANIFEST, ec);
+	if (ec)Log::error("[Cook] Failed to write the manifest {}: {}", AssetCooker::MANIFEST.generic_string(), ec.message());
+}
+
+bool AssetCooker::Cook(const std::vector<std::string>& mods) {
+	PreciseTimer t("[Cook] Cook");
+
+	std::vector<std::string> folders = mods;
+	if (folders.empty()) {
+		for (auto& entry : std::filesystem::directory_iterator(Mod::MODS)) {
+			if (entry.is_directory())folders.push_back(entry.path().lexically_relative(Mod::MODS).generic_string());
+		}
+	}
+
+	//Sorted, so the cooks of the same sources create the same assets
+	std::vector<CookSource> sources;
+	for (const std::string& folder : folders) {
+		std::error_code ec;
+		if (!std::filesystem::is_directory(Mod::MODS / folder, ec)) {
+			Log::error("[Cook] Mod {} not found in {}", folder, Mod::MODS.generic_string());
+			return false;
+		}
+		for (auto& entry : std::filesystem::recursive_directory_iterator(Mod::MODS / folder)) {
+			std::string file = entry.path().generic_string();
+			if (entry.is_regular_file() && AssetImporter::CanImport(file)) {
+				sources.push_back(CookSource{ entry.path().lexically_relative(Mod::MODS).generic_string(), 0, false, {} });
+			}
+		}
+	}
+	std::sort(sources.begin(), sources.end(), [](const CookSource& a, const CookSource& b) { return a.Path < b.Path; });
+
+	//The sources that didn't change and have all their assets are skipped
+	std::unordered_map<std::string, CookedSource> manifest = LoadManifest();
+	Jobs::Context context;
+	for (CookSource& source : sources) {
+		auto it = manifest.find(source.Path);
+		const CookedSource* cooked = it != manifest.end() ? &it->second : nullptr;
+		Jobs::Run([&source, cooked]() {
+			HashFile(Mod::MODS / source.Path, source.Hash);
+			if (cooked == nullptr || cooked->Hash != source.Hash)return;
+
+			for (auto& [asset, hash] : cooked->Assets) {
+				uint64 current;
+				if (!HashFile(Mod::MODS / asset, current) || current != hash)return;
+			}
+			source.Cooked = true;
+		}, context);
+	}
+	Jobs::Complete(context);
+
+	//The importers use every thread, so the sources are imported one at a time
+	static bool bound = false;
+	if (!bound) {
+		Engine::Bind_OnEvent([](Event& e) {
+			if (CreatedAssets == nullptr)return;
+			//A reused file is checked like a created one, the source is imported again when it changes
+			if (e.Is<AssetCreatedEvent>())CreatedAssets->push_back(e.As<AssetCreatedEvent>().path);
+			else if (e.Is<AssetReusedEvent>())CreatedAssets->push_back(e.As<AssetReusedEvent>().path);
+		});
+		bound = true;
+	}
+
+	int32 imported = 0;
+	int32 failed = 0;
+	for (CookSource& source : sources) {
+		if (source.Cooked)continue;
+
+		Log::info("[Cook] Importing {}", source.Path);
+		std::filesystem::path path = Mod::MODS / source.Path;
+		CreatedAssets = &source.Created;
+		bool succeeded = AssetImporter::Import(path.generic_string(), path.parent_path().lexically_relative(Mod::MODS).generic_string());
+		CreatedAssets = nullptr;
+
+		//Importers that fail create nothing, they are imported again by the next cook
+		if (!succeeded || source.Created.empty()) {
+			Log::error("[Cook] Failed to import {}", source.Path);
+			manifest.erase(source.Path);
+			failed++;
+			continue;
+		}
+		imported++;
+	}
+
+	//Hashed after every import, an asset can be written again by a later source
+	std::vector<std::pair<CookSource*, CookedSource>> results;
+	for (CookSource& source : sources) {
+		if (source.Cooked || source.Created.empty())continue;
+		CookedSource cooked{ source.Hash, {} };
+		//A file can be reused by several shapes
+		std::sort(source.Created.begin(), source.Created.end());
+		source.Created.erase(std::unique(source.Created.begin(), source.Created.end()), source.Created.end());
+		for (const std::string& asset : source.Created) {
+			cooked.Assets.emplace_back(asset, 0);
+		}
+		results.emplace_back(&source, std::move(cooked));
+	}
+	for (auto& [source, cooked] : results) {
+		for (auto& asset : cooked.Assets) {
+			Jobs::Run([&asset]() { HashFile(Mod::MODS / asset.first, asset.second); }, context);
+		}
+	}
+	Jobs::Complete(context);
+
+	//The sources deleted from the cooked mods are forgotten, the other mods are kept
+	std::unordered_set<std::string> found;
+	for (const CookSource& source : sources) {
+		found.insert(source.Path);
+	}
+	for (auto it = manifest.begin(); it != manifest.end();) {
+		std::string mod = it->first.substr(0, it->first.find_first_of('/'));
+		if (found.count(it->first) == 0 && std::find(folders.begin(), folders.end(), mod) != folders.end()) {
+			it = manifest.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+	for (auto& [source, cooked] : results) {
+		manifest[source->Path] = std::move(cooked);
+	}
+	SaveManifest(manifest);
+
+	Log::info("[Cook] {} sources, {} imported, {} up to date, {} failed", sources.size(), imported, sources.size() - imported - failed, failed);
+	return failed == 0;
+}
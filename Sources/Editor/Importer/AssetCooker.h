@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Imports every source of the mods (.vox, ...) without the editor, used by the --cook command line
+// A manifest keeps the hash of every source and of the assets it created or reused, a source is only imported again
+// when its bytes, or the bytes of one of its assets, changed or an asset is missing
+class AssetCooker {
+public:
+	inline static const std::filesystem::path MANIFEST = "Assets/CookManifest.json";
+	// Bump when an importer writes different assets for the same source, every source is imported again
+	inline static constexpr int32 Version = 1;
+
+	// Cooks the mods (folders of Mod::MODS), all of them when empty
+	// false when a source failed to import, the others are still cooked
+	static bool Cook(const std::vector<std::string>& mods);
+};
@@ -2,7 +2,7 @@
 
 #include "Core/Engine.h"
 #include "Asset/Assets.h"
-#include "IO/Stream.h"
+#include "IO/MappedFileReader.h"
 
 #include <unordered_map>
 #include <string>
@@ -56,7 +56,8 @@ public:
 	static bool Import(std::string file, std::string to) {
 		std::filesystem::path p = file;
 		std::string ext = p.extension().string().substr(1);
-		FileReader fr(file);
+		//Mapped, the importers can read the file in place
+		MappedFileReader fr(file);
 
 		if (Importers().find(ext) != Importers().end()) { //Must Use CanImport before using it
 			Importers().at(ext)(fr, p.stem().generic_string(), to);
@@ -0,0 +1,68 @@
+#include "ContentIndex.h"
+
+#include "IO/MappedFileReader.h"
+#include "Mod/Mod.h"
+
+#include <cstring>
+
+uint64 ContentIndex::Hash(const uint8* data, size_t size) {
+	//FNV-1a
+	uint64 hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ContentIndex::Matches(const std::string& path, const std::vector<uint8>& data) {
+	std::filesystem::path file = Mod::MODS / path;
+	std::error_code ec;
+	if (std::filesystem::file_size(file, ec) != data.size() || ec)return false;
+
+	MappedFileReader reader(file.generic_string());
+	return reader.GetSize() == data.size() && std::memcmp(reader.GetData(), data.data(), data.size()) == 0;
+}
+
+void ContentIndex::Scan(const std::string& folder, const std::string& extension) {
+	std::error_code ec;
+	std::filesystem::path root = Mod::MODS / folder;
+	if (!std::filesystem::is_directory(root, ec))return;
+
+	std::string ext = "." + extension;
+	for (auto& entry : std::filesystem::recursive_directory_iterator(root, ec)) {
+		if (!entry.is_regular_file(ec) || entry.path().extension() != ext)continue;
+
+		std::string path = entry.path().lexically_relative(Mod::MODS).generic_string();
+		uintmax_t size = entry.file_size(ec);
+		if (ec)continue;
+		std::filesystem::file_time_type time = entry.last_write_time(ec);
+		if (ec)continue;
+
+		auto it = _Files.find(path);
+		if (it == _Files.end() || it->second.Size != size || it->second.Time != time) {
+			MappedFileReader reader(entry.path().generic_string());
+			FileHash file{ Hash(reader.GetData(), reader.GetSize()), size, time };
+			it = _Files.insert_or_assign(path, file).first;
+		}
+		_Paths.emplace(it->second.Hash, path);
+	}
+}
+
+void ContentIndex::Add(const std::string& path, const std::vector<uint8>& data) {
+	std::error_code ec;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(Mod::MODS / path, ec);
+	if (ec)return;
+
+	uint64 hash = Hash(data.data(), data.size());
+	_Files.insert_or_assign(path, FileHash{ hash, data.size(), time });
+	_Paths.emplace(hash, path);
+}
+
+std::string ContentIndex::Find(const std::vector<uint8>& data, const std::function<bool(const std::string& path)>& skip) const {
+	auto range = _Paths.equal_range(Hash(data.data(), data.size()));
+	for (auto it = range.first; it != range.second; it++) {
+		if (skip && skip(it->second))continue;
+		if (Matches(it->second, data))return it->second;
+	}
+	return "";
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Finds the asset files of a folder with the same bytes as a new asset, so the importers reuse them instead of creating copies
+// The hashes are kept while the editor runs, a file is only hashed again when its size or write time changed
+class ContentIndex {
+	struct FileHash {
+		uint64 Hash;
+		uintmax_t Size;
+		std::filesystem::file_time_type Time;
+	};
+	// By path relative to Mod::MODS
+	inline static std::unordered_map<std::string, FileHash> _Files;
+
+	// Paths of the scanned files by hash
+	std::unordered_multimap<uint64, std::string> _Paths;
+
+public:
+	static uint64 Hash(const uint8* data, size_t size);
+	// True when the file, relative to Mod::MODS, has the bytes of data now
+	static bool Matches(const std::string& path, const std::vector<uint8>& data);
+
+	// Adds the files with the extension (without the dot) in the folder and its subfolders, the folder is relative to Mod::MODS
+	void Scan(const std::string& folder, const std::string& extension);
+	// Adds a file just written with the data
+	void Add(const std::string& path, const std::vector<uint8>& data);
+
+	// Path relative to Mod::MODS of a file with the same bytes, empty when there is none
+	// the bytes are compared, a file that changed after it was hashed is never returned, nor one skip returns true for
+	std::string Find(const std::vector<uint8>& data, const std::function<bool(const std::string& path)>& skip = nullptr) const;
+};
@@ -1,18 +1,23 @@
 #include "VoxImporter.h"
+#include "ContentIndex.h"
+#include "VoxParser.h"
 
+#include "Core/Engine.h"
 #include "IO/Log.h"
+#include "Job/Jobs.h"
 #include "Asset/PalleteAsset.h"
 #include "Asset/PrefabAsset.h"
 #include "World/Components.h"
 #include "World/World.h"
 
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <charconv>
 
 //TODO: The importer should create the .asset file
 
-inline static const bool _Debug = false;
 inline static const bool _Debug_Nodes_Creation = false;
 
 
@@ -83,16 +88,6 @@ struct VoxTransformMatrix {
 	}
 };
 
-class VoxNode { public: virtual ~VoxNode() {} };
-class VoxGroup : public VoxNode { public: std::vector<int> childrenIds; };
-class VoxTransform : public VoxNode { public: int x, y, z, childId; VoxTransformMatrix matrix; std::string name; };
-class VoxShape : public VoxNode { public: int shapeId; };
-
-struct VoxShapeData {
-	int sizeX, sizeY, sizeZ;
-	std::vector<uint32_t> voxels;
-};
-
 class VoxImportContext {
 public:
 	std::filesystem::path path;
@@ -100,324 +95,249 @@ public:
 
 	World* world;
 	AssetRefT<PalleteAsset> assetPallete;
+	VoxParser file;
 
-	std::string nodeName;
-	std::vector<std::shared_ptr<VoxNode>> nodes;
-	std::vector<std::shared_ptr<VoxShapeData>> shapesData;
-	struct VoxColor {
-		uint8 r, g, b, a;
-	};
-	struct VoxSurface {
-		uint8 e, r, m;//emit, roughness, metallic
-	};
-	VoxColor pallete[257];
-	VoxSurface surfaces[257];
-	uint8 remap[256];
-
-	int sizeX = 0, sizeY = 0, sizeZ = 0;
-
-	std::map<std::string, std::string> readDictionary(Stream& s) {
-		std::map<std::string, std::string> m;
-		int size = 0;
-		s | size;
-		if constexpr (_Debug)Log::debug("  Dictionary<>({})", size);
-		for (int i = 0; i < size; i++) {
-			std::string key;
-			std::string value;
-			s | key | value;
-			if constexpr (_Debug)Log::debug("      <{}, {}>", key, value);
-			m[key] = value;
-		}
-		return m;
-	}
+	// A model with a rotation, its asset is built once for all its references
+	struct Shape {
+		int32 model;
+		VoxTransformMatrix matrix;
+		std::string name; // Of the first reference, names the file
+		std::string path; // Of its file, unique in this import
 
-	void readRGBA(Stream& s) {
-		if constexpr (_Debug)Log::trace("RGBA");
-		s.Serialize(&pallete[1], 256 * 4);
-	}
+		VoxGrid grid;
+		std::vector<VoxGrid> lods;
+		std::vector<uint8> bytes; // Of the asset file
+		std::string existing;     // File of an earlier import with the same bytes
 
-	void readXYZI(Stream& s) {
-		int voxelCount;
-
-		s | voxelCount;
-		if constexpr (_Debug)Log::trace("XYZI ({})", voxelCount);
-
-		auto shapeData = std::make_shared<VoxShapeData>();
-		shapeData->voxels.resize(voxelCount);
+		AssetRefT<VoxAsset> asset;
+	};
+	// Shapes in the order they are found, so the assets and the prefab are the same with any thread count
+	std::vector<Shape> shapes;
+	std::map<std::pair<int, uint8>, int32> shapeIndices;
+	// Entities with a VoxRenderer and their shape
+	std::vector<std::pair<entt::entity, int32>> shapeEntities;
+
+	// Paths of the shapes files, the files this import may write
+	std::unordered_set<std::string> shapePaths;
+
+	// Asset files this source wrote before, the ones with the same bytes are reused
+	ContentIndex voxFiles;
+	ContentIndex palleteFiles;
+};
 
-		s.Serialize(shapeData->voxels.data(), shapeData->voxels.size() * sizeof(uint32_t));
+// Reads the number at the start of str skipping the spaces, str is moved past it
+static int ReadInt(std::string_view& str) {
+	while (!str.empty() && str.front() == ' ')str.remove_prefix(1);
+	int value = 0;
+	const char* end = std::from_chars(str.data(), str.data() + str.size(), value).ptr;
+	str.remove_prefix(end - str.data());
+	return value;
+}
 
-		shapeData->sizeX = sizeX;
-		shapeData->sizeY = sizeY;
-		shapeData->sizeZ = sizeZ;
+static float ReadFloat(std::string_view str) {
+	float value = 0.0f;
+	std::from_chars(str.data(), str.data() + str.size(), value);
+	return value;
+}
 
-		shapesData.push_back(shapeData);
+static void ReadMaterial(const VoxParser::Dictionary& properties, VoxMaterial& mat) {
+	float rough = 0.0f;
+	float emit = 0.0f;
+	float metal = 0.0f;
 
+	std::string_view type = properties.Find("_type");
+	if (type == "_metal" || type == "_blend") {
+		rough = ReadFloat(properties.Find("_rough"));
+		metal = ReadFloat(properties.Find("_metal"));
 	}
-
-	void readMATL(Stream& s) {
-		int materialId;
-		s | materialId;//materialId
-
-		if constexpr (_Debug)Log::trace("MATL {}", materialId);
-
-		auto properties = readDictionary(s);//materialProperties
-
-		float rough = 0.0f;
-		float emit = 0.0f;
-		float metal = 0.0f;
-
-		std::string type = properties["_type"];
-
-		if (type == "_metal" || type == "_blend") {
-			if (properties.find("_rough") != properties.end()) {
-				auto& prop = properties["_rough"];
-				std::from_chars(prop.data(), prop.data() + prop.size(), rough);
-			}
-			if (properties.find("_metal") != properties.end()) {
-				auto& prop = properties["_metal"];
-				std::from_chars(prop.data(), prop.data() + prop.size(), metal);
-			}
-
-		}
-		else if (type == "_emit") {
-			if (properties.find("_emit") != properties.end()) {
-				auto& prop = properties["_emit"];
-				std::from_chars(prop.data(), prop.data() + prop.size(), emit);
-			}
-		}
-		//_type == _diffuse have the default value of _rough to 0.1 which is strange so just put 0.9
-		else if (type == "_diffuse") {
-			rough = 0.9f;
-		}
-
-		surfaces[materialId].e = emit * 255.0f;
-		surfaces[materialId].r = rough * 255.0f;
-		surfaces[materialId].m = metal * 255.0f;
+	else if (type == "_emit") {
+		emit = ReadFloat(properties.Find("_emit"));
 	}
-
-	void readIMAP(Stream& s) {
-		s.Serialize(remap, 256);
+	//_type == _diffuse have the default value of _rough to 0.1 which is strange so just put 0.9
+	else if (type == "_diffuse") {
+		rough = 0.9f;
 	}
 
-	void readnTRN(Stream& s) {
-		if constexpr (_Debug)Log::trace("nTRN");
-		int tempInt;
-
-		std::shared_ptr<VoxTransform> transform = std::make_shared<VoxTransform>();
-
-		transform->name = nodeName;
-
-		s | transform->childId; //childNodeId
-		s | tempInt; //reservedId
-		s | tempInt; //layerId
-		s | tempInt; //numOfFrame
-
-		auto map = readDictionary(s);
-
-		int beginT = 0;
-		int endT = 0;
-		auto str = map["_t"];
-
-		int x, y, z;
-		x = y = z = 0;
-		{//Read _t = Translation
-			if (!str.empty()) {
-				endT = str.find(' ', beginT + 1) + 1;
-				std::from_chars(str.data() + beginT, str.data() + endT, x);
-				beginT = endT;
-				endT = str.find(' ', beginT + 1) + 1;
-				std::from_chars(str.data() + beginT, str.data() + endT, y);
-				beginT = endT;
-				endT = str.size();
-				std::from_chars(str.data() + beginT, str.data() + endT, z);
-				transform->x = x;
-				transform->y = y;
-				transform->z = z;
-			}
-		}
-
-		int _r = 0b0100;
-		{//Read _r = Rotation
-			str = map["_r"];
+	mat.emit = emit * 255.0f;
+	mat.roughness = rough * 255.0f;
+	mat.metallic = metal * 255.0f;
+}
 
-			if (!str.empty()) {
-				std::from_chars(str.data(), str.data() + str.size(), _r);
-			}
-		}
+// The file is referenced by the import instead of a new one
+static void Reuse(const std::string& path) {
+	AssetReusedEvent e;
+	e.path = path;
+	Engine::Get().DispatchEvent(e);
+}
 
-		transform->matrix = VoxTransformMatrix(static_cast<uint8>(_r));
+static int TEMP_counter = 0;
+// Transforms of groups inside groups, deeper ones are ignored so a corrupted file never recurses forever
+inline static const int32 MaxNodeDepth = 256;
+
+// Centers e on the model, its VoxRenderer is added when the shapes are built
+static void CreateShape(VoxImportContext& ctx, entt::entity e, Transform t, int32 modelId, VoxTransformMatrix matrix, std::string shapeName) {
+	const VoxParser::Model& model = ctx.file.GetModels()[modelId];
+	if constexpr (_Debug_Nodes_Creation)Log::debug("Shape()");
+
+	glm::ivec3 size = model.Size;
+	glm::ivec3 tSize = matrix.transformSize(size);//Transformed Size
+
+	{//Offset center 
+		glm::ivec3 center = glm::ivec3(
+			matrix._sx ? tSize.x - tSize.x / 2 : tSize.x / 2,
+			matrix._sz ? tSize.z - tSize.z / 2 : tSize.z / 2,
+			!matrix._sy ? tSize.y - tSize.y / 2 : tSize.y / 2//Flip-Z-Axis
+		);
 
-		nodes.push_back(transform);
+		t.Position -= glm::vec3(center) * 0.1f;
 	}
 
-	void readnGRP(Stream& s) {
-		if constexpr (_Debug)Log::trace("nGRP");
-
-		auto group = std::make_shared<VoxGroup>();
 
-		int size;
+	ctx.world->GetRegistry().emplace<Transform>(e, t);
 
-		s | size;
-		group->childrenIds.resize(size);
-		for (int i = 0; i < size; i++) { s | group->childrenIds[i]; }
+	if (shapeName.empty())shapeName = fmt::format("{}", TEMP_counter++);
+	ctx.world->SetName(e, shapeName);
 
-		nodes.push_back(group);
+	//The references to a model with the same rotation share the asset
+	std::pair<int, uint8> key(modelId, matrix._r);
+	auto found = ctx.shapeIndices.find(key);
+	if (found == ctx.shapeIndices.end()) {
+		found = ctx.shapeIndices.emplace(key, (int32)ctx.shapes.size()).first;
+		VoxImportContext::Shape& shape = ctx.shapes.emplace_back();
+		shape.model = modelId;
+		shape.matrix = matrix;
+		shape.name = shapeName;
 	}
+	ctx.shapeEntities.emplace_back(e, found->second);
+}
 
-	void readnSHP(Stream& s) {
-		if constexpr (_Debug)Log::trace("nSHP");
-
-		auto shape = std::make_shared<VoxShape>();
-		int tempInt;
-
-		s | tempInt;//numOfChildren is always 1
-		s | shape->shapeId;//childId
-
-		nodes.push_back(shape);
+// Fills the grid of the shape, builds its LOD chain and encodes its file, can run in the Jobs threads
+static void BuildShape(const VoxImportContext& ctx, VoxImportContext::Shape& shape) {
+	const VoxParser::Model& model = ctx.file.GetModels()[shape.model];
+	glm::ivec3 size = model.Size;
+	glm::ivec3 tSize = shape.matrix.transformSize(size);
 
-		readDictionary(s);//reserved (not used)
+	shape.grid.Resize(VoxAsset::AlignSize(glm::ivec3(tSize.x, tSize.z, tSize.y)));
+	for (int32 i = 0; i < model.VoxelCount; i++) {
+		//x, y, z and the color index
+		const uint8* voxel = model.Voxels + (size_t)i * 4;
 
+		glm::ivec3 coords = shape.matrix.transform(glm::ivec3(voxel[0], voxel[1], voxel[2]), size);
+		shape.grid.Set(glm::ivec3(coords.x, coords.z, tSize.y - 1 - coords.y), voxel[3]);//Flip-Z-Axis
 	}
 
+	//The LOD chain is built here, so loading the asset doesn't reduce anything
+	//serially, the shapes already are built in parallel
+	VoxAsset::BuildLods(shape.grid, shape.lods, false);
 
-	bool Import(Stream& s) {
-		if constexpr (_Debug)Log::trace("Importing a vox file!");
-
-		//VOX Header
-		char VOX_[4];
-		s.Serialize(VOX_, sizeof(VOX_));
-
-		if (std::memcmp(VOX_, "VOX ", 4)) { Log::warn("Trying to load an invalid vox file! {}", s.GetIdentifier()); return false; }
-
-		//Version
-		int version = 0;
-		s | version;
-
-		int tempInt;
-
-		std::string str;
-		std::map<std::string, std::string> map;
-		int x, y, z;
-		int beginT = 0, endT = 0;
-
-		std::map<std::string, std::string> nodeDict;
-
-		bool running = true;
-		while (running) {
-			char Header[4];
-			Header[0] = Header[1] = Header[2] = Header[3] = ' ';
-			s.Serialize(Header, sizeof(Header));
-
-			int chunkContentSize = 0;
-			int childrenChunkContentSize = 0;
-			s | chunkContentSize;
-			s | childrenChunkContentSize;
-
-			//if constexpr (_Debug)Log::debug("Chunk Size {} Children Size {}", chunkContentSize, childrenChunkContentSize);
-
-			int nodeId = -1;
-			int size = 0;
-
-			switch (Header[0]) {
-			case 'M': //MAIN
-				switch (Header[2]) {
-				case 'I':
-					if constexpr (_Debug)Log::trace("MAIN");
-					break;
-				case 'T':
-					readMATL(s);
-					break;
-				}
-
-				break;
-
-			case 'P': //PACK
-				s | tempInt;
-				if constexpr (_Debug)Log::trace("PACK {}", tempInt);
-				break;
-
-			case 'S': //SIZE
-				s | sizeX | sizeY | sizeZ;
-				if constexpr (_Debug)Log::trace("SIZE {} {} {}", sizeX, sizeY, sizeZ);
-				break;
-
-			case 'X': //XYZI (Blocks)
-				readXYZI(s);
-				break;
-
-			case 'R': //RGBA (Pallete)
-				readRGBA(s);
-				break;
-
-			case 'L': //LAYR (Layer)
-				if constexpr (_Debug)Log::trace("LAYR");
-				s | tempInt;//layerId
-				readDictionary(s);//layerAttributes
-				s | tempInt;//Reserved
-				break;
+	BufferWriter writer(shape.bytes);
+	VoxAsset::Write(writer, shape.grid, shape.lods);
 
-			case 'I': //IMAP (Vox Index Remap)
-				if constexpr (_Debug)Log::trace("IMAP");
-				readIMAP(s);
-				break;
+	//A file with the same voxels from an earlier import of this source
+	//the files of the other shapes are skipped, this import can write them
+	shape.existing = ctx.voxFiles.Find(shape.bytes, [&](const std::string& path) { return path != shape.path && ctx.shapePaths.count(path) > 0; });
+}
 
-			case 'r': //rOBJ
-				if constexpr (_Debug)Log::trace("rOBJ");
-				readDictionary(s);//objectAttributes
-				break;
+// Staged voxels uploaded at once
+inline static const size_t UploadBatchBytes = 64 << 20;
+
+// Builds the shapes in parallel and creates their assets in order, the shapes with the same voxels share one
+static void CreateShapeAssets(VoxImportContext& ctx) {
+	//Shapes with the same name get a number, so no file of this import is overwritten
+	std::unordered_set<std::string> names;
+	for (VoxImportContext::Shape& shape : ctx.shapes) {
+		std::string name = shape.name;
+		for (int32 n = 1; !names.insert(name).second; n++) {
+			name = fmt::format("{}_{}", shape.name, n);
+		}
+		shape.path = (ctx.path / ctx.fileName / name).replace_extension("v").generic_string();
+		ctx.shapePaths.insert(shape.path);
+	}
 
-			case 'n': //n (Node)
-				s | nodeId;
-				nodeDict = readDictionary(s); //nodeAttributes
-				nodeName = nodeDict.find("_name") != nodeDict.end() ? nodeDict["_name"] : "";
-				switch (Header[1]) {
-				case('T'): //nTRN
-					readnTRN(s);
-					break;
-				case('G'): //nGRP (Group of Nodes)
-					readnGRP(s);
-					break;
-				case('S'): //nSHP (Connect a Node to a Shape)
-					readnSHP(s);
-					break;
-				}
-				break;
-			default:
-				running = false;
-				//Log::info("Finish {}{}{}{}", Header[0], Header[1], Header[2], Header[3]);
+	Jobs::Context context;
+	for (VoxImportContext::Shape& shape : ctx.shapes) {
+		Jobs::Run([&ctx, &shape]() { BuildShape(ctx, shape); }, context);
+	}
+	Jobs::Complete(context);
+
+	std::unordered_map<uint64, std::vector<int32>> created; // Shapes with new assets by the hash of their bytes
+	std::unordered_set<std::string> written;
+	std::vector<VoxAsset*> batch;
+	size_t batchBytes = 0;
+	for (int32 index = 0; index < (int32)ctx.shapes.size(); index++) {
+		VoxImportContext::Shape& shape = ctx.shapes[index];
+
+		//The same voxels as another shape of this import
+		std::vector<int32>& sameHash = created[ContentIndex::Hash(shape.bytes.data(), shape.bytes.size())];
+		for (int32 other : sameHash) {
+			if (ctx.shapes[other].bytes == shape.bytes) {
+				shape.asset = ctx.shapes[other].asset;
 				break;
 			}
+		}
+		if (shape.asset.IsValid())continue;
+
+		//Found while the shapes were built, the file is compared again as it can have been written since
+		bool reuse = !shape.existing.empty() && written.count(shape.existing) == 0 && ContentIndex::Matches(shape.existing, shape.bytes);
+		AssetRef existing = reuse ? Assets::Load(shape.existing) : AssetRef();
+		if (existing.IsValid()) {
+			shape.asset = AssetRefT<VoxAsset>(existing);
+			Reuse(shape.existing);
+			continue;
+		}
 
+		glm::ivec3 size = shape.grid.GetSize();
+		VoxAsset* asset = new VoxAsset(std::move(shape.grid), std::move(shape.lods));
+		shape.asset = asset;
+		Assets::CreateAsset(shape.asset, shape.path, shape.bytes);
+		ctx.voxFiles.Add(shape.path, shape.bytes);
+		written.insert(shape.path);
+		sameHash.push_back(index);
+
+		batch.push_back(asset);
+		batchBytes += (size_t)size.x * size.y * size.z;
+		if (batchBytes >= UploadBatchBytes) {
+			VoxAsset::Upload(batch);
+			batch.clear();
+			batchBytes = 0;
 		}
-		return true;
 	}
-};
+	VoxAsset::Upload(batch);
+}
 
-static int TEMP_counter = 0;
-static entt::entity CreateEntity(VoxImportContext& ctx, std::shared_ptr<VoxTransform> root) {
-	std::shared_ptr<VoxNode> node = ctx.nodes[root->childId];
+static entt::entity CreateEntity(VoxImportContext& ctx, const VoxParser::Node& root, int32 depth) {
+	const VoxParser::Node* node = ctx.file.GetNode(root.Child);
+	bool isGroup = node != nullptr && node->Type == VoxParser::NodeType::Group;
+	bool isShape = node != nullptr && node->Type == VoxParser::NodeType::Shape && node->Model >= 0 && node->Model < (int32)ctx.file.GetModels().size();
+	if ((!isGroup && !isShape) || depth > MaxNodeDepth)return entt::null;
 	if constexpr (_Debug_Nodes_Creation)Log::debug("Transform(");
 
 	//Create Entity
 	entt::entity e = ctx.world->Create();
 
 	//Add Transform Component
+	std::string_view translation = root.Frame.Find("_t");
+	int x = ReadInt(translation);
+	int y = ReadInt(translation);
+	int z = ReadInt(translation);
 	Transform t{};
-	t.Position = glm::vec3(root->x, root->z, -root->y) * 0.1f;//Flip-Z-Axis
+	t.Position = glm::vec3(x, z, -y) * 0.1f;//Flip-Z-Axis
+
+	std::string_view rotation = root.Frame.Find("_r");
+	VoxTransformMatrix matrix = rotation.empty() ? VoxTransformMatrix() : VoxTransformMatrix(static_cast<uint8>(ReadInt(rotation)));
 
 	//Group
-	std::shared_ptr<VoxGroup> group = std::dynamic_pointer_cast<VoxGroup>(node);
-	if (group.get() != nullptr) {
+	if (isGroup) {
 		//emplace parent Transform Component
 		ctx.world->GetRegistry().emplace<Transform>(e, t);
 
-		if constexpr (_Debug_Nodes_Creation)Log::debug("Group[{}](", group->childrenIds.size());
-		for (int childId : group->childrenIds) {
-			std::shared_ptr<VoxTransform> childTransformNode = std::dynamic_pointer_cast<VoxTransform>(ctx.nodes[childId]);
+		if constexpr (_Debug_Nodes_Creation)Log::debug("Group[{}](", node->ChildCount);
+		for (int32 i = 0; i < node->ChildCount; i++) {
+			const VoxParser::Node* childTransformNode = ctx.file.GetNode(node->GetChild(i));
+			if (childTransformNode == nullptr || childTransformNode->Type != VoxParser::NodeType::Transform)continue;
 
-			entt::entity child = CreateEntity(ctx, childTransformNode);
-			ctx.world->SetParent(child, e);
+			entt::entity child = CreateEntity(ctx, *childTransformNode, depth + 1);
+			if (child != entt::null)ctx.world->SetParent(child, e);
 		}
 		if constexpr (_Debug_Nodes_Creation)Log::debug(")");
 
@@ -425,83 +345,71 @@ static entt::entity CreateEntity(VoxImportContext& ctx, std::shared_ptr<VoxTrans
 	}
 
 	//Shape
-	std::shared_ptr<VoxShape> shape = std::dynamic_pointer_cast<VoxShape>(node);
-	if (shape != nullptr) {
-		std::shared_ptr<VoxShapeData> shapeData = ctx.shapesData[shape->shapeId];
-		if constexpr (_Debug_Nodes_Creation)Log::debug("Shape()");
-
-
-
-		glm::ivec3 size = glm::ivec3(shapeData->sizeX, shapeData->sizeY, shapeData->sizeZ);
-		glm::ivec3 tSize = root->matrix.transformSize(size);//Transformed Size
-
-		AssetRefT<VoxAsset> vox = new VoxAsset(tSize.x, tSize.z, tSize.y);
-
-		{//Offset center 
-			glm::ivec3 center = glm::ivec3(
-				root->matrix._sx ? tSize.x - tSize.x / 2 : tSize.x / 2,
-				root->matrix._sz ? tSize.z - tSize.z / 2 : tSize.z / 2,
-				!root->matrix._sy ? tSize.y - tSize.y / 2 : tSize.y / 2//Flip-Z-Axis
-			);
-
-			t.Position -= glm::vec3(center) * 0.1f;
-		}
-
-
-		ctx.world->GetRegistry().emplace<Transform>(e, t);
-
-		for (uint32 data : shapeData->voxels) {
-			uint8 x = (data & 0x000000FF) >> (0 * 8);
-			uint8 y = (data & 0x0000FF00) >> (1 * 8);
-			uint8 z = (data & 0x00FF0000) >> (2 * 8);
-			uint8 v = (data & 0xFF000000) >> (3 * 8);
-
-			glm::ivec3 coords = root->matrix.transform(glm::ivec3(x, y, z), size);
-			*vox->PixelAt(coords.x, coords.z, tSize.y - 1 - coords.y) = v;//Flip-Z-Axis
-		}
-		vox->Upload();
-
-		std::string shapeName = root->name.empty() ? fmt::format("{}", TEMP_counter++) : root->name;
-		ctx.world->SetName(e, shapeName);
-		Assets::CreateAsset(vox, (ctx.path / ctx.fileName / shapeName).replace_extension("v").generic_string());
-
-		//Add VoxRenderer Component
-		VoxRenderer vr;
-		vr.Pallete = ctx.assetPallete;
-		vr.Vox = vox;
-		ctx.world->GetRegistry().emplace<VoxRenderer>(e, vr);
-
-		return e;
-	}
-
+	CreateShape(ctx, e, t, node->Model, matrix, std::string(root.Attributes.Find("_name")));
 	if constexpr (_Debug_Nodes_Creation)Log::debug(")");
 
-	return entt::null;
+	return e;
 }
 
 void VoxImporter::Import(Stream& s) {
 	TEMP_counter = 0;
 
-	//Serialize ctx
+	//The file is parsed in place when the stream is mapped
+	std::vector<uint8> bytes;
+	size_t size = s.GetSize();
+	const uint8* data = s.ReadView(size);
+	if (data == nullptr) {
+		bytes.resize(size);
+		s.Serialize(bytes.data(), size);
+		data = bytes.data();
+	}
+
 	VoxImportContext ctx;
-	ctx.Import(s);
+	if (!ctx.file.Parse(data, size, s.GetIdentifier()))return;
 
 	//Create World
 	Unique<World> W = NewUnique<World>();
 
+	//Only the files of earlier imports of this source are reused, the other files of the mod can be edited on their own
+	std::string folder = (_Path / _FileName).generic_string();
+	ctx.voxFiles.Scan(folder, "v");
+	ctx.palleteFiles.Scan(folder, "p");
+
 	//Create Pallete
 	AssetRefT<PalleteAsset> newPallete = new PalleteAsset();
+	const uint8* colors = ctx.file.GetPalette();
 	for (int i = 0; i < 256; i++) {
 		VoxMaterial& Mat = newPallete->MaterialAt(i);
-		Mat.r = ctx.pallete[i].r;
-		Mat.g = ctx.pallete[i].g;
-		Mat.b = ctx.pallete[i].b;
-		Mat.emit = ctx.surfaces[i].e;
-		Mat.roughness = ctx.surfaces[i].r;
-		Mat.metallic = ctx.surfaces[i].m;
+		//The color index i is at i - 1, 0 is empty
+		const uint8* color = colors != nullptr && i > 0 ? colors + (i - 1) * 4 : nullptr;
+		Mat.r = color != nullptr ? color[0] : 0;
+		Mat.g = color != nullptr ? color[1] : 0;
+		Mat.b = color != nullptr ? color[2] : 0;
+		Mat.a = color != nullptr ? color[3] : 0;
+		Mat.emit = 0;
+		Mat.roughness = 0;
+		Mat.metallic = 0;
+	}
+	for (const VoxParser::Material& material : ctx.file.GetMaterials()) {
+		if (material.Id >= 0 && material.Id < 256)ReadMaterial(material.Properties, newPallete->MaterialAt(material.Id));
+	}
+
+	std::vector<uint8> palleteFile;
+	BufferWriter palleteWriter(palleteFile);
+	newPallete->Serialize(palleteWriter);
+
+	std::string palletePath = ctx.palleteFiles.Find(palleteFile);
+	AssetRef existingPallete = palletePath.empty() ? AssetRef() : Assets::Load(palletePath);
+	if (existingPallete.IsValid()) {
+		newPallete = AssetRefT<PalleteAsset>(existingPallete);
+		Reuse(palletePath);
+	}
+	else {
+		newPallete->Upload();
+		palletePath = (_Path / _FileName / _FileName).replace_extension("p").generic_string();
+		Assets::CreateAsset(newPallete, palletePath);
+		ctx.palleteFiles.Add(palletePath, palleteFile);
 	}
-	newPallete->Upload();
-	Assets::CreateAsset(newPallete, (_Path / _FileName / _FileName).replace_extension("p").generic_string());
 	
 	ctx.world = W.get();
 	ctx.assetPallete = newPallete;
@@ -509,10 +417,29 @@ void VoxImporter::Import(Stream& s) {
 	ctx.fileName = _FileName;
 
 	//Create entities
-	std::shared_ptr<VoxTransform> rootTransform = std::dynamic_pointer_cast<VoxTransform>(ctx.nodes[0]);
-	entt::entity root = CreateEntity(ctx, rootTransform);
+	const VoxParser::Node* rootTransform = ctx.file.GetNode(0);
+	entt::entity root = rootTransform != nullptr && rootTransform->Type == VoxParser::NodeType::Transform ? CreateEntity(ctx, *rootTransform, 0) : entt::null;
+	//The files without a scene graph have every model at the origin
+	if (root == entt::null) {
+		root = W->Create();
+		W->GetRegistry().emplace<Transform>(root, Transform{});
+		for (int32 model = 0; model < (int32)ctx.file.GetModels().size(); model++) {
+			entt::entity e = W->Create();
+			CreateShape(ctx, e, Transform{}, model, VoxTransformMatrix(), "");
+			W->SetParent(e, root);
+		}
+	}
 	W->SetName(root, _FileName.generic_string());
 
+	CreateShapeAssets(ctx);
+	for (auto& [e, shape] : ctx.shapeEntities) {
+		//Add VoxRenderer Component
+		VoxRenderer vr;
+		vr.Pallete = ctx.assetPallete;
+		vr.Vox = ctx.shapes[shape].asset;
+		W->GetRegistry().emplace<VoxRenderer>(e, vr);
+	}
+
 	//Create Prefab
 	AssetRefT<PrefabAsset> prefab = new PrefabAsset();
 	prefab->FromWorld(W.get(), root);
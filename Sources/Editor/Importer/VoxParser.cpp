@@ -0,0 +1,230 @@
+#include "VoxParser.h"
+
+#include "IO/Log.h"
+
+// Bounds checked reads, once one fails every other fails too
+struct VoxParser::Reader {
+	const uint8* Data;
+	const uint8* End;
+	bool Failed{ false };
+
+	bool Has(size_t size) {
+		if (!Failed && (size_t)(End - Data) >= size)return true;
+		Failed = true;
+		return false;
+	}
+	int32 Int() {
+		int32 value = 0;
+		if (Has(sizeof(int32))) {
+			memcpy(&value, Data, sizeof(int32));
+			Data += sizeof(int32);
+		}
+		return value;
+	}
+	// Skips the bytes and returns where they start, nullptr when there are not enough
+	const uint8* Skip(size_t size) {
+		if (!Has(size))return nullptr;
+		const uint8* start = Data;
+		Data += size;
+		return start;
+	}
+	// Skips count items of size bytes, count is read from the file
+	const uint8* SkipArray(int32 count, size_t size) {
+		if (count < 0 || !Has(0) || (size_t)count > (size_t)(End - Data) / size) {
+			Failed = true;
+			return nullptr;
+		}
+		return Skip((size_t)count * size);
+	}
+};
+
+static constexpr uint32 ChunkId(const char(&id)[5]) {
+	return (uint32)id[0] | ((uint32)id[1] << 8) | ((uint32)id[2] << 16) | ((uint32)id[3] << 24);
+}
+
+std::string_view VoxParser::Dictionary::Find(std::string_view key) const {
+	const uint8* data = _Data;
+	for (int32 i = 0; i < _Count; i++) {
+		int32 size;
+		memcpy(&size, data, sizeof(int32));
+		std::string_view pairKey((const char*)data + sizeof(int32), size);
+		data += sizeof(int32) + size;
+
+		memcpy(&size, data, sizeof(int32));
+		std::string_view value((const char*)data + sizeof(int32), size);
+		data += sizeof(int32) + size;
+
+		if (pairKey == key)return value;
+	}
+	return {};
+}
+
+bool VoxParser::ReadDictionary(Reader& reader, Dictionary& dictionary) {
+	int32 count = reader.Int();
+	const uint8* data = reader.Data;
+	for (int32 i = 0; i < count && !reader.Failed; i++) {
+		reader.SkipArray(reader.Int(), 1);//Key
+		reader.SkipArray(reader.Int(), 1);//Value
+	}
+	if (count < 0 || reader.Failed) {
+		reader.Failed = true;
+		return false;
+	}
+	dictionary._Data = data;
+	dictionary._Count = count;
+	return true;
+}
+
+VoxParser::Node* VoxParser::AddNode(Reader& reader, NodeType type) {
+	//The ids come from the file, they take memory only for the nodes it has
+	int32 id = reader.Int();
+	if (reader.Failed || id < 0) {
+		reader.Failed = true;
+		return nullptr;
+	}
+
+	Node& node = _Nodes[id];
+	node = Node();
+	node.Type = type;
+	if (!ReadDictionary(reader, node.Attributes))return nullptr;
+	return &node;
+}
+
+void VoxParser::Clear() {
+	_Models.clear();
+	_Nodes.clear();
+	_Materials.clear();
+	_Palette = nullptr;
+}
+
+bool VoxParser::Parse(const uint8* data, size_t size, const std::string& identifier) {
+	Clear();
+
+	Reader file{ data, data + size };
+	const uint8* magic = file.Skip(4);
+	if (magic == nullptr || memcmp(magic, "VOX ", 4) != 0) {
+		Log::warn("Trying to load an invalid vox file! {}", identifier);
+		return false;
+	}
+	file.Int();//Version
+
+	//MAIN has every other chunk as children
+	const uint8* main = file.Skip(4);
+	int32 mainSize = file.Int();
+	int32 mainChildrenSize = file.Int();
+	file.SkipArray(mainSize, 1);
+	const uint8* children = file.SkipArray(mainChildrenSize, 1);
+	if (file.Failed || memcmp(main, "MAIN", 4) != 0) {
+		Log::warn("Trying to load an invalid vox file! {}", identifier);
+		return false;
+	}
+
+	Reader chunks{ children, children + mainChildrenSize };
+	glm::ivec3 modelSize(0);
+	while (chunks.Data < chunks.End) {
+		const uint8* id = chunks.Skip(4);
+		int32 contentSize = chunks.Int();
+		int32 childrenSize = chunks.Int();
+		const uint8* content = chunks.SkipArray(contentSize, 1);
+		chunks.SkipArray(childrenSize, 1);
+		if (chunks.Failed) {
+			Log::warn("Truncated vox file {}", identifier);
+			Clear();
+			return false;
+		}
+
+		Reader chunk{ content, content + contentSize };
+		uint32 chunkId;
+		memcpy(&chunkId, id, sizeof(uint32));
+		switch (chunkId) {
+		case ChunkId("SIZE"):
+			modelSize.x = chunk.Int();
+			modelSize.y = chunk.Int();
+			modelSize.z = chunk.Int();
+			//MagicaVoxel models are at most 256 voxels per side, the voxel coordinates are bytes
+			if (glm::any(glm::lessThan(modelSize, glm::ivec3(1))) || glm::any(glm::greaterThan(modelSize, glm::ivec3(256)))) {
+				chunk.Failed = true;
+			}
+			break;
+
+		case ChunkId("XYZI"): {
+			//Every XYZI comes after its own SIZE
+			if (modelSize.x == 0) {
+				chunk.Failed = true;
+				break;
+			}
+			Model model;
+			model.Size = modelSize;
+			model.VoxelCount = chunk.Int();
+			model.Voxels = chunk.SkipArray(model.VoxelCount, 4);
+			//The importer writes the voxels in a grid of the SIZE
+			for (int32 i = 0; i < model.VoxelCount && !chunk.Failed; i++) {
+				const uint8* voxel = model.Voxels + (size_t)i * 4;
+				if (voxel[0] >= modelSize.x || voxel[1] >= modelSize.y || voxel[2] >= modelSize.z) {
+					chunk.Failed = true;
+				}
+			}
+			_Models.push_back(model);
+			modelSize = glm::ivec3(0);
+			break;
+		}
+
+		case ChunkId("RGBA"):
+			_Palette = chunk.Skip(256 * 4);
+			break;
+
+		case ChunkId("MATL"): {
+			Material material;
+			material.Id = chunk.Int();
+			if (ReadDictionary(chunk, material.Properties)) {
+				_Materials.push_back(material);
+			}
+			break;
+		}
+
+		case ChunkId("nTRN"): {
+			Node* node = AddNode(chunk, NodeType::Transform);
+			if (node == nullptr)break;
+			node->Child = chunk.Int();
+			chunk.Int();//Reserved id
+			chunk.Int();//Layer id
+			int32 frames = chunk.Int();
+			for (int32 i = 0; i < frames && !chunk.Failed; i++) {
+				Dictionary frame;
+				if (ReadDictionary(chunk, frame) && i == 0) {
+					node->Frame = frame;
+				}
+			}
+			break;
+		}
+
+		case ChunkId("nGRP"): {
+			Node* node = AddNode(chunk, NodeType::Group);
+			if (node == nullptr)break;
+			node->ChildCount = chunk.Int();
+			node->Children = chunk.SkipArray(node->ChildCount, sizeof(int32));
+			break;
+		}
+
+		case ChunkId("nSHP"): {
+			Node* node = AddNode(chunk, NodeType::Shape);
+			if (node == nullptr)break;
+			//Only the first model, the others are animation frames
+			if (chunk.Int() > 0) {
+				node->Model = chunk.Int();
+			}
+			break;
+		}
+
+		default://PACK, LAYR, IMAP, rOBJ, rCAM, NOTE...
+			break;
+		}
+
+		if (chunk.Failed) {
+			Log::warn("Corrupted chunk {} in vox file {}", std::string((const char*)id, 4), identifier);
+			Clear();
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <glm/glm.hpp>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Reads a MagicaVoxel .vox file in place, usually a mapped file
+// the chunks are walked by their offsets and the unknown ones are skipped
+// the voxels and the dictionaries are views of the bytes, valid while the bytes are
+class VoxParser {
+	struct Reader;
+
+public:
+	// Key and value strings of a DICT, validated when parsed and read when looked up
+	class Dictionary {
+		friend class VoxParser;
+		const uint8* _Data{ nullptr };
+		int32 _Count{ 0 };
+
+	public:
+		// Empty when the key is missing
+		std::string_view Find(std::string_view key) const;
+		int32 GetCount() const { return _Count; }
+	};
+
+	// A SIZE and its XYZI, every voxel is 4 bytes: x, y, z and the color index
+	struct Model {
+		glm::ivec3 Size;
+		const uint8* Voxels;
+		int32 VoxelCount;
+	};
+
+	enum class NodeType : uint8 { None, Transform, Group, Shape };
+
+	struct Node {
+		NodeType Type{ NodeType::None };
+		Dictionary Attributes;
+
+		// Transform
+		int32 Child{ -1 };
+		Dictionary Frame; // Attributes of the first frame, _t translation and _r rotation
+
+		// Group, ChildCount node ids
+		const uint8* Children{ nullptr };
+		int32 ChildCount{ 0 };
+
+		// Shape
+		int32 Model{ -1 };
+
+		int32 GetChild(int32 index) const {
+			int32 id;
+			memcpy(&id, Children + (size_t)index * sizeof(int32), sizeof(int32));
+			return id;
+		}
+	};
+
+	struct Material {
+		int32 Id;
+		Dictionary Properties;
+	};
+
+private:
+	std::vector<Model> _Models;
+	std::unordered_map<int32, Node> _Nodes; // By node id, the ids are any the file has
+	std::vector<Material> _Materials;
+	const uint8* _Palette{ nullptr };
+
+	void Clear();
+	static bool ReadDictionary(Reader& reader, Dictionary& dictionary);
+	Node* AddNode(Reader& reader, NodeType type);
+
+public:
+	// False when the file is not valid, logs why and nothing is kept
+	bool Parse(const uint8* data, size_t size, const std::string& identifier);
+
+	const std::vector<Model>& GetModels() const { return _Models; }
+	const std::vector<Material>& GetMaterials() const { return _Materials; }
+	// nullptr when the file has no node with the id
+	const Node* GetNode(int32 id) const {
+		auto it = _Nodes.find(id);
+		if (it == _Nodes.end() || it->second.Type == NodeType::None)return nullptr;
+		return &it->second;
+	}
+	// 256 RGBA colors, the color index i is at i - 1, nullptr when the file has none
+	const uint8* GetPalette() const { return _Palette; }
+};
@@ -1,38 +1,24 @@
 #include "AutoAssetImporter.h"
 
+#include "Core/Engine.h"
 #include "Mod/ModLoader.h"
 #include "Editor/Importer/AssetImporter.h"
 
 #include <filesystem>
-#include "AutoAssetImporter.h"
 
-AutoAssetImporter::AutoAssetImporter() {
-	lastRootEdit = std::filesystem::last_write_time(Mod::MODS).time_since_epoch().count();
+AutoAssetImporter::AutoAssetImporter() : _Watcher(Mod::MODS, [](const std::vector<std::string>& files) {
+	//In the watcher thread, the importers are only read
+	for (const std::string& file : files) {
+		if (!AssetImporter::CanImport(file))continue;
 
-	for (auto path : std::filesystem::recursive_directory_iterator(Mod::MODS)) {
-		std::string filePath = path.path().generic_string();
-		if (AssetImporter::CanImport(filePath)) {
-			filesLastEdit.emplace(filePath, std::filesystem::last_write_time(path).time_since_epoch().count());
-		}
-	}
-}
-
-void AutoAssetImporter::CheckForImport() {
-	long long newRootEdit = std::filesystem::last_write_time(Mod::MODS).time_since_epoch().count();
-	if (Get().lastRootEdit == newRootEdit) {
-		return;
-	}
-	Get().lastRootEdit = newRootEdit;
+		std::string to = std::filesystem::path(file).parent_path().lexically_relative(Mod::MODS).generic_string();
+		Engine::OnBeforeUpdate([file, to]() {
+			//Deleted after it was written (a temporary file)
+			if (!std::filesystem::exists(file))return;
 
-	for (auto path : std::filesystem::recursive_directory_iterator(Mod::MODS)) {
-		std::string filePath = path.path().generic_string();
-		if (AssetImporter::CanImport(filePath)) {
-			long long lastEdit = std::filesystem::last_write_time(path).time_since_epoch().count();
-			if (Get().filesLastEdit[filePath] != lastEdit) {
-				Get().filesLastEdit[filePath] = lastEdit;
-				Log::debug("Auto import {} to {}", filePath, path.path().parent_path().lexically_relative(Mod::MODS).generic_string());
-				AssetImporter::Import(filePath, path.path().parent_path().lexically_relative(Mod::MODS).generic_string());
-			}
-		}
+			Log::debug("Auto import {} to {}", file, to);
+			AssetImporter::Import(file, to);
+		});
 	}
+}) {
 }
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <unordered_map>
+#include "IO/FileWatcher.h"
 
+// Imports the files of the mods written outside the editor (MagicaVoxel, ...)
+// A FileWatcher reports them in its thread and the imports are posted to the main thread with Engine::OnBeforeUpdate
 class AutoAssetImporter {
-	long long lastRootEdit;
-
-	std::unordered_map<std::string, long long> filesLastEdit;
+	FileWatcher _Watcher;
 
 	static AutoAssetImporter& Get() {
 		static AutoAssetImporter i;
@@ -15,5 +15,6 @@ class AutoAssetImporter {
 public:
 	AutoAssetImporter();
 
-	static void CheckForImport();
-};
\ No newline at end of file
+	// Starts watching the mods folder
+	static void Start() { Get(); }
+};
@@ -16,15 +16,14 @@
 #include <imgui/imgui.h>
 
 
+//Patched so the systems listening to the component updates see the undo and redo
 #define DO_UNDO(type, comp, member) \
 	Editor->Cmd( \
 		[=, &R, newValue = c.member](){ \
-			comp& c = R.get<comp>(e); \
-			c.member = newValue; \
+			R.patch<comp>(e, [&](comp& c) { c.member = newValue; }); \
 		}, \
 			[=, &R, oldValue = GUI::Last##type](){ \
-			comp& c = R.get<comp>(e); \
-			c.member = oldValue; \
+			R.patch<comp>(e, [&](comp& c) { c.member = oldValue; }); \
 		}, \
 		"Set " #comp " " #member \
 	); \
@@ -265,6 +264,38 @@ namespace GUI {
 		return ImGui::IsItemDeactivatedAfterEdit();
 	}
 	
+	static uint32 LastLayers = Collider::Default;
+	bool PropertyLayers(const char* title, uint32& v) {
+		PropertyLabel(title);
+		ImGui::PushID(title);
+
+		constexpr int LayersCount = 4;
+		constexpr const char* LayersAliases[LayersCount] = {
+			"Default",
+			"Character",
+			"Trigger",
+			"Debris",
+		};
+
+		uint32 oldValue = v;
+		bool changed = false;
+		ImGui::BeginGroup();
+		for (int i = 0; i < LayersCount; i++) {
+			if (ImGui::CheckboxFlags(LayersAliases[i], &v, 1u << i)) {
+				changed = true;
+			}
+		}
+		ImGui::EndGroup();
+		ImGui::PopID();
+
+		if (changed) {
+			LastLayers = oldValue;
+			ComponentChanged = true;
+		}
+
+		return changed;
+	}
+
 	static Light::Type LastLightType = Light::Type::Point;
 	bool Property(const char* title, Light::Type& v) {
 		PropertyLabel(title);
@@ -441,11 +472,12 @@ void PropertiesWindow::OnGUI() {
 				DO_UNDO_REMOVE_COMPONENT(VoxRenderer);
 
 				if (GUI::Property("Vox", c.Vox)) { DO_UNDO(VoxAsset, VoxRenderer, Vox); }
-				if (GUI::Property("Pallete", c.Pallete)) { DO_UNDO(VoxAsset, VoxRenderer, Vox); }
+				if (GUI::Property("Pallete", c.Pallete)) { DO_UNDO(PalleteAsset, VoxRenderer, Pallete); }
 				if (GUI::Property("Pivot", c.Pivot)) { DO_UNDO(Vec3, VoxRenderer, Pivot); }
 
 				if (GUI::ComponentChanged) {
 					c.VoxSlot = -1;
+					R.replace<VoxRenderer>(e, R.get<VoxRenderer>(e));
 				}
 			}
 			GUI::EndComponent();
@@ -494,6 +526,42 @@ void PropertiesWindow::OnGUI() {
 			}
 			GUI::EndComponent();
 		}
+		if (R.has<CharacterController>(e)) {
+			if (GUI::BeginComponent("CharacterController")) {
+				CharacterController& c = R.get<CharacterController>(e);
+				DO_UNDO_REMOVE_COMPONENT(CharacterController);
+
+				if (GUI::Property("HalfExtents", c.HalfExtents)) { DO_UNDO(Vec3, CharacterController, HalfExtents); }
+				if (GUI::Property("Offset", c.Offset)) { DO_UNDO(Vec3, CharacterController, Offset); }
+				if (GUI::Property("StepHeight", c.StepHeight)) { DO_UNDO(Float, CharacterController, StepHeight); }
+			}
+			GUI::EndComponent();
+		}
+		if (R.has<RigidBody>(e)) {
+			if (GUI::BeginComponent("RigidBody")) {
+				RigidBody& c = R.get<RigidBody>(e);
+				DO_UNDO_REMOVE_COMPONENT(RigidBody);
+
+				if (GUI::Property("VoxelMass", c.VoxelMass)) { DO_UNDO(Float, RigidBody, VoxelMass); }
+				if (GUI::Property("Friction", c.Friction)) { DO_UNDO(Float, RigidBody, Friction); }
+				if (GUI::Property("Restitution", c.Restitution)) { DO_UNDO(Float, RigidBody, Restitution); }
+			}
+			GUI::EndComponent();
+		}
+		if (R.has<Collider>(e)) {
+			if (GUI::BeginComponent("Collider")) {
+				Collider& c = R.get<Collider>(e);
+				DO_UNDO_REMOVE_COMPONENT(Collider);
+
+				if (GUI::PropertyLayers("Layers", c.Layers)) { DO_UNDO(Layers, Collider, Layers); }
+
+				//Used to resolve the layers again
+				if (GUI::ComponentChanged) {
+					R.replace<Collider>(e, c);
+				}
+			}
+			GUI::EndComponent();
+		}
 		if (R.has<IKChain>(e)) {
 			if (GUI::BeginComponent("IKChain")) {
 				IKChain& c = R.get<IKChain>(e);
@@ -524,6 +592,9 @@ void PropertiesWindow::OnGUI() {
 				DO_UNDO_ADD_COMPONENT(VoxRenderer);
 				DO_UNDO_ADD_COMPONENT(Script);
 				DO_UNDO_ADD_COMPONENT(Character);
+				DO_UNDO_ADD_COMPONENT(CharacterController);
+				DO_UNDO_ADD_COMPONENT(RigidBody);
+				DO_UNDO_ADD_COMPONENT(Collider);
 				DO_UNDO_ADD_COMPONENT(IKChain);
 
 				ImGui::MenuItem("Camera");
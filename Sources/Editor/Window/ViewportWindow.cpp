@@ -438,7 +438,8 @@ void ViewportWindow::OnGUI() {
 		if (ImGui::IsItemClicked() && !ImGuizmo::IsUsing()) {
 			float t;
 			entt::entity e;
-			if (_World->Physics->RayCast(_Camera->Position, EUI::ScreenToWorld(ImGui::GetMousePos()), t, e)) {
+			//Picking hits every layer, Characters included
+			if (_World->Physics->RayCast(_Camera->Position, EUI::ScreenToWorld(ImGui::GetMousePos()), t, e, QueryFilter())) {
 				if (ImGui::GetIO().KeyCtrl) {
 					Selection.ToggleEntity(e);
 				}
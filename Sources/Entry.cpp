@@ -1,9 +1,26 @@
 #include "Core/Engine.h"
 #include "Layer/GameLayer.h"
 #include "Editor/EditorLayer.h"
+#include "Editor/Importer/AssetCooker.h"
+#include "Tests/Tests.h"
 
-int main() {
+int main(int argc, char** argv) {
 	Log::level(Log::L0_Trace);
+
+	//--cook [mod...] imports the sources of the mods, all when none is given, without a window and exits
+	if (argc > 1 && std::string(argv[1]) == "--cook") {
+		Engine::CreateHeadless();
+		std::vector<std::string> mods(argv + 2, argv + argc);
+		return AssetCooker::Cook(mods) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	//--test [name...] and --bench [name...] run the tests or the benchmarks starting with the names, all when none is given
+	if (argc > 1 && (std::string(argv[1]) == "--test" || std::string(argv[1]) == "--bench")) {
+		Engine::CreateHeadless();
+		std::vector<std::string> names(argv + 2, argv + argc);
+		return Tests::Run(std::string(argv[1]) == "--bench", names) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	Engine::Create();
 	//Engine::PushLayer(New<GameLayer>());
 	Engine::PushLayer(New<EditorLayer>());
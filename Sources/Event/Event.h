@@ -62,4 +62,14 @@ struct FocusChangeEvent : public EventDef<FocusChangeEvent> {
 struct AssetImportedEvent : public EventDef<AssetImportedEvent> {
 	std::string file;
 	std::string toFolder;
+};
+
+// Dispatched by Assets::CreateAsset, path is relative to Mod::MODS
+struct AssetCreatedEvent : public EventDef<AssetCreatedEvent> {
+	std::string path;
+};
+
+// Dispatched by the importers when an existing asset file is referenced instead of creating one, path is relative to Mod::MODS
+struct AssetReusedEvent : public EventDef<AssetReusedEvent> {
+	std::string path;
 };
\ No newline at end of file
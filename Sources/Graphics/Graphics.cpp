@@ -11,11 +11,9 @@
 
 Graphics::Graphics() {
 
-	GLFWwindow* window = Window::Get().GetNativeWindow();
-
 	auto initInfo = evk::InitInfo();
-	//Add GLFW instanceExtensions
-	{
+	//Add GLFW instanceExtensions, headless has no surface
+	if (!Engine::IsHeadless()) {
 		uint32_t count = 0;
 		const char** instanceExtensions = glfwGetRequiredInstanceExtensions(&count);
 		for (int i = 0; i < count; i++) {
@@ -32,13 +30,17 @@ Graphics::Graphics() {
 		Log::critical("Failed to init evk!");
 	}
 
-	VkSurfaceKHR surface;
-	if (glfwCreateWindowSurface(evk::GetState().instance, window, nullptr, &surface) != VK_SUCCESS) {
-		Log::critical("Failed to create window surface!");
-	}
+	if (!Engine::IsHeadless()) {
+		GLFWwindow* window = Window::Get().GetNativeWindow();
 
-	if (!InitializeSwapchain(surface)) {
-		Log::critical("Failed to initialize swapchain!");
+		VkSurfaceKHR surface;
+		if (glfwCreateWindowSurface(evk::GetState().instance, window, nullptr, &surface) != VK_SUCCESS) {
+			Log::critical("Failed to create window surface!");
+		}
+
+		if (!InitializeSwapchain(surface)) {
+			Log::critical("Failed to initialize swapchain!");
+		}
 	}
 
 	frameCmdBuffer = CmdBuffer::Create();
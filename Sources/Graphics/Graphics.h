@@ -1,6 +1,7 @@
 #pragma once
 
 #include <inttypes.h>
+#include <functional>
 #include <tuple>
 
 #include "Core/Core.h"
@@ -15,6 +16,9 @@ class Graphics : public ModuleDef<Graphics> {
 	CmdBuffer frameCmdBuffer;
 	CmdBuffer transferCmdBuffer;
 
+	std::vector<std::function<void(CmdBuffer&)>> queuedTransfers;
+	uint64_t frameIndex{ 0 };
+
 public:
 	Graphics();
 
@@ -22,7 +26,16 @@ public:
 
 	template<typename T>
 	static void Frame(T callback) {
-		Get().frameCmdBuffer.use([&] { callback(Get().frameCmdBuffer); }).submit().wait();
+		Graphics& G = Get();
+		G.frameCmdBuffer.use([&] {
+			//The queued transfers go first so the frame already sees the data
+			for (auto& transfer : G.queuedTransfers) {
+				transfer(G.frameCmdBuffer);
+			}
+			G.queuedTransfers.clear();
+			callback(G.frameCmdBuffer);
+		}).submit().wait();
+		G.frameIndex++;
 	}
 
 	//Used to synchonous transfer data from CPU to GPU
@@ -31,7 +44,14 @@ public:
 		Get().transferCmdBuffer.use([&] { callback(Get().transferCmdBuffer); }).submit().wait();
 	}
 
-	//TODO: Async transfer
+	//Records the transfer at the start of the next Frame, the CPU doesn't wait for it
+	//the callback has to keep alive the resources it uses and the source data can't change until GetFrameIndex() advances
+	static void QueueTransfer(std::function<void(CmdBuffer&)> callback) {
+		Get().queuedTransfers.push_back(std::move(callback));
+	}
+
+	//Number of Frames submitted
+	static uint64_t GetFrameIndex() { return Get().frameIndex; }
 };
 
 class Passes {
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Graphics/Graphics.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 class ColorWorldPipeline {
 	GraphicsPipeline _Pipeline;
@@ -15,8 +15,8 @@ public:
 	ColorWorldPipeline() {
 		_Pipeline = GraphicsPipeline::Create( GraphicsPipeline::Info()
 			.setPass(Passes::Color())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/ColorWorld.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/ColorWorld.frag.spv"))
+			.vertexShader(Shaders::Read("ColorWorld.vert"))
+			.fragmentShader(Shaders::Read("ColorWorld.frag"))
 		);
 	}
 
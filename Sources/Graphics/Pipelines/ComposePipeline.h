@@ -4,7 +4,7 @@
 #include "glm/glm.hpp"
 #include "Graphics/Renderer/View.h"
 #include "Core/Engine.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 #include <functional>
 
 class ComposePipeline {
@@ -28,8 +28,8 @@ public:
 	ComposePipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Color())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/Compose.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/Compose.frag.spv"))
+			.vertexShader(Shaders::Read("Compose.vert"))
+			.fragmentShader(Shaders::Read("Compose.frag"))
 		);
 	}
 
@@ -3,7 +3,7 @@
 
 #include "Graphics/Graphics.h"
 #include "glm/glm.hpp"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 #include <functional>
 
 #include "Graphics/Renderer/View.h"
@@ -23,8 +23,8 @@ public:
 	ComposeTAAPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Color())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/ComposeTAA.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/ComposeTAA.frag.spv"))
+			.vertexShader(Shaders::Read("ComposeTAA.vert"))
+			.fragmentShader(Shaders::Read("ComposeTAA.frag"))
 		);
 	}
 
@@ -3,7 +3,7 @@
 #pragma once
 
 #include "Graphics/Graphics.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 class CubeMapFacePipeline {
 	GraphicsPipeline _Pipeline;
@@ -17,8 +17,8 @@ public:
 	CubeMapFacePipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::CubeMapFace())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/CubeMapFace.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/CubeMapFace.frag.spv"))
+			.vertexShader(Shaders::Read("CubeMapFace.vert"))
+			.fragmentShader(Shaders::Read("CubeMapFace.frag"))
 		);
 	}
 
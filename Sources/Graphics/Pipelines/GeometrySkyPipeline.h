@@ -8,7 +8,7 @@
 
 #include "World/Components.h"
 #include "Profiler/Profiler.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 #include <glm/glm.hpp>
 
@@ -23,8 +23,8 @@ public:
 	GeometrySkyPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Geometry())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/GeometrySky.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/GeometrySky.frag.spv"))
+			.vertexShader(Shaders::Read("GeometrySky.vert"))
+			.fragmentShader(Shaders::Read("GeometrySky.frag"))
 		);
 	}
 
@@ -8,7 +8,7 @@
 
 #include "World/Components.h"
 #include "Profiler/Profiler.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 #include <glm/glm.hpp>
 
@@ -40,8 +40,8 @@ public:
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Geometry())
 			.setDepth()
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/GeometryVoxel.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/GeometryVoxel.frag.spv"))
+			.vertexShader(Shaders::Read("GeometryVoxel.vert"))
+			.fragmentShader(Shaders::Read("GeometryVoxel.frag"))
 		);
 	}
 
@@ -3,7 +3,7 @@
 
 #include "Graphics/Graphics.h"
 #include "glm/glm.hpp"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 #include <functional>
 #include "Core/Engine.h"
 
@@ -27,12 +27,12 @@ public:
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
 			.setBlend(Blend::Additive)
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightAmbient.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightAmbient.frag.spv"))
+			.vertexShader(Shaders::Read("LightAmbient.vert"))
+			.fragmentShader(Shaders::Read("LightAmbient.frag"))
 		);
 	}
 
-	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Framebuffer& geometryFB, Image& shadowVox, Image& blueNoise, Image& skyBox) {
+	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Framebuffer& geometryFB, Buffer& shadowVox, Image& blueNoise, Image& skyBox) {
 		//Update Push Constances
 		PushConstant pc = {};
 		pc.ViewBufferRID = viewBuffer.getRID();
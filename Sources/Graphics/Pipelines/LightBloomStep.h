@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Graphics/Graphics.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 class LightBloomStepPipeline {
 	GraphicsPipeline _Pipeline;
@@ -14,8 +14,8 @@ public:
 	LightBloomStepPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightBloomStep.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightBloomStep.frag.spv"))
+			.vertexShader(Shaders::Read("LightBloomStep.vert"))
+			.fragmentShader(Shaders::Read("LightBloomStep.frag"))
 		);
 	}
 
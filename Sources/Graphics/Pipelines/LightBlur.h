@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Graphics/Graphics.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 class LightBlurPipeline {
 	GraphicsPipeline _Pipeline;
@@ -15,8 +15,8 @@ public:
 	LightBlurPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightBlur.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightBlur.frag.spv"))
+			.vertexShader(Shaders::Read("LightBlur.vert"))
+			.fragmentShader(Shaders::Read("LightBlur.frag"))
 		);
 	}
 
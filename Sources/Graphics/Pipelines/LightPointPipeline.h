@@ -5,7 +5,7 @@
 
 #include "Graphics/Graphics.h"
 #include "Graphics/Renderer/View.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 #include "glm/glm.hpp"
 #include <functional>
 
@@ -50,8 +50,8 @@ public:
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
 			.setBlend(Blend::Additive)
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightPoint.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightPoint.frag.spv"))
+			.vertexShader(Shaders::Read("LightPoint.vert"))
+			.fragmentShader(Shaders::Read("LightPoint.frag"))
 		);
 	}
 	
@@ -71,7 +71,7 @@ public:
 		}
 	}
 
-	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Framebuffer& geometryFB, Image& ShadowVox, Image& BlueNoise, int Frame, std::function<void(LightPointPipeline& P)> cb) {
+	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Framebuffer& geometryFB, Buffer& ShadowVox, Image& BlueNoise, int Frame, std::function<void(LightPointPipeline& P)> cb) {
 		_CurrentLightIndex = 0;
 
 		PushConstant pc;
@@ -3,7 +3,7 @@
 
 #include "Graphics/Graphics.h"
 #include "glm/glm.hpp"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 #include <functional>
 #include "Core/Engine.h"
 
@@ -26,12 +26,12 @@ public:
 	LightReflectionPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightReflection.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightReflection.frag.spv"))
+			.vertexShader(Shaders::Read("LightReflection.vert"))
+			.fragmentShader(Shaders::Read("LightReflection.frag"))
 		);
 	}
 
-	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Image& lightDiffuse, Framebuffer& geometryFB, Image& shadowVox, Image& skybox, Image& blueNoise) {
+	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Image& lightDiffuse, Framebuffer& geometryFB, Buffer& shadowVox, Image& skybox, Image& blueNoise) {
 		//Update Push Constances
 		PushConstant pc = {};
 		pc.ViewBufferRID = viewBuffer.getRID();
@@ -4,6 +4,7 @@
 
 
 #include "Graphics/Graphics.h"
+#include "Graphics/Shaders.h"
 #include "Graphics/Renderer/View.h"
 #include "glm/glm.hpp"
 #include <functional>
@@ -52,8 +53,8 @@ public:
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
 			.setBlend(Blend::Additive)
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightSpot.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightSpot.frag.spv"))
+			.vertexShader(Shaders::Read("LightSpot.vert"))
+			.fragmentShader(Shaders::Read("LightSpot.frag"))
 		);
 	}
 	
@@ -76,7 +77,7 @@ public:
 		}
 	}
 
-	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Framebuffer& geometryFB, Image& ShadowVox, Image& BlueNoise, int Frame, std::function<void(LightSpotPipeline& P)> cb) {
+	void Use(CmdBuffer& cmd, Buffer& viewBuffer, Framebuffer& geometryFB, Buffer& ShadowVox, Image& BlueNoise, int Frame, std::function<void(LightSpotPipeline& P)> cb) {
 		_CurrentLightIndex = 0;
 
 		PushConstant pc;
@@ -2,6 +2,7 @@
 
 
 #include "Graphics/Graphics.h"
+#include "Graphics/Shaders.h"
 #include "glm/glm.hpp"
 #include <functional>
 
@@ -26,8 +27,8 @@ public:
 	LightTAAPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Light())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightTAA.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/LightTAA.frag.spv"))
+			.vertexShader(Shaders::Read("LightTAA.vert"))
+			.fragmentShader(Shaders::Read("LightTAA.frag"))
 		);
 	}
 
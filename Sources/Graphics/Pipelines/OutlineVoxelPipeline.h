@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Graphics/Graphics.h"
+#include "Graphics/Shaders.h"
 #include "Graphics/Renderer/View.h"
 
 #include "Core/Window.h"
@@ -34,8 +35,8 @@ public:
 	OutlineVoxelPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Outline())
-			.vertexShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/OutlineVoxel.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Assets/Mods/default/Shaders/OutlineVoxel.frag.spv"))
+			.vertexShader(Shaders::Read("OutlineVoxel.vert"))
+			.fragmentShader(Shaders::Read("OutlineVoxel.frag"))
 		);
 	}
 
@@ -2,7 +2,7 @@
 #pragma once
 
 #include "Graphics/Graphics.h"
-#include "Util/FileUtil.h"
+#include "Graphics/Shaders.h"
 
 class PresentPipeline {
 	GraphicsPipeline _Pipeline;
@@ -15,8 +15,8 @@ public:
 	PresentPipeline() {
 		_Pipeline = GraphicsPipeline::Create(GraphicsPipeline::Info()
 			.setPass(Passes::Present())
-			.vertexShader(FileUtil::ReadBytes("Sources/Shaders/Bin/Present.vert.spv"))
-			.fragmentShader(FileUtil::ReadBytes("Sources/Shaders/Bin/Present.frag.spv"))
+			.vertexShader(Shaders::Read("Present.vert"))
+			.fragmentShader(Shaders::Read("Present.frag"))
 		);
 	}
 
@@ -4,6 +4,7 @@
 #include "World/Components.h"
 #include "World/Systems/CameraSystem.h"
 #include "World/Systems/ShadowVoxSystem.h"
+#include "World/Systems/PhysicsSystem.h"
 
 #include "Core/Engine.h"
 #include "Core/Input.h"
@@ -203,12 +204,19 @@ void WorldRenderer::DrawWorld(float dt, CmdBuffer& cmd, View& view, World& world
 		viewData.PalleteColorRID = PalleteCache::GetColorTexture().getRID();
 		viewData.PalleteMaterialRID = PalleteCache::GetMaterialTexture().getRID();
 		_ViewBuffer.update(&viewData, sizeof(ViewData));
+
+		//The shadow volume follows the camera from the next update
+		world.ShadowVox->SetFocus(view.Position);
 	}
 
 	//Build Voxel Cmds
 	{
 		PROFILE_SCOPE("Build Voxel Cmds");
-		world.GetRegistry().group<VoxRenderer>(entt::get_t<Transform>()).each([&](const entt::entity e, VoxRenderer& v, Transform& t) {
+		auto& R = world.GetRegistry();
+		Frustum frustum = Frustum::FromMatrix(view.ProjectionMatrix * view.ViewMatrix);
+		world.Physics->QueryFrustum(frustum, [&](const entt::entity e) {
+			VoxRenderer& v = R.get<VoxRenderer>(e);
+			Transform& t = R.get<Transform>(e);
 			if (v.Vox.IsValid() && v.Pallete.IsValid()) {
 				glm::mat4 mat = t.WorldMatrix;
 				mat = glm::translate(mat, -v.Pivot);
@@ -217,6 +225,7 @@ void WorldRenderer::DrawWorld(float dt, CmdBuffer& cmd, View& view, World& world
 
 				CmdVoxel(mat, last_mat, v.Vox->GetImage(), v.Pallete->GetPalleteIndex());
 			}
+			return true;
 		});
 	}
 
@@ -239,8 +248,8 @@ void WorldRenderer::DrawWorld(float dt, CmdBuffer& cmd, View& view, World& world
 	cmd.timestamp("Lights", [&] {
 		//Lights
 		cmd.use(_CurrentLightBuffer, [&] {
-			LightAmbientPipeline::Get().Use(cmd, _ViewBuffer, _GeometryBuffer, world.ShadowVox->GetVolumeImage(), _BlueNoise->GetImage(), _DefaultSkyBox->GetSkyBox());
-			LightPointPipeline::Get().Use(cmd, _ViewBuffer, _GeometryBuffer, world.ShadowVox->GetVolumeImage(), _BlueNoise->GetImage(), _Frame, [&](LightPointPipeline& P) {
+			LightAmbientPipeline::Get().Use(cmd, _ViewBuffer, _GeometryBuffer, world.ShadowVox->GetPageTable(), _BlueNoise->GetImage(), _DefaultSkyBox->GetSkyBox());
+			LightPointPipeline::Get().Use(cmd, _ViewBuffer, _GeometryBuffer, world.ShadowVox->GetPageTable(), _BlueNoise->GetImage(), _Frame, [&](LightPointPipeline& P) {
 				world.GetRegistry().view<const Transform, const Light>().each([&](const entt::entity e, const Transform& t, const Light& l) {
 					PROFILE_SCOPE("DrawPointLight()");
 					if (l.LightType == Light::Type::Point) {
@@ -248,7 +257,7 @@ void WorldRenderer::DrawWorld(float dt, CmdBuffer& cmd, View& view, World& world
 					}
 				});
 			});
-			LightSpotPipeline::Get().Use(cmd, _ViewBuffer, _GeometryBuffer, world.ShadowVox->GetVolumeImage(), _BlueNoise->GetImage(), _Frame, [&](LightSpotPipeline& P) {
+			LightSpotPipeline::Get().Use(cmd, _ViewBuffer, _GeometryBuffer, world.ShadowVox->GetPageTable(), _BlueNoise->GetImage(), _Frame, [&](LightSpotPipeline& P) {
 				world.GetRegistry().view<const Transform, const Light>().each([&](const entt::entity e, const Transform& t, const Light& l) {
 					PROFILE_SCOPE("DrawSpotLight()");
 					if (l.LightType == Light::Type::Spot) {
@@ -269,7 +278,7 @@ void WorldRenderer::DrawWorld(float dt, CmdBuffer& cmd, View& view, World& world
 	cmd.timestamp("Reflection", [&] {
 		//Reflection
 		cmd.use(_ReflectionBuffer, [&] {
-			LightReflectionPipeline::Get().Use(cmd, _ViewBuffer, _TAALightBuffer.getAttachment(0), _GeometryBuffer, world.ShadowVox->GetVolumeImage(), _DefaultSkyBox->GetSkyBox(), _BlueNoise->GetImage());
+			LightReflectionPipeline::Get().Use(cmd, _ViewBuffer, _TAALightBuffer.getAttachment(0), _GeometryBuffer, world.ShadowVox->GetPageTable(), _DefaultSkyBox->GetSkyBox(), _BlueNoise->GetImage());
 		});
 	});
 
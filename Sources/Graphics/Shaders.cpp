@@ -0,0 +1,25 @@
+#include "Shaders.h"
+
+#include "Util/FileUtil.h"
+
+#include <ShaderConfig.h>
+#include <fstream>
+
+// The pipelines bind resources the way Sources/Shaders expects, older .spv can read them as something else
+static void CheckStamp() {
+	std::string stamp;
+	std::ifstream(SHADERS_FOLDER "Sources.sha256") >> stamp;
+	if (stamp != SHADER_SOURCES_HASH) {
+		Log::critical("The shaders in {} were not built from the current Sources/Shaders, build the update_shaders target with glslc (Vulkan SDK) to rebuild them", SHADERS_FOLDER);
+		exit(-1);
+	}
+}
+
+std::vector<uint8> Shaders::Read(const std::string& name) {
+	static bool checked = false;
+	if (!checked) {
+		CheckStamp();
+		checked = true;
+	}
+	return FileUtil::ReadBytes(SHADERS_FOLDER + name + ".spv");
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <string>
+#include <vector>
+
+// The SPIR-V of Sources/Shaders, built by CMake when it found glslc or the ones committed in the default mod
+class Shaders {
+public:
+	// name is the shader file, like "Compose.frag"
+	static std::vector<uint8> Read(const std::string& name);
+};
@@ -0,0 +1,253 @@
+#include "FileWatcher.h"
+
+#include "IO/Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// How often the thread wakes to report the debounced files and to check for stop
+inline static constexpr std::chrono::milliseconds Tick{ 50 };
+
+FileWatcher::FileWatcher(const std::filesystem::path& root, Callback callback) : _Root(root), _Callback(std::move(callback)) {
+	_Thread = std::thread([this]() { Run(); });
+}
+
+FileWatcher::~FileWatcher() {
+	_Stop = true;
+	_Thread.join();
+}
+
+void FileWatcher::Flush() {
+	if (_Pending.empty())return;
+
+	Clock::time_point now = Clock::now();
+	std::vector<std::string> files;
+	for (auto it = _Pending.begin(); it != _Pending.end();) {
+		if (now - it->second >= Debounce) {
+			files.push_back(it->first);
+			it = _Pending.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+
+	if (files.empty())return;
+	std::sort(files.begin(), files.end());
+	_Callback(files);
+}
+
+void FileWatcher::Run() {
+#ifdef __linux__
+	if (Watch())return;
+#endif
+	Poll();
+}
+
+void FileWatcher::Scan(bool report) {
+	std::unordered_map<std::string, FileState> files;
+	files.reserve(_Files.size());
+
+	//The files can be deleted while iterating, they are skipped
+	std::error_code ec;
+	std::filesystem::recursive_directory_iterator it(_Root, std::filesystem::directory_options::skip_permission_denied, ec);
+	for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+		std::error_code fileEc;
+		if (!it->is_regular_file(fileEc))continue;
+		FileState state{ it->last_write_time(fileEc), 0 };
+		if (!fileEc)state.Size = it->file_size(fileEc);
+		if (fileEc)continue;
+
+		std::string path = it->path().generic_string();
+		auto last = _Files.find(path);
+		if (report && (last == _Files.end() || last->second.Time != state.Time || last->second.Size != state.Size)) {
+			Changed(path);
+		}
+		files.emplace(std::move(path), state);
+	}
+	_Files.swap(files);
+}
+
+void FileWatcher::Poll() {
+	_Polling = true;
+	Log::info("[FileWatcher] Scanning {} every {}ms", _Root.generic_string(), PollInterval.count());
+
+	Scan(false);
+	Clock::time_point nextScan = Clock::now() + PollInterval;
+	while (!_Stop) {
+		if (Clock::now() >= nextScan) {
+			Scan(true);
+			nextScan = Clock::now() + PollInterval;
+		}
+		Flush();
+		std::this_thread::sleep_for(Tick);
+	}
+}
+
+#ifdef __linux__
+static constexpr uint32 WatchMask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+
+bool FileWatcher::AddWatches(const std::filesystem::path& folder, bool report) {
+	std::vector<std::filesystem::path> folders{ folder };
+	std::error_code ec;
+	for (std::filesystem::recursive_directory_iterator it(folder, std::filesystem::directory_options::skip_permission_denied, ec);
+		!ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+		std::error_code fileEc;
+		if (it->is_directory(fileEc)) {
+			folders.push_back(it->path());
+		}
+		else if (report && it->is_regular_file(fileEc)) {
+			Changed(it->path().generic_string());
+		}
+	}
+
+	for (const std::filesystem::path& path : folders) {
+		int watch = inotify_add_watch(_Inotify, path.c_str(), WatchMask | IN_ONLYDIR);
+		if (watch >= 0) {
+			_Watches[watch] = path;
+		}
+		//Deleted after it was found, the others are still watched
+		else if (errno != ENOENT && errno != ENOTDIR) {
+			Log::warn("[FileWatcher] Failed to watch {}: {}", path.generic_string(), strerror(errno));
+			return false;
+		}
+	}
+	return true;
+}
+
+void FileWatcher::RemoveWatches(const std::filesystem::path& folder) {
+	std::string prefix = folder.generic_string() + "/";
+	for (auto it = _Watches.begin(); it != _Watches.end();) {
+		std::string path = it->second.generic_string();
+		if (path == folder.generic_string() || path.compare(0, prefix.size(), prefix) == 0) {
+			inotify_rm_watch(_Inotify, it->first);
+			it = _Watches.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+	for (auto it = _Pending.begin(); it != _Pending.end();) {
+		if (it->first.compare(0, prefix.size(), prefix) == 0) {
+			it = _Pending.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+bool FileWatcher::Resync() {
+	Log::warn("[FileWatcher] Too many changes in {}, scanning it again", _Root.generic_string());
+	Scan(true);
+	//The events of the files moved or deleted were lost too
+	for (auto it = _Pending.begin(); it != _Pending.end();) {
+		if (_Files.find(it->first) == _Files.end()) {
+			it = _Pending.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+
+	//The folders created were missed and the deleted or moved ones may still be watched
+	//watching a folder again returns its same descriptor
+	std::unordered_map<int, std::filesystem::path> watches;
+	watches.swap(_Watches);
+	if (!AddWatches(_Root, false))return false;
+	for (auto& [watch, path] : watches) {
+		if (_Watches.find(watch) == _Watches.end()) {
+			inotify_rm_watch(_Inotify, watch);
+		}
+	}
+	return true;
+}
+
+void FileWatcher::CloseInotify() {
+	close(_Inotify);
+	_Inotify = -1;
+	_Watches.clear();
+}
+
+bool FileWatcher::Watch() {
+	_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_Inotify < 0) {
+		Log::warn("[FileWatcher] inotify is not available: {}", strerror(errno));
+		return false;
+	}
+	//Usually the limit of watches (fs.inotify.max_user_watches)
+	if (!AddWatches(_Root, false)) {
+		CloseInotify();
+		_Pending.clear();
+		return false;
+	}
+	Log::info("[FileWatcher] Watching {} with inotify, {} folders", _Root.generic_string(), _Watches.size());
+	//To find what inotify misses when its queue overflows or it fails
+	Scan(false);
+
+	//Big enough for many events, aligned as the events are read in place
+	alignas(inotify_event) char buffer[64 * 1024];
+	bool failed = false;
+	while (!_Stop && !failed) {
+		pollfd fd{ _Inotify, POLLIN, 0 };
+		if (poll(&fd, 1, (int)Tick.count()) > 0 && (fd.revents & POLLIN)) {
+			ssize_t size;
+			while (!failed && (size = read(_Inotify, buffer, sizeof(buffer))) > 0) {
+				for (char* data = buffer; data < buffer + size && !failed;) {
+					const inotify_event* event = (const inotify_event*)data;
+					data += sizeof(inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW) {
+						failed = !Resync();
+						continue;
+					}
+					auto watch = _Watches.find(event->wd);
+					if (watch == _Watches.end())continue;
+					//The folder was deleted
+					if (event->mask & IN_IGNORED) {
+						_Watches.erase(watch);
+						continue;
+					}
+					if (event->len == 0)continue;
+
+					std::filesystem::path path = watch->second / event->name;
+					if (event->mask & IN_ISDIR) {
+						//Created or moved in with its files
+						if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+							failed = !AddWatches(path, true);
+						}
+						//Moved out or renamed, a rename is watched again by its IN_MOVED_TO
+						else if (event->mask & IN_MOVED_FROM) {
+							RemoveWatches(path);
+						}
+					}
+					//Removed before it was reported (a temporary file renamed when saved)
+					else if (event->mask & (IN_MOVED_FROM | IN_DELETE)) {
+						_Pending.erase(path.generic_string());
+					}
+					else {
+						Changed(path.generic_string());
+					}
+				}
+			}
+		}
+		Flush();
+	}
+
+	CloseInotify();
+	//The events not read yet are lost, the pending files are kept and polling reports them
+	if (failed) {
+		Log::warn("[FileWatcher] Can't watch every folder of {}, polling it instead", _Root.generic_string());
+		Scan(true);
+		return false;
+	}
+	return true;
+}
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Watches a folder and its subfolders in a background thread, the files created or written are reported to the callback
+// Uses inotify on Linux and scans the folder every PollInterval on the other platforms (or when inotify fails)
+// A file is reported once it wasn't written for Debounce, so a burst of writes (a save) is reported once
+class FileWatcher {
+	using Clock = std::chrono::steady_clock;
+
+public:
+	// Called in the watcher thread with the paths (root / relative path) sorted
+	using Callback = std::function<void(const std::vector<std::string>& files)>;
+
+	inline static constexpr std::chrono::milliseconds Debounce{ 250 };
+	inline static constexpr std::chrono::milliseconds PollInterval{ 1000 };
+
+private:
+	std::filesystem::path _Root;
+	Callback _Callback;
+	std::atomic<bool> _Stop{ false };
+	std::atomic<bool> _Polling{ false };
+	std::thread _Thread;
+
+	// Last change of the files not reported yet
+	std::unordered_map<std::string, Clock::time_point> _Pending;
+
+	struct FileState {
+		std::filesystem::file_time_type Time;
+		uintmax_t Size;
+	};
+	// Files of the last scan, inotify keeps one too to find the changes it missed (overflow or fallback to polling)
+	std::unordered_map<std::string, FileState> _Files;
+
+	void Changed(const std::string& path) { _Pending[path] = Clock::now(); }
+	// Reports the pending files that stopped changing
+	void Flush();
+
+	void Run();
+	// Compares the files with the last scan, the changes are only reported when report
+	void Scan(bool report);
+	void Poll();
+
+#ifdef __linux__
+	int _Inotify{ -1 };
+	std::unordered_map<int, std::filesystem::path> _Watches; // Folder of every watch descriptor
+
+	// Watches the folder and its subfolders, false when the watch limit is reached
+	// the files already in them are reported when report, they were created before the watch
+	bool AddWatches(const std::filesystem::path& folder, bool report);
+	// Removes the watches of the folder and its subfolders, it was moved or deleted
+	void RemoveWatches(const std::filesystem::path& folder);
+	// Events were lost, reports the files changed since the last scan and watches the folders again
+	bool Resync();
+	void CloseInotify();
+	// Returns when stopped, false when inotify can't be used (or stopped working)
+	bool Watch();
+#endif
+
+public:
+	FileWatcher(const std::filesystem::path& root, Callback callback);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// True when scanning instead of using the OS notifications
+	bool IsPolling() const { return _Polling; }
+};
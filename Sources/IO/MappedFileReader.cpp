@@ -0,0 +1,90 @@
+#include "MappedFileReader.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFileReader::MappedFileReader(const std::string& path) : _Path(path) {
+	StreamIsLoading = true;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		Log::error("Failed to open file {}", path);
+		return;
+	}
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			_Data = (const uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (_Data != nullptr) {
+				_Size = (size_t)size.QuadPart;
+				_Handle = mapping;
+			}
+			else {
+				CloseHandle(mapping);
+			}
+		}
+		if (_Data == nullptr)Log::error("Failed to map file {}", path);
+	}
+	//The mapping keeps the file open
+	CloseHandle(file);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		Log::error("Failed to open file {}", path);
+		return;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0) {
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED) {
+			madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+			_Data = (const uint8*)data;
+			_Size = (size_t)info.st_size;
+		}
+		else {
+			Log::error("Failed to map file {}", path);
+		}
+	}
+	close(file);
+#endif
+}
+
+MappedFileReader::~MappedFileReader() {
+	if (_Data == nullptr)return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(_Data);
+	CloseHandle((HANDLE)_Handle);
+#else
+	munmap((void*)_Data, _Size);
+#endif
+}
+
+void MappedFileReader::Serialize(void* Data, size_t Size) {
+	//Past the end reads zeros, the same as a failed FileReader leaves the values
+	size_t available = Size <= _Size - _Pointer ? Size : _Size - _Pointer;
+	if (available > 0)memcpy(Data, _Data + _Pointer, available);
+	if (available < Size)memset((uint8*)Data + available, 0, Size - available);
+	_Pointer += available;
+}
+
+const uint8* MappedFileReader::ReadView(size_t Size) {
+	if (Size > _Size - _Pointer)return nullptr;
+	const uint8* view = _Data + _Pointer;
+	_Pointer += Size;
+	return view;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Stream.h"
+
+// Reads a file mapped in memory, the bytes can be read in place with ReadView without copying them
+// The views are valid while the reader exists
+class MappedFileReader : public Stream {
+	std::string _Path;
+	const uint8* _Data{ nullptr };
+	size_t _Size{ 0 };
+	size_t _Pointer{ 0 };
+	void* _Handle{ nullptr }; // File mapping object, only on Windows
+
+public:
+	MappedFileReader(const std::string& path);
+	~MappedFileReader();
+
+	MappedFileReader(const MappedFileReader&) = delete;
+	MappedFileReader& operator=(const MappedFileReader&) = delete;
+
+	virtual bool HasData() { return _Pointer < _Size; }
+	virtual size_t GetSize() { return _Size; }
+	virtual size_t GetPointer() { return _Pointer; }
+	virtual void SetPointer(uint32_t p) { _Pointer = p < _Size ? p : _Size; }
+
+	virtual void Serialize(void* Data, size_t Size);
+	virtual const uint8* ReadView(size_t Size);
+	virtual std::string GetIdentifier() { return _Path; }
+
+	// The whole file
+	const uint8* GetData() const { return _Data; }
+};
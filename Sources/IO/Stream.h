@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include "Core/Core.h"
 #include "Log.h"
@@ -24,6 +25,9 @@ public:
 	virtual size_t GetPointer() { return 0; }
 	virtual void SetPointer(uint32_t p) {  }
 	virtual void Serialize(void* Data, size_t Size) { }
+	// Points to the next Size bytes and skips them, so they are read in place
+	// nullptr when the stream can't (or has less bytes), Serialize has to be used instead
+	virtual const uint8* ReadView(size_t Size) { return nullptr; }
 	virtual std::string GetIdentifier() {
 		return "Not Identified";
 	}
@@ -85,6 +89,22 @@ public:
 	virtual size_t GetPointer() { return pointer; }
 };
 
+// Appends to a buffer that grows as needed
+class BufferWriter : public Stream {
+	std::vector<uint8>& buffer;
+public:
+	BufferWriter(std::vector<uint8>& buffer) : buffer(buffer) {
+		StreamIsLoading = false;
+	}
+
+	virtual void Serialize(void* data, size_t size) {
+		const uint8* bytes = reinterpret_cast<const uint8*>(data);
+		buffer.insert(buffer.end(), bytes, bytes + size);
+	}
+	virtual size_t GetSize() { return buffer.size(); }
+	virtual size_t GetPointer() { return buffer.size(); }
+};
+
 class FileWriter : public Stream{
 public:
 	std::ofstream fs;
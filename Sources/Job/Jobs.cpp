@@ -73,19 +73,23 @@ void Jobs::Run(std::function<void()> JobCallback, Context& JobContext){
     j._Context = &JobContext;
     j._Callback = JobCallback;
 
+    //Must be counted before being visible to the worker threads
+    j._Context->ActiveJobs.fetch_add(1);
+
     {
         std::unique_lock lock(J._JobsMutex);
         J._Jobs.push(j);
     }
 
-    j._Context->ActiveJobs.fetch_add(1);
     J._ThreadWakeCondition.notify_all();
 }
 
 void Jobs::ParallelFor(uint32 Count, std::function<void(int Index, int Group)> JobCallback, Context& JobContext) {
 
+    if (Count == 0)return;
+
     uint32 threadCount = GetThreadCount();
-    uint32 jobSize = Count / threadCount;
+    uint32 jobSize = (Count + threadCount - 1) / threadCount; //Rounded up so the last items are not skipped
 
     uint32 start = 0;
     uint32 end = 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Asset/Assets.h"
+#include "IO/MappedFileReader.h"
 
 class ModVersion {
 	int Major;
@@ -80,7 +81,7 @@ class ModFolder : public Mod {
 	std::string _Path;
 
 	virtual AssetRef Load(const std::string& path) {
-		FileReader fr((MODS/path).generic_string());
+		MappedFileReader fr((MODS/path).generic_string());
 		return AssetSerializer::Load(fr);
 	}
 
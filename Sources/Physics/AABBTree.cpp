@@ -0,0 +1,251 @@
+#include "AABBTree.h"
+
+int32 AABBTree::_AllocateNode() {
+	if (_FreeList == Null) {
+		_Nodes.emplace_back();
+		return static_cast<int32>(_Nodes.size() - 1);
+	}
+
+	int32 node = _FreeList;
+	_FreeList = _Nodes[node].Parent;
+	_Nodes[node] = Node();
+	return node;
+}
+
+void AABBTree::_FreeNode(int32 node) {
+	_Nodes[node].Parent = _FreeList;
+	_Nodes[node].Height = -1;
+	_FreeList = node;
+}
+
+int32 AABBTree::Insert(const AABB& box, int32 userData) {
+	int32 leaf = _AllocateNode();
+	_Nodes[leaf].Box = box.Expand(Margin);
+	_Nodes[leaf].UserData = userData;
+	_Nodes[leaf].Height = 0;
+
+	_InsertLeaf(leaf);
+	_LeafCount++;
+
+	return leaf;
+}
+
+void AABBTree::Remove(int32 proxy) {
+	CHECK(proxy >= 0 && proxy < static_cast<int32>(_Nodes.size()) && _Nodes[proxy].IsLeaf());
+
+	_RemoveLeaf(proxy);
+	_FreeNode(proxy);
+	_LeafCount--;
+}
+
+bool AABBTree::Move(int32 proxy, const AABB& box) {
+	CHECK(proxy >= 0 && proxy < static_cast<int32>(_Nodes.size()) && _Nodes[proxy].IsLeaf());
+
+	if (_Nodes[proxy].Box.Contains(box)) {
+		return false;
+	}
+
+	_RemoveLeaf(proxy);
+	_Nodes[proxy].Box = box.Expand(Margin);
+	_InsertLeaf(proxy);
+
+	return true;
+}
+
+void AABBTree::Clear() {
+	_Nodes.clear();
+	_Root = Null;
+	_FreeList = Null;
+	_LeafCount = 0;
+}
+
+void AABBTree::_InsertLeaf(int32 leaf) {
+	if (_Root == Null) {
+		_Root = leaf;
+		_Nodes[_Root].Parent = Null;
+		return;
+	}
+
+	//Find the best sibling using the surface area heuristic
+	AABB leafBox = _Nodes[leaf].Box;
+	int32 index = _Root;
+	while (!_Nodes[index].IsLeaf()) {
+		const Node& node = _Nodes[index];
+
+		float area = node.Box.GetPerimeter();
+		float combinedArea = AABB::Union(node.Box, leafBox).GetPerimeter();
+
+		//Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		//Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		auto childCost = [&](int32 child) {
+			const Node& c = _Nodes[child];
+			float newArea = AABB::Union(leafBox, c.Box).GetPerimeter();
+			if (c.IsLeaf()) {
+				return newArea + inheritanceCost;
+			}
+			return (newArea - c.Box.GetPerimeter()) + inheritanceCost;
+		};
+
+		float costLeft = childCost(node.Left);
+		float costRight = childCost(node.Right);
+
+		if (cost < costLeft && cost < costRight) {
+			break;
+		}
+
+		index = costLeft < costRight ? node.Left : node.Right;
+	}
+
+	int32 sibling = index;
+
+	//Create a new parent
+	int32 oldParent = _Nodes[sibling].Parent;
+	int32 newParent = _AllocateNode();
+	_Nodes[newParent].Parent = oldParent;
+	_Nodes[newParent].Box = AABB::Union(leafBox, _Nodes[sibling].Box);
+	_Nodes[newParent].Height = _Nodes[sibling].Height + 1;
+	_Nodes[newParent].Left = sibling;
+	_Nodes[newParent].Right = leaf;
+	_Nodes[sibling].Parent = newParent;
+	_Nodes[leaf].Parent = newParent;
+
+	if (oldParent != Null) {
+		if (_Nodes[oldParent].Left == sibling) {
+			_Nodes[oldParent].Left = newParent;
+		}
+		else {
+			_Nodes[oldParent].Right = newParent;
+		}
+	}
+	else {
+		_Root = newParent;
+	}
+
+	//Walk back up fixing heights and boxes
+	index = _Nodes[leaf].Parent;
+	while (index != Null) {
+		index = _Balance(index);
+
+		Node& node = _Nodes[index];
+		node.Height = 1 + glm::max(_Nodes[node.Left].Height, _Nodes[node.Right].Height);
+		node.Box = AABB::Union(_Nodes[node.Left].Box, _Nodes[node.Right].Box);
+
+		index = node.Parent;
+	}
+}
+
+void AABBTree::_RemoveLeaf(int32 leaf) {
+	if (leaf == _Root) {
+		_Root = Null;
+		return;
+	}
+
+	int32 parent = _Nodes[leaf].Parent;
+	int32 grandParent = _Nodes[parent].Parent;
+	int32 sibling = _Nodes[parent].Left == leaf ? _Nodes[parent].Right : _Nodes[parent].Left;
+
+	if (grandParent != Null) {
+		//Connect the sibling to the grand parent and destroy the parent
+		if (_Nodes[grandParent].Left == parent) {
+			_Nodes[grandParent].Left = sibling;
+		}
+		else {
+			_Nodes[grandParent].Right = sibling;
+		}
+		_Nodes[sibling].Parent = grandParent;
+		_FreeNode(parent);
+
+		int32 index = grandParent;
+		while (index != Null) {
+			index = _Balance(index);
+
+			Node& node = _Nodes[index];
+			node.Height = 1 + glm::max(_Nodes[node.Left].Height, _Nodes[node.Right].Height);
+			node.Box = AABB::Union(_Nodes[node.Left].Box, _Nodes[node.Right].Box);
+
+			index = node.Parent;
+		}
+	}
+	else {
+		_Root = sibling;
+		_Nodes[sibling].Parent = Null;
+		_FreeNode(parent);
+	}
+}
+
+// Performs a left or right rotation if node A is imbalanced
+// returns the new root of the subtree
+int32 AABBTree::_Balance(int32 iA) {
+	Node& A = _Nodes[iA];
+	if (A.IsLeaf() || A.Height < 2) {
+		return iA;
+	}
+
+	int32 iB = A.Left;
+	int32 iC = A.Right;
+	Node& B = _Nodes[iB];
+	Node& C = _Nodes[iC];
+
+	int32 balance = C.Height - B.Height;
+
+	auto rotate = [&](int32 iUp, int32 iDown, Node& up, bool upIsRight) {
+		//iUp is the taller child of A, it becomes the subtree root
+		int32 iF = up.Left;
+		int32 iG = up.Right;
+		Node& F = _Nodes[iF];
+		Node& G = _Nodes[iG];
+		Node& down = _Nodes[iDown];
+
+		up.Left = iA;
+		up.Parent = A.Parent;
+		A.Parent = iUp;
+
+		if (up.Parent != Null) {
+			if (_Nodes[up.Parent].Left == iA) {
+				_Nodes[up.Parent].Left = iUp;
+			}
+			else {
+				_Nodes[up.Parent].Right = iUp;
+			}
+		}
+		else {
+			_Root = iUp;
+		}
+
+		//Keep the tallest grand child under the new root
+		int32 iKeep = F.Height > G.Height ? iF : iG;
+		int32 iMove = F.Height > G.Height ? iG : iF;
+		Node& keep = _Nodes[iKeep];
+		Node& move = _Nodes[iMove];
+
+		up.Right = iKeep;
+		if (upIsRight) {
+			A.Right = iMove;
+		}
+		else {
+			A.Left = iMove;
+		}
+		move.Parent = iA;
+
+		A.Box = AABB::Union(down.Box, move.Box);
+		up.Box = AABB::Union(A.Box, keep.Box);
+
+		A.Height = 1 + glm::max(down.Height, move.Height);
+		up.Height = 1 + glm::max(A.Height, keep.Height);
+
+		return iUp;
+	};
+
+	if (balance > 1) {
+		return rotate(iC, iB, C, true);
+	}
+	if (balance < -1) {
+		return rotate(iB, iC, B, false);
+	}
+
+	return iA;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Physics/Geometry.h"
+
+#include <vector>
+
+// Dynamic AABB tree used as the broadphase
+//
+// Leaves store a fattened AABB so small movements don't need to touch the tree
+// internal nodes are balanced with rotations when inserting and removing
+class AABBTree {
+public:
+	inline static constexpr int32 Null = -1;
+	// Distance added to each side of the leaves bounds
+	inline static constexpr float Margin = 0.1f;
+
+private:
+	struct Node {
+		AABB Box;
+		int32 Parent{ Null }; // Also used as the next free node
+		int32 Left{ Null };
+		int32 Right{ Null };
+		int32 Height{ 0 }; // Leaf = 0, Free = -1
+		int32 UserData{ Null };
+
+		bool IsLeaf() const { return Left == Null; }
+	};
+
+	// Fixed size stack used by the traversals, the tree height is kept low by the balancing
+	template<int N>
+	struct Stack {
+		int32 Data[N];
+		int32 Count{ 0 };
+
+		inline void Push(int32 v) { CHECK(Count < N); Data[Count++] = v; }
+		inline int32 Pop() { return Data[--Count]; }
+		inline bool Empty() const { return Count == 0; }
+	};
+	using TraversalStack = Stack<256>;
+
+	std::vector<Node> _Nodes;
+	int32 _Root{ Null };
+	int32 _FreeList{ Null };
+	int32 _LeafCount{ 0 };
+
+	int32 _AllocateNode();
+	void _FreeNode(int32 node);
+	void _InsertLeaf(int32 leaf);
+	void _RemoveLeaf(int32 leaf);
+	int32 _Balance(int32 node);
+
+public:
+
+	// Creates a leaf and returns its proxy id
+	int32 Insert(const AABB& box, int32 userData);
+	void Remove(int32 proxy);
+
+	// Updates the leaf bounds, only reinserts when it leaves the fat AABB
+	// returns true if the tree was modified
+	bool Move(int32 proxy, const AABB& box);
+
+	void Clear();
+
+	int32 GetUserData(int32 proxy) const { return _Nodes[proxy].UserData; }
+	void SetUserData(int32 proxy, int32 userData) { _Nodes[proxy].UserData = userData; }
+	const AABB& GetFatAABB(int32 proxy) const { return _Nodes[proxy].Box; }
+	int32 GetLeafCount() const { return _LeafCount; }
+	int32 GetHeight() const { return _Root == Null ? 0 : _Nodes[_Root].Height; }
+
+	// Generic traversal, test(const AABB&) -> bool decides if a node is visited
+	// callback(int32 proxy) -> bool returns false to stop the query
+	template<typename TTest, typename TCallback>
+	void Traverse(TTest test, TCallback callback) const {
+		if (_Root == Null)return;
+
+		TraversalStack stack;
+		stack.Push(_Root);
+
+		while (!stack.Empty()) {
+			const Node& node = _Nodes[stack.Pop()];
+			if (!test(node.Box))continue;
+
+			if (node.IsLeaf()) {
+				if (!callback(static_cast<int32>(&node - _Nodes.data())))return;
+			}
+			else {
+				stack.Push(node.Left);
+				stack.Push(node.Right);
+			}
+		}
+	}
+
+	template<typename T>
+	void Query(const AABB& box, T callback) const {
+		Traverse([&](const AABB& b) { return b.Overlaps(box); }, callback);
+	}
+
+	template<typename T>
+	void QuerySphere(const glm::vec3& center, float radius, T callback) const {
+		Traverse([&](const AABB& b) { return b.OverlapsSphere(center, radius); }, callback);
+	}
+
+	template<typename T>
+	void QueryFrustum(const Frustum& frustum, T callback) const {
+		Traverse([&](const AABB& b) { return frustum.Overlaps(b); }, callback);
+	}
+
+	// callback(int32 proxy, float maxT) -> float returns the new maxT used to clip the ray
+	// returning a negative value stops the query
+	template<typename T>
+	void RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, T callback) const {
+		if (_Root == Null)return;
+
+		glm::vec3 invDir = 1.0f / dir;
+
+		TraversalStack stack;
+		stack.Push(_Root);
+
+		while (!stack.Empty()) {
+			int32 id = stack.Pop();
+			const Node& node = _Nodes[id];
+
+			float t;
+			if (!node.Box.RayCast(origin, invDir, maxT, t))continue;
+
+			if (node.IsLeaf()) {
+				float newMaxT = callback(id, maxT);
+				if (newMaxT < 0.0f)return;
+				maxT = glm::min(maxT, newMaxT);
+			}
+			else {
+				// Visit the nearest child first so maxT shrinks earlier
+				float tl, tr;
+				bool hl = _Nodes[node.Left].Box.RayCast(origin, invDir, maxT, tl);
+				bool hr = _Nodes[node.Right].Box.RayCast(origin, invDir, maxT, tr);
+				if (hl && hr) {
+					if (tl < tr) {
+						stack.Push(node.Right);
+						stack.Push(node.Left);
+					}
+					else {
+						stack.Push(node.Left);
+						stack.Push(node.Right);
+					}
+				}
+				else if (hl) {
+					stack.Push(node.Left);
+				}
+				else if (hr) {
+					stack.Push(node.Right);
+				}
+			}
+		}
+	}
+};
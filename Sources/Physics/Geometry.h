@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct Ray {
+	glm::vec3 Origin{ 0.0f, 0.0f, 0.0f };
+	glm::vec3 Direction{ 0.0f, 0.0f, 1.0f };
+	float MaxT{ 999999.0f };
+
+	Ray() {}
+	Ray(glm::vec3 origin, glm::vec3 direction, float maxT = 999999.0f) : Origin(origin), Direction(direction), MaxT(maxT) {}
+};
+
+struct Sphere {
+	glm::vec3 Center{ 0.0f, 0.0f, 0.0f };
+	float Radius{ 0.0f };
+
+	Sphere() {}
+	Sphere(glm::vec3 center, float radius) : Center(center), Radius(radius) {}
+};
+
+// Axis Aligned Bounding Box in world space
+struct AABB {
+	glm::vec3 Min{ 0.0f, 0.0f, 0.0f };
+	glm::vec3 Max{ 0.0f, 0.0f, 0.0f };
+
+	AABB() {}
+	AABB(glm::vec3 min, glm::vec3 max) : Min(min), Max(max) {}
+
+	// Bounds of a box of size obbSize transformed by obb (the box starts at the obb origin)
+	static AABB FromOBB(const glm::mat4& obb, const glm::vec3& obbSize) {
+		glm::vec3 halfSize = obbSize * 0.5f;
+		glm::vec3 center = obb * glm::vec4(halfSize, 1.0f);
+		glm::vec3 extent = glm::abs(glm::vec3(obb[0])) * halfSize.x + glm::abs(glm::vec3(obb[1])) * halfSize.y + glm::abs(glm::vec3(obb[2])) * halfSize.z;
+		return AABB(center - extent, center + extent);
+	}
+
+	static AABB Union(const AABB& a, const AABB& b) {
+		return AABB(glm::min(a.Min, b.Min), glm::max(a.Max, b.Max));
+	}
+
+	AABB Expand(float margin) const {
+		return AABB(Min - glm::vec3(margin), Max + glm::vec3(margin));
+	}
+
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	glm::vec3 GetExtent() const { return (Max - Min) * 0.5f; }
+
+	// Used as the cost heuristic of the AABBTree
+	float GetPerimeter() const {
+		glm::vec3 d = Max - Min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	bool Contains(const AABB& other) const {
+		return glm::all(glm::lessThanEqual(Min, other.Min)) && glm::all(glm::greaterThanEqual(Max, other.Max));
+	}
+
+	bool Overlaps(const AABB& other) const {
+		return glm::all(glm::lessThanEqual(Min, other.Max)) && glm::all(glm::greaterThanEqual(Max, other.Min));
+	}
+
+	bool OverlapsSphere(const glm::vec3& center, float radius) const {
+		glm::vec3 closest = glm::clamp(center, Min, Max);
+		glm::vec3 d = closest - center;
+		return glm::dot(d, d) <= radius * radius;
+	}
+
+	// Slab test, invDir is 1.0/dir
+	// returns the entry t in tMin (can be negative when the ray starts inside)
+	bool RayCast(const glm::vec3& origin, const glm::vec3& invDir, float maxT, float& tMin) const {
+		glm::vec3 t1 = (Min - origin) * invDir;
+		glm::vec3 t2 = (Max - origin) * invDir;
+		glm::vec3 tNear = glm::min(t1, t2);
+		glm::vec3 tFar = glm::max(t1, t2);
+		tMin = glm::max(glm::max(tNear.x, tNear.y), tNear.z);
+		float tMax = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+		return tMin <= tMax && tMax >= 0.0f && tMin <= maxT;
+	}
+};
+
+// Oriented Bounding Box stored as its world to box matrix
+// the box covers [0, Size] in box space
+struct OBB {
+	glm::mat4 InvMatrix{ 1.0f };
+	glm::vec3 Size{ 0.0f, 0.0f, 0.0f };
+
+	OBB() {}
+	OBB(const glm::mat4& matrix, const glm::vec3& size) : InvMatrix(glm::inverse(matrix)), Size(size) {}
+
+	// Slab test in box space, t is in the units of dir so it doesn't need to be normalized
+	// returns the entry t in tMin clamped to 0 when the ray starts inside
+	bool RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& tMin) const {
+		glm::vec3 localOrigin = InvMatrix * glm::vec4(origin, 1.0f);
+		glm::vec3 localDir = InvMatrix * glm::vec4(dir, 0.0f);
+
+		//Aligned directions (zeroes in localDir) would generate NaNs
+		if (localDir.x == 0.0f)localDir.x = 0.00000001f;
+		if (localDir.y == 0.0f)localDir.y = 0.00000001f;
+		if (localDir.z == 0.0f)localDir.z = 0.00000001f;
+
+		glm::vec3 invDir = 1.0f / localDir;
+		glm::vec3 t1 = -localOrigin * invDir;
+		glm::vec3 t2 = (Size - localOrigin) * invDir;
+		glm::vec3 tNear = glm::min(t1, t2);
+		glm::vec3 tFar = glm::max(t1, t2);
+		tMin = glm::max(glm::max(glm::max(tNear.x, tNear.y), tNear.z), 0.0f);
+		float tMax = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+		return tMin <= tMax && tMin <= maxT;
+	}
+};
+
+// View frustum as 6 planes pointing inwards (xyz = normal, w = distance)
+struct Frustum {
+	glm::vec4 Planes[6];
+
+	// Extract the planes from a ViewProjection matrix (Gribb-Hartmann)
+	// the near plane uses the [-1, 1] depth range so it's conservative for [0, 1] projections
+	static Frustum FromMatrix(const glm::mat4& viewProjection) {
+		glm::mat4 m = glm::transpose(viewProjection);
+		Frustum f;
+		f.Planes[0] = m[3] + m[0]; // Left
+		f.Planes[1] = m[3] - m[0]; // Right
+		f.Planes[2] = m[3] + m[1]; // Bottom
+		f.Planes[3] = m[3] - m[1]; // Top
+		f.Planes[4] = m[3] + m[2]; // Near
+		f.Planes[5] = m[3] - m[2]; // Far
+		for (int i = 0; i < 6; i++) {
+			f.Planes[i] /= glm::length(glm::vec3(f.Planes[i]));
+		}
+		return f;
+	}
+
+	// Conservative test, may return true for boxes near the frustum corners
+	bool Overlaps(const AABB& box) const {
+		glm::vec3 center = box.GetCenter();
+		glm::vec3 extent = box.GetExtent();
+		for (int i = 0; i < 6; i++) {
+			glm::vec3 n = Planes[i];
+			float r = glm::dot(extent, glm::abs(n));
+			if (glm::dot(n, center) + Planes[i].w < -r) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,139 @@
+#include "OBBBatch.h"
+
+#include <cfloat>
+
+#ifdef OBBBATCH_SSE
+#include <immintrin.h>
+#endif
+
+// Scalar test of box i, the same math as the SIMD lanes
+static inline float RayCastLane(const float (*f)[OBBBatch::Capacity], int32 i, const glm::vec3& o, const glm::vec3& d, float maxT) {
+	float tNear = 0.0f;
+	float tFar = FLT_MAX;
+
+	for (int axis = 0; axis < 3; axis++) {
+		const int row = OBBBatch::M00 + axis * 4;
+		float lo = (f[row + 0][i] * o.x + f[row + 1][i] * o.y) + (f[row + 2][i] * o.z + f[row + 3][i]);
+		float ld = (f[row + 0][i] * d.x + f[row + 1][i] * d.y) + f[row + 2][i] * d.z;
+
+		//Aligned directions (zeroes in ld) would generate NaNs
+		if (ld == 0.0f)ld = 0.00000001f;
+
+		float inv = 1.0f / ld;
+		float t1 = -lo * inv;
+		float t2 = (f[OBBBatch::SizeX + axis][i] - lo) * inv;
+		tNear = glm::max(tNear, glm::min(t1, t2));
+		tFar = glm::min(tFar, glm::max(t1, t2));
+	}
+
+	return (tNear <= tFar && tNear <= maxT) ? tNear : FLT_MAX;
+}
+
+void OBBBatch::RayCastScalar(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const {
+	for (int32 i = 0; i < _Count; i++) {
+		tEnter[i] = RayCastLane(_Fields, i, origin, dir, maxT);
+	}
+}
+
+void OBBBatch::RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const {
+#if defined(__AVX2__)
+	RayCastAVX2(origin, dir, maxT, tEnter);
+#elif defined(OBBBATCH_SSE)
+	RayCastSSE(origin, dir, maxT, tEnter);
+#else
+	RayCastScalar(origin, dir, maxT, tEnter);
+#endif
+}
+
+#ifdef __AVX2__
+
+void OBBBatch::RayCastAVX2(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const {
+	const __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+	const __m256 dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 epsilon = _mm256_set1_ps(0.00000001f);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 miss = _mm256_set1_ps(FLT_MAX);
+	const __m256 vMaxT = _mm256_set1_ps(maxT);
+
+	int32 i = 0;
+	for (; i + 8 <= _Count; i += 8) {
+		__m256 tNear = zero;
+		__m256 tFar = miss;
+
+		for (int axis = 0; axis < 3; axis++) {
+			const int row = M00 + axis * 4;
+			__m256 m0 = _mm256_load_ps(&_Fields[row + 0][i]);
+			__m256 m1 = _mm256_load_ps(&_Fields[row + 1][i]);
+			__m256 m2 = _mm256_load_ps(&_Fields[row + 2][i]);
+			__m256 m3 = _mm256_load_ps(&_Fields[row + 3][i]);
+
+			__m256 lo = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, ox), _mm256_mul_ps(m1, oy)), _mm256_add_ps(_mm256_mul_ps(m2, oz), m3));
+			__m256 ld = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, dx), _mm256_mul_ps(m1, dy)), _mm256_mul_ps(m2, dz));
+			ld = _mm256_blendv_ps(ld, epsilon, _mm256_cmp_ps(ld, zero, _CMP_EQ_OQ));
+
+			__m256 inv = _mm256_div_ps(one, ld);
+			__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(zero, lo), inv);
+			__m256 t2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&_Fields[SizeX + axis][i]), lo), inv);
+			tNear = _mm256_max_ps(tNear, _mm256_min_ps(t1, t2));
+			tFar = _mm256_min_ps(tFar, _mm256_max_ps(t1, t2));
+		}
+
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ), _mm256_cmp_ps(tNear, vMaxT, _CMP_LE_OQ));
+		_mm256_storeu_ps(tEnter + i, _mm256_blendv_ps(miss, tNear, hit));
+	}
+
+	for (; i < _Count; i++) {
+		tEnter[i] = RayCastLane(_Fields, i, origin, dir, maxT);
+	}
+}
+
+#endif
+
+#ifdef OBBBATCH_SSE
+
+void OBBBatch::RayCastSSE(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const {
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 epsilon = _mm_set1_ps(0.00000001f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 miss = _mm_set1_ps(FLT_MAX);
+	const __m128 vMaxT = _mm_set1_ps(maxT);
+
+	int32 i = 0;
+	for (; i + 4 <= _Count; i += 4) {
+		__m128 tNear = zero;
+		__m128 tFar = miss;
+
+		for (int axis = 0; axis < 3; axis++) {
+			const int row = M00 + axis * 4;
+			__m128 m0 = _mm_load_ps(&_Fields[row + 0][i]);
+			__m128 m1 = _mm_load_ps(&_Fields[row + 1][i]);
+			__m128 m2 = _mm_load_ps(&_Fields[row + 2][i]);
+			__m128 m3 = _mm_load_ps(&_Fields[row + 3][i]);
+
+			__m128 lo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, ox), _mm_mul_ps(m1, oy)), _mm_add_ps(_mm_mul_ps(m2, oz), m3));
+			__m128 ld = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, dx), _mm_mul_ps(m1, dy)), _mm_mul_ps(m2, dz));
+
+			//SSE2 has no blend, select with masks
+			__m128 isZero = _mm_cmpeq_ps(ld, zero);
+			ld = _mm_or_ps(_mm_andnot_ps(isZero, ld), _mm_and_ps(isZero, epsilon));
+
+			__m128 inv = _mm_div_ps(one, ld);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(zero, lo), inv);
+			__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&_Fields[SizeX + axis][i]), lo), inv);
+			tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+			tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+		}
+
+		__m128 hit = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_cmple_ps(tNear, vMaxT));
+		_mm_storeu_ps(tEnter + i, _mm_or_ps(_mm_andnot_ps(hit, miss), _mm_and_ps(hit, tNear)));
+	}
+
+	for (; i < _Count; i++) {
+		tEnter[i] = RayCastLane(_Fields, i, origin, dir, maxT);
+	}
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Geometry.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define OBBBATCH_SSE
+#endif
+
+// A block of OBBs packed as a structure of arrays
+// One ray is tested against 8 boxes per iteration with AVX2, 4 with SSE
+class OBBBatch {
+public:
+	inline static constexpr int32 Capacity = 64;
+
+	// Rows of the world to box matrix followed by the box size
+	enum Field {
+		M00, M01, M02, M03,
+		M10, M11, M12, M13,
+		M20, M21, M22, M23,
+		SizeX, SizeY, SizeZ,
+		FieldCount
+	};
+
+private:
+	alignas(32) float _Fields[FieldCount][Capacity];
+	int32 _Count{ 0 };
+
+public:
+
+	void Clear() { _Count = 0; }
+	bool IsFull() const { return _Count == Capacity; }
+	int32 GetCount() const { return _Count; }
+
+	// returns the index of the box in the batch
+	int32 Add(const OBB& obb) {
+		CHECK(_Count < Capacity);
+
+		int32 i = _Count++;
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 4; col++) {
+				_Fields[M00 + row * 4 + col][i] = obb.InvMatrix[col][row];
+			}
+		}
+		_Fields[SizeX][i] = obb.Size.x;
+		_Fields[SizeY][i] = obb.Size.y;
+		_Fields[SizeZ][i] = obb.Size.z;
+		return i;
+	}
+
+	// Writes in tEnter the entry t of every box, same as OBB::RayCast
+	// boxes missed or hit after maxT get FLT_MAX
+	// uses the widest kernel the build targets, AVX2, SSE or scalar
+	void RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const;
+
+	// The kernels of RayCast, the scalar one is the reference the SIMD ones are checked with
+	void RayCastScalar(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const;
+#ifdef OBBBATCH_SSE
+	void RayCastSSE(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const;
+#endif
+#ifdef __AVX2__
+	void RayCastAVX2(const glm::vec3& origin, const glm::vec3& dir, float maxT, float* tEnter) const;
+#endif
+};
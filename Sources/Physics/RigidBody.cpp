@@ -0,0 +1,259 @@
+#include "RigidBody.h"
+
+#include <cfloat>
+#include <glm/gtc/matrix_transform.hpp>
+
+MassProperties MassProperties::FromOccupancy(const VoxOccupancy& occupancy) {
+	//Accumulated in doubles, big grids have millions of voxels
+	double count = 0.0;
+	glm::dvec3 sum(0.0);
+	glm::dmat3 outer(0.0);
+
+	occupancy.ForEachBrick(glm::ivec3(0), occupancy.GetSize() - 1, [&](const glm::ivec3& origin, uint64 bits) {
+		while (bits != 0) {
+			uint32 bit = VoxOccupancy::FirstBit(bits);
+			bits &= bits - 1;
+
+			glm::dvec3 p = (glm::dvec3(origin + VoxOccupancy::BitPosition(bit)) + 0.5) * 0.1;
+			count += 1.0;
+			sum += p;
+			outer += glm::outerProduct(p, p);
+		}
+		return true;
+	});
+
+	MassProperties mass;
+	if (count == 0.0)return mass;
+
+	glm::dvec3 center = sum / count;
+	glm::dmat3 covariance = outer - glm::outerProduct(center, center) * count;
+	double trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+
+	//Point masses around the center plus the inertia of each voxel cube (m * side^2 / 6)
+	glm::dmat3 inertia = glm::dmat3(trace + count * 0.01 / 6.0) - covariance;
+
+	mass.Mass = (float)count;
+	mass.CenterOfMass = glm::vec3(center);
+	mass.Inertia = glm::mat3(inertia);
+	return mass;
+}
+
+// Sphere of radius r against the solid voxels, all in voxel units
+// normal points out of the voxels
+static bool SphereVoxels(const VoxOccupancy& occupancy, const glm::vec3& p, float r, glm::vec3& normal, float& depth) {
+	glm::ivec3 cell = glm::ivec3(glm::floor(p));
+
+	if (occupancy.IsSolid(cell)) {
+		//Inside a voxel, push it out through the nearest face without a solid neighbor
+		float best = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++) {
+			for (int side = -1; side <= 1; side += 2) {
+				glm::ivec3 neighbor = cell;
+				neighbor[axis] += side;
+				if (occupancy.IsSolid(neighbor))continue;
+
+				float distance = side > 0 ? (float)cell[axis] + 1.0f - p[axis] : p[axis] - (float)cell[axis];
+				if (distance < best) {
+					best = distance;
+					normal = glm::vec3(0.0f);
+					normal[axis] = (float)side;
+				}
+			}
+		}
+
+		//Buried, the voxels around it will push it out
+		if (best == FLT_MAX)return false;
+
+		depth = best + r;
+		return true;
+	}
+
+	//Outside, the nearest solid voxel touching the sphere
+	glm::ivec3 lo = glm::ivec3(glm::floor(p - r));
+	glm::ivec3 hi = glm::ivec3(glm::floor(p + r));
+	float best = r * r;
+	bool found = false;
+
+	for (int32 z = lo.z; z <= hi.z; z++) {
+		for (int32 y = lo.y; y <= hi.y; y++) {
+			for (int32 x = lo.x; x <= hi.x; x++) {
+				glm::ivec3 c(x, y, z);
+				if (!occupancy.IsSolid(c))continue;
+
+				glm::vec3 d = p - glm::clamp(p, glm::vec3(c), glm::vec3(c) + 1.0f);
+				float d2 = glm::dot(d, d);
+				if (d2 < best && d2 > 0.0f) {
+					best = d2;
+					normal = d;
+					found = true;
+				}
+			}
+		}
+	}
+
+	if (!found)return false;
+
+	float distance = glm::sqrt(best);
+	normal /= distance;
+	depth = r - distance;
+	return true;
+}
+
+int32 CollideVoxels(const OBB& a, const VoxOccupancy& occupancyA, const OBB& b, const VoxOccupancy& occupancyB, int32 maxContacts, std::vector<Contact>& contacts) {
+	glm::mat4 aToWorld = glm::scale(glm::inverse(a.InvMatrix), glm::vec3(0.1f));
+	glm::mat4 worldToB = glm::scale(glm::mat4(1.0f), glm::vec3(10.0f)) * b.InvMatrix;
+	glm::mat4 aToB = worldToB * aToWorld;
+	glm::mat3 bToWorld = glm::mat3(glm::inverse(worldToB));
+
+	//Only the voxels of a inside the bounds of b, plus one voxel for the sphere radius
+	AABB bounds = AABB::FromOBB(glm::inverse(b.InvMatrix), b.Size);
+	glm::vec3 center = bounds.GetCenter();
+	glm::vec3 extent = bounds.GetExtent();
+	const glm::mat4& m = a.InvMatrix;
+	glm::vec3 localCenter = glm::vec3(m * glm::vec4(center, 1.0f)) * 10.0f;
+	glm::vec3 localExtent = (glm::abs(glm::vec3(m[0])) * extent.x + glm::abs(glm::vec3(m[1])) * extent.y + glm::abs(glm::vec3(m[2])) * extent.z) * 10.0f;
+	glm::ivec3 lo = glm::ivec3(glm::floor(localCenter - localExtent)) - 1;
+	glm::ivec3 hi = glm::ivec3(glm::floor(localCenter + localExtent)) + 1;
+
+	//Half a voxel of a in voxels of b
+	float radius = 0.5f * glm::length(glm::vec3(aToB[0]));
+	size_t first = contacts.size();
+
+	occupancyA.ForEachBrick(lo, hi, [&](const glm::ivec3& origin, uint64 bits) {
+		while (bits != 0) {
+			uint32 bit = VoxOccupancy::FirstBit(bits);
+			bits &= bits - 1;
+
+			glm::vec4 voxel = glm::vec4(glm::vec3(origin + VoxOccupancy::BitPosition(bit)) + 0.5f, 1.0f);
+			glm::vec3 normal;
+			float depth;
+			if (!SphereVoxels(occupancyB, aToB * voxel, radius, normal, depth))continue;
+
+			glm::vec3 worldNormal = bToWorld * normal;
+			float scale = glm::length(worldNormal);
+
+			Contact c;
+			c.Normal = worldNormal / scale;
+			c.Depth = depth * scale;
+			c.Point = glm::vec3(aToWorld * voxel) - c.Normal * (radius * scale);
+			contacts.push_back(c);
+		}
+		return true;
+	});
+
+	//Keep an even spread, the deepest ones are usually on the same side
+	int32 count = (int32)(contacts.size() - first);
+	if (count > maxContacts) {
+		float stride = (float)count / (float)maxContacts;
+		for (int32 i = 0; i < maxContacts; i++) {
+			contacts[first + i] = contacts[first + (size_t)(i * stride)];
+		}
+		contacts.resize(first + maxContacts);
+		count = maxContacts;
+	}
+
+	return count;
+}
+
+void IntegrateVelocity(BodyState& body, const glm::vec3& gravity, float dt) {
+	constexpr float LinearDamping = 0.05f;
+	constexpr float AngularDamping = 0.2f;
+
+	body.LinearVelocity += gravity * dt;
+	body.LinearVelocity *= 1.0f / (1.0f + dt * LinearDamping);
+	body.AngularVelocity *= 1.0f / (1.0f + dt * AngularDamping);
+}
+
+void IntegratePosition(BodyState& body, float dt) {
+	body.Position += body.LinearVelocity * dt;
+
+	glm::quat spin(0.0f, body.AngularVelocity.x, body.AngularVelocity.y, body.AngularVelocity.z);
+	body.Rotation = glm::normalize(body.Rotation + spin * body.Rotation * (0.5f * dt));
+	body.UpdateInertia();
+}
+
+static inline glm::vec3 RelativeVelocity(const BodyState& a, const BodyState* b, const Contact& c) {
+	glm::vec3 v = a.LinearVelocity + glm::cross(a.AngularVelocity, c.RA);
+	if (b) {
+		v -= b->LinearVelocity + glm::cross(b->AngularVelocity, c.RB);
+	}
+	return v;
+}
+
+static inline void ApplyImpulse(BodyState& a, BodyState* b, const Contact& c, const glm::vec3& impulse) {
+	a.LinearVelocity += impulse * a.InvMass;
+	a.AngularVelocity += a.InvInertia * glm::cross(c.RA, impulse);
+	if (b) {
+		b->LinearVelocity -= impulse * b->InvMass;
+		b->AngularVelocity -= b->InvInertia * glm::cross(c.RB, impulse);
+	}
+}
+
+void SolveContacts(BodyState* bodies, Contact* contacts, int32 count, float dt, int32 iterations) {
+	//Position error fixed per step, and the allowed penetration so resting contacts don't jitter
+	constexpr float Baumgarte = 0.2f;
+	constexpr float Slop = 0.01f;
+	constexpr float MaxBiasVelocity = 2.0f;
+
+	for (int32 i = 0; i < count; i++) {
+		Contact& c = contacts[i];
+		BodyState& a = bodies[c.A];
+		BodyState* b = c.B >= 0 ? &bodies[c.B] : nullptr;
+
+		c.RA = c.Point - a.Position;
+		c.RB = b ? c.Point - b->Position : glm::vec3(0.0f);
+
+		auto effectiveMass = [&](const glm::vec3& dir) {
+			float k = a.InvMass + glm::dot(dir, glm::cross(a.InvInertia * glm::cross(c.RA, dir), c.RA));
+			if (b) {
+				k += b->InvMass + glm::dot(dir, glm::cross(b->InvInertia * glm::cross(c.RB, dir), c.RB));
+			}
+			return k > 0.0f ? 1.0f / k : 0.0f;
+		};
+
+		const glm::vec3& n = c.Normal;
+		c.Tangent[0] = glm::abs(n.x) > 0.57f ? glm::normalize(glm::vec3(n.y, -n.x, 0.0f)) : glm::normalize(glm::vec3(0.0f, n.z, -n.y));
+		c.Tangent[1] = glm::cross(n, c.Tangent[0]);
+
+		c.NormalMass = effectiveMass(n);
+		c.TangentMass[0] = effectiveMass(c.Tangent[0]);
+		c.TangentMass[1] = effectiveMass(c.Tangent[1]);
+
+		c.Bias = glm::min(Baumgarte / dt * glm::max(c.Depth - Slop, 0.0f), MaxBiasVelocity);
+		float restitution = b ? glm::max(a.Restitution, b->Restitution) : a.Restitution;
+		float vn = glm::dot(RelativeVelocity(a, b, c), n);
+		if (vn < -1.0f) {
+			c.Bias = glm::max(c.Bias, -restitution * vn);
+		}
+
+		c.Friction = b ? glm::sqrt(a.Friction * b->Friction) : a.Friction;
+		c.NormalImpulse = 0.0f;
+		c.TangentImpulse[0] = 0.0f;
+		c.TangentImpulse[1] = 0.0f;
+	}
+
+	for (int32 iteration = 0; iteration < iterations; iteration++) {
+		for (int32 i = 0; i < count; i++) {
+			Contact& c = contacts[i];
+			BodyState& a = bodies[c.A];
+			BodyState* b = c.B >= 0 ? &bodies[c.B] : nullptr;
+
+			//Friction, limited by the normal impulse of the last iteration
+			float maxFriction = c.Friction * c.NormalImpulse;
+			for (int t = 0; t < 2; t++) {
+				float vt = glm::dot(RelativeVelocity(a, b, c), c.Tangent[t]);
+				float impulse = glm::clamp(c.TangentImpulse[t] - vt * c.TangentMass[t], -maxFriction, maxFriction);
+				float delta = impulse - c.TangentImpulse[t];
+				c.TangentImpulse[t] = impulse;
+				ApplyImpulse(a, b, c, c.Tangent[t] * delta);
+			}
+
+			//Normal, the accumulated impulse can only push
+			float vn = glm::dot(RelativeVelocity(a, b, c), c.Normal);
+			float impulse = glm::max(c.NormalImpulse + c.NormalMass * (c.Bias - vn), 0.0f);
+			float delta = impulse - c.NormalImpulse;
+			c.NormalImpulse = impulse;
+			ApplyImpulse(a, b, c, c.Normal * delta);
+		}
+	}
+}
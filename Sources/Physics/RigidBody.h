@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Geometry.h"
+#include "VoxOccupancy.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+// Mass of a voxel grid with one unit of mass per solid voxel
+// in the grid space, in meters (one voxel = 0.1)
+struct MassProperties {
+	float Mass{ 0.0f };
+	glm::vec3 CenterOfMass{ 0.0f, 0.0f, 0.0f };
+	glm::mat3 Inertia{ 0.0f }; // Around the center of mass
+
+	static MassProperties FromOccupancy(const VoxOccupancy& occupancy);
+};
+
+// A dynamic body as seen by the solver, in world space
+struct BodyState {
+	glm::vec3 Position{ 0.0f, 0.0f, 0.0f }; // Center of mass
+	glm::quat Rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+	glm::vec3 LinearVelocity{ 0.0f, 0.0f, 0.0f };
+	glm::vec3 AngularVelocity{ 0.0f, 0.0f, 0.0f };
+	float InvMass{ 0.0f };
+	glm::mat3 InvInertiaLocal{ 0.0f };
+	glm::mat3 InvInertia{ 0.0f };
+	float Friction{ 0.5f };
+	float Restitution{ 0.0f };
+	float SleepTime{ 0.0f };
+
+	void UpdateInertia() {
+		glm::mat3 r = glm::mat3_cast(Rotation);
+		InvInertia = r * InvInertiaLocal * glm::transpose(r);
+	}
+};
+
+// Contact between a body and another body or a static entity
+struct Contact {
+	int32 A{ -1 };
+	int32 B{ -1 }; // -1 when A touches a static entity
+	glm::vec3 Point{ 0.0f, 0.0f, 0.0f };
+	glm::vec3 Normal{ 0.0f, 1.0f, 0.0f }; // From B to A
+	float Depth{ 0.0f };
+
+	//Solver data
+	glm::vec3 RA, RB;
+	glm::vec3 Tangent[2];
+	float NormalMass, TangentMass[2];
+	float Bias;
+	float Friction;
+	float NormalImpulse, TangentImpulse[2];
+};
+
+// Appends the contacts of the solid voxels of a touching the solid voxels of b
+// every voxel of a is tested as a sphere against the voxel boxes of b
+// the boxes are the grid OBBs (size in meters), when more than maxContacts are found they are spread evenly
+// returns the number of contacts appended, A and B are left for the caller
+int32 CollideVoxels(const OBB& a, const VoxOccupancy& occupancyA, const OBB& b, const VoxOccupancy& occupancyB, int32 maxContacts, std::vector<Contact>& contacts);
+
+// Applies gravity and damping
+void IntegrateVelocity(BodyState& body, const glm::vec3& gravity, float dt);
+void IntegratePosition(BodyState& body, float dt);
+
+// Sequential impulses over the contacts of one island
+// only the bodies referenced by the contacts are written, so different islands can be solved in parallel
+void SolveContacts(BodyState* bodies, Contact* contacts, int32 count, float dt, int32 iterations);
@@ -0,0 +1,193 @@
+#include "VoxOccupancy.h"
+
+void VoxOccupancy::Build(const VoxGrid& grid) {
+	glm::ivec3 size = grid.GetSize();
+	_Size = size;
+	_BrickCount = (size + BrickSize - 1) / BrickSize;
+	_RegionCount = (size + RegionSize - 1) / RegionSize;
+
+	_Bricks.assign((size_t)_BrickCount.x * _BrickCount.y * _BrickCount.z, 0);
+	_Regions.assign((size_t)_RegionCount.x * _RegionCount.y * _RegionCount.z, 0);
+
+	grid.ForEachVoxel([&](const glm::ivec3& voxel, uint8) {
+		glm::ivec3 brick = voxel / BrickSize;
+		_Bricks[brick.x + brick.y * _BrickCount.x + brick.z * _BrickCount.x * _BrickCount.y] |= 1ull << BitIndex(voxel);
+	});
+
+	for (int32 z = 0; z < _BrickCount.z; z++) {
+		for (int32 y = 0; y < _BrickCount.y; y++) {
+			for (int32 x = 0; x < _BrickCount.x; x++) {
+				glm::ivec3 brick(x, y, z);
+				if (GetBrick(brick) != 0) {
+					glm::ivec3 region = brick / (RegionSize / BrickSize);
+					_Regions[region.x + region.y * _RegionCount.x + region.z * _RegionCount.x * _RegionCount.y] |= 1ull << BitIndex(brick);
+				}
+			}
+		}
+	}
+}
+
+void VoxOccupancy::Update(const VoxGrid& grid, glm::ivec3 lo, glm::ivec3 hi) {
+	lo = glm::max(lo, glm::ivec3(0));
+	hi = glm::min(hi, _Size - 1);
+	if (glm::any(glm::lessThan(hi, lo)))return;
+
+	glm::ivec3 brickLo = lo / BrickSize;
+	glm::ivec3 brickHi = hi / BrickSize;
+	for (int32 z = brickLo.z; z <= brickHi.z; z++) {
+		for (int32 y = brickLo.y; y <= brickHi.y; y++) {
+			for (int32 x = brickLo.x; x <= brickHi.x; x++) {
+				glm::ivec3 origin = glm::ivec3(x, y, z) * BrickSize;
+				uint64 bits = 0;
+				for (uint32 bit = 0; bit < 64; bit++) {
+					if (grid.Get(origin + BitPosition(bit)) != 0)bits |= 1ull << bit;
+				}
+				_Bricks[x + y * _BrickCount.x + z * _BrickCount.x * _BrickCount.y] = bits;
+			}
+		}
+	}
+
+	constexpr int32 RegionBricks = RegionSize / BrickSize;
+	glm::ivec3 regionLo = brickLo / RegionBricks;
+	glm::ivec3 regionHi = brickHi / RegionBricks;
+	for (int32 z = regionLo.z; z <= regionHi.z; z++) {
+		for (int32 y = regionLo.y; y <= regionHi.y; y++) {
+			for (int32 x = regionLo.x; x <= regionHi.x; x++) {
+				glm::ivec3 region(x, y, z);
+				glm::ivec3 first = region * RegionBricks;
+				glm::ivec3 last = glm::min(first + RegionBricks, _BrickCount) - 1;
+				uint64 bits = 0;
+				for (int32 bz = first.z; bz <= last.z; bz++) {
+					for (int32 by = first.y; by <= last.y; by++) {
+						for (int32 bx = first.x; bx <= last.x; bx++) {
+							glm::ivec3 brick(bx, by, bz);
+							if (GetBrick(brick) != 0)bits |= 1ull << BitIndex(brick);
+						}
+					}
+				}
+				_Regions[x + y * _RegionCount.x + z * _RegionCount.x * _RegionCount.y] = bits;
+			}
+		}
+	}
+}
+
+bool VoxOccupancy::Overlaps(const glm::ivec3& lo, const glm::ivec3& hi) const {
+	bool found = false;
+	ForEachBrick(lo, hi, [&](const glm::ivec3&, uint64) {
+		found = true;
+		return false;
+	});
+	return found;
+}
+
+// Clips the ray against the grid bounds
+static bool ClipRay(const glm::vec3& origin, const glm::vec3& invDir, const glm::vec3& size, float maxT, float& tEnter) {
+	glm::vec3 t1 = -origin * invDir;
+	glm::vec3 t2 = (size - origin) * invDir;
+	glm::vec3 tNear = glm::min(t1, t2);
+	glm::vec3 tFar = glm::max(t1, t2);
+	tEnter = glm::max(glm::max(glm::max(tNear.x, tNear.y), tNear.z), 0.0f);
+	float tExit = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+	return tEnter <= tExit && tEnter <= maxT;
+}
+
+// Aligned directions (zeroes in dir) would generate NaNs
+static glm::vec3 SafeDirection(glm::vec3 dir) {
+	if (dir.x == 0.0f)dir.x = 0.00000001f;
+	if (dir.y == 0.0f)dir.y = 0.00000001f;
+	if (dir.z == 0.0f)dir.z = 0.00000001f;
+	return dir;
+}
+
+bool VoxOccupancy::_Traverse(int32 level, glm::ivec3 lo, glm::ivec3 hi, float tStart, float maxT, const glm::vec3& origin, const glm::vec3& invDir, const glm::ivec3& step, float& t, glm::ivec3& voxel) const {
+	const int32 cellSize = level == 0 ? RegionSize : (level == 1 ? BrickSize : 1);
+
+	//Find the entry cell, clamped so float errors can't leave the parent cell
+	glm::vec3 p = origin + tStart / invDir;
+	glm::ivec3 cell = glm::clamp(glm::ivec3(glm::floor(p / (float)cellSize)), lo, hi);
+
+	glm::vec3 next = glm::vec3(cell + glm::max(step, glm::ivec3(0))) * (float)cellSize;
+	glm::vec3 tMax = (next - origin) * invDir;
+	glm::vec3 tDelta = glm::abs(invDir) * (float)cellSize;
+
+	float tCurrent = tStart;
+	while (true) {
+		bool occupied;
+		if (level == 0) {
+			occupied = GetRegion(cell) != 0;
+		}
+		else if (level == 1) {
+			occupied = (GetRegion(cell / 4) >> BitIndex(cell)) & 1;
+		}
+		else {
+			occupied = (GetBrick(cell / 4) >> BitIndex(cell)) & 1;
+		}
+
+		if (occupied) {
+			if (level == 2) {
+				t = tCurrent;
+				voxel = cell;
+				return true;
+			}
+
+			glm::ivec3 childLo = cell * 4;
+			glm::ivec3 childHi = glm::min(childLo + 3, (level == 0 ? _BrickCount : _Size) - 1);
+
+			//Regions can overhang the grid, then the ray has to be clipped to the part inside it
+			float tChild = tCurrent;
+			bool inside = true;
+			if (childHi != childLo + 3) {
+				float childSize = (float)(cellSize / 4);
+				glm::vec3 t1 = (glm::vec3(childLo) * childSize - origin) * invDir;
+				glm::vec3 t2 = (glm::vec3(childHi + 1) * childSize - origin) * invDir;
+				glm::vec3 tNear = glm::min(t1, t2);
+				glm::vec3 tFar = glm::max(t1, t2);
+				tChild = glm::max(glm::max(glm::max(tNear.x, tNear.y), tNear.z), tCurrent);
+				inside = tChild <= glm::min(glm::min(glm::min(tFar.x, tFar.y), tFar.z), maxT);
+			}
+
+			if (inside && _Traverse(level + 1, childLo, childHi, tChild, maxT, origin, invDir, step, t, voxel)) {
+				return true;
+			}
+		}
+
+		//Step to the next cell
+		int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+		tCurrent = tMax[axis];
+		if (tCurrent > maxT) {
+			return false;
+		}
+
+		cell[axis] += step[axis];
+		if (cell[axis] < lo[axis] || cell[axis] > hi[axis]) {
+			return false;
+		}
+		tMax[axis] += tDelta[axis];
+	}
+}
+
+bool VoxOccupancy::RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& t, glm::ivec3& voxel) const {
+	if (_Regions.empty())return false;
+
+	glm::vec3 safeDir = SafeDirection(dir);
+	glm::vec3 invDir = 1.0f / safeDir;
+	glm::ivec3 step = glm::ivec3(glm::sign(safeDir));
+
+	float tEnter;
+	if (!ClipRay(origin, invDir, glm::vec3(_Size), maxT, tEnter))return false;
+
+	return _Traverse(0, glm::ivec3(0), _RegionCount - 1, tEnter, maxT, origin, invDir, step, t, voxel);
+}
+
+bool VoxOccupancy::RayCastReference(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& t, glm::ivec3& voxel) const {
+	if (_Regions.empty())return false;
+
+	glm::vec3 safeDir = SafeDirection(dir);
+	glm::vec3 invDir = 1.0f / safeDir;
+	glm::ivec3 step = glm::ivec3(glm::sign(safeDir));
+
+	float tEnter;
+	if (!ClipRay(origin, invDir, glm::vec3(_Size), maxT, tEnter))return false;
+
+	return _Traverse(2, glm::ivec3(0), _Size - 1, tEnter, maxT, origin, invDir, step, t, voxel);
+}
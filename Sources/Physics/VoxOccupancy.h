@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Vox/VoxGrid.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// CPU occupancy pyramid of a voxel grid, used to skip empty space
+//
+// Level 2: one bit per voxel, packed in 4x4x4 bricks (one uint64 per brick)
+// Level 1: one bit per brick, packed in 16x16x16 regions (one uint64 per region)
+// Level 0: the region is empty when its uint64 is zero
+class VoxOccupancy {
+public:
+	inline static constexpr int32 BrickSize = 4;
+	inline static constexpr int32 RegionSize = 16;
+
+private:
+	glm::ivec3 _Size{ 0, 0, 0 };
+	glm::ivec3 _BrickCount{ 0, 0, 0 };
+	glm::ivec3 _RegionCount{ 0, 0, 0 };
+	std::vector<uint64> _Bricks;
+	std::vector<uint64> _Regions;
+
+	// Bit index of a cell inside its 4x4x4 parent
+	static inline uint32 BitIndex(const glm::ivec3& p) {
+		return (p.x & 3) | ((p.y & 3) << 2) | ((p.z & 3) << 4);
+	}
+
+	// Bits of the cells in [lo, hi] (inclusive, 0 to 3) inside a 4x4x4 brick
+	static inline uint64 RangeMask(const glm::ivec3& lo, const glm::ivec3& hi) {
+		auto bits = [](int32 a, int32 b) { return ((2u << b) - 1) & ~((1u << a) - 1); };
+		uint32 x = bits(lo.x, hi.x);
+		uint32 y = bits(lo.y, hi.y);
+		uint32 z = bits(lo.z, hi.z);
+
+		//Every x nibble, the y nibbles of every 16 bits z slice, and the z slices
+		uint64 mx = (uint64)x * 0x1111111111111111ull;
+		uint64 my = (uint64)((y & 1 ? 0x000F : 0) | (y & 2 ? 0x00F0 : 0) | (y & 4 ? 0x0F00 : 0) | (y & 8 ? 0xF000 : 0)) * 0x0001000100010001ull;
+		uint64 mz = (z & 1 ? 0x000000000000FFFFull : 0) | (z & 2 ? 0x00000000FFFF0000ull : 0) | (z & 4 ? 0x0000FFFF00000000ull : 0) | (z & 8 ? 0xFFFF000000000000ull : 0);
+		return mx & my & mz;
+	}
+
+	bool _Traverse(int32 level, glm::ivec3 lo, glm::ivec3 hi, float tStart, float maxT, const glm::vec3& origin, const glm::vec3& invDir, const glm::ivec3& step, float& t, glm::ivec3& voxel) const;
+
+public:
+
+	// Builds the pyramid from the occupied voxels of the grid
+	void Build(const VoxGrid& grid);
+	// Rebuilds the bricks and regions touching [lo, hi] (inclusive, in voxels) after the grid changed there
+	void Update(const VoxGrid& grid, glm::ivec3 lo, glm::ivec3 hi);
+
+	glm::ivec3 GetSize() const { return _Size; }
+	glm::ivec3 GetBrickCount() const { return _BrickCount; }
+
+	inline uint64 GetBrick(const glm::ivec3& brick) const {
+		return _Bricks[brick.x + brick.y * _BrickCount.x + brick.z * _BrickCount.x * _BrickCount.y];
+	}
+	inline uint64 GetRegion(const glm::ivec3& region) const {
+		return _Regions[region.x + region.y * _RegionCount.x + region.z * _RegionCount.x * _RegionCount.y];
+	}
+
+	inline bool IsSolid(const glm::ivec3& voxel) const {
+		if (glm::any(glm::lessThan(voxel, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(voxel, _Size)))return false;
+		return (GetBrick(voxel / BrickSize) >> BitIndex(voxel)) & 1;
+	}
+
+	// Calls callback(glm::ivec3 brickOrigin, uint64 bits) for every brick with solid voxels in [lo, hi]
+	// (inclusive, in voxels, clamped to the grid), bits only has the voxels inside the range
+	// return false in the callback to stop
+	template<typename T>
+	void ForEachBrick(glm::ivec3 lo, glm::ivec3 hi, T callback) const {
+		lo = glm::max(lo, glm::ivec3(0));
+		hi = glm::min(hi, _Size - 1);
+		if (glm::any(glm::lessThan(hi, lo)))return;
+
+		glm::ivec3 brickLo = lo / BrickSize;
+		glm::ivec3 brickHi = hi / BrickSize;
+
+		for (int32 z = brickLo.z; z <= brickHi.z; z++) {
+			for (int32 y = brickLo.y; y <= brickHi.y; y++) {
+				for (int32 x = brickLo.x; x <= brickHi.x; x++) {
+					glm::ivec3 brick(x, y, z);
+					uint64 bits = GetBrick(brick);
+					if (bits == 0)continue;
+
+					glm::ivec3 origin = brick * BrickSize;
+					bits &= RangeMask(glm::max(lo - origin, glm::ivec3(0)), glm::min(hi - origin, glm::ivec3(BrickSize - 1)));
+					if (bits != 0 && !callback(origin, bits)) {
+						return;
+					}
+				}
+			}
+		}
+	}
+
+	// Tells if any voxel in [lo, hi] (inclusive, in voxels) is solid, the range is clamped to the grid
+	bool Overlaps(const glm::ivec3& lo, const glm::ivec3& hi) const;
+
+	// Position of a voxel bit inside its brick
+	static inline glm::ivec3 BitPosition(uint32 bit) {
+		return glm::ivec3(bit & 3, (bit >> 2) & 3, bit >> 4);
+	}
+	static inline uint32 FirstBit(uint64 bits) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+	static inline uint32 CountBits(uint64 bits) {
+#ifdef _MSC_VER
+		return (uint32)__popcnt64(bits);
+#else
+		return __builtin_popcountll(bits);
+#endif
+	}
+
+	// Hierarchical DDA in voxel space (one unit = one voxel), dir doesn't need to be normalized
+	// returns the t where the ray enters the first solid voxel, a ray starting inside a solid voxel hits it at t = 0
+	bool RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& t, glm::ivec3& voxel) const;
+
+	// Same as RayCast but steps every voxel without skipping empty space
+	// Used as reference to check RayCast and to measure it, see Tests/VoxOccupancyTests.cpp
+	bool RayCastReference(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& t, glm::ivec3& voxel) const;
+};
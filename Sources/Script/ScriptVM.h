@@ -126,23 +126,23 @@ public:
             return *this;
         }
 
-        template<auto Field>
+        template<auto Member>
         ForeignClassContext& Field(const char* name) {
-            using FieldType = typename MemberFieldDetail<decltype(Field), Field>::FieldType;
+            using FieldType = typename MemberFieldDetail<decltype(Member), Member>::FieldType;
             // Get
             Method(name, [](WrenVM* vm) {
                 Base* Obj = (Base*)wrenGetSlotForeign(vm, 0);
                 if constexpr (std::is_same_v<FieldType, float> || std::is_same_v<FieldType, double> || std::is_same_v<FieldType, int>) {
-                    wrenSetSlotDouble(vm, 0, Obj->*Field);
+                    wrenSetSlotDouble(vm, 0, Obj->*Member);
                 }
                 else if constexpr (std::is_same_v<FieldType, std::string>) {
-                    wrenSetSlotString(vm, 0, Obj->*Field.c_str());
+                    wrenSetSlotString(vm, 0, (Obj->*Member).c_str());
                 }
                 else if constexpr (std::is_same_v<FieldType, bool>) {
-                    wrenSetSlotBool(vm, 0, Obj->*Field);
+                    wrenSetSlotBool(vm, 0, Obj->*Member);
                 }
                 else {
-                    static_assert(false, "Failed to resolve Var type");
+                    static_assert(sizeof(FieldType) == 0, "Failed to resolve Var type");
                 }
             });
 
@@ -150,16 +150,16 @@ public:
             Method((std::string(name) + "=(_)").c_str(), [](WrenVM* vm) {
                 Base* Obj = (Base*)wrenGetSlotForeign(vm, 0);
                 if constexpr (std::is_same_v<FieldType, float> || std::is_same_v<FieldType, double> || std::is_same_v<FieldType, int>) {
-                    Obj->*Field = wrenGetSlotDouble(vm, 1);
+                    Obj->*Member = wrenGetSlotDouble(vm, 1);
                 }
                 else if constexpr (std::is_same_v<FieldType, std::string>) {
-                    Obj->*Field = wrenGetSlotString(vm, 1);
+                    Obj->*Member = wrenGetSlotString(vm, 1);
                 }
                 else if constexpr (std::is_same_v<FieldType, bool>) {
-                    Obj->*Field = wrenGetSlotBool(vm, 1);
+                    Obj->*Member = wrenGetSlotBool(vm, 1);
                 }
                 else {
-                    static_assert(false, "Failed to resolve Var type");
+                    static_assert(sizeof(FieldType) == 0, "Failed to resolve Var type");
                 }
             });
 
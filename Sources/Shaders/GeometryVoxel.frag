@@ -9,6 +9,7 @@ layout(push_constant) uniform uPushConstant{
     int VoxCmdIndex;
 };
 
+// A mip is used from 1000 voxels away per mip, VoxAsset::SelectLod picks the same level
 #define LOD 1
 //not Including the mip zero 
 #define MIP_COUNT 2
@@ -109,7 +109,7 @@ VoxCmd GetVoxCmd(int index) { return VoxCmdsBuffer[_VoxCmdsBufferRID].Cmds[index
 #define PALLETE_COLOR_TEXTURE _BindingSampler2D[ViewBuffer[_ViewBufferRID]._PalleteColorRID]
 #define PALLETE_MATERIAL_TEXTURE _BindingSampler2D[ViewBuffer[_ViewBufferRID]._PalleteMaterialRID]
 #define VOLUME_TEXTURE _BindingUSampler3D[_VolumeRID]
-#define SHADOW_VOX_TEXTURE _BindingUSampler3D[_ShadowVoxRID]
+#define SHADOW_VOX_TEXTURE _BindingUSampler3D[ShadowVoxBuffer[_ShadowVoxRID].AtlasRID]
 #define SKY_BOX_TEXTURE _BindingSamplerCube[_SkyBoxTextureRID]
 
 #endif
\ No newline at end of file
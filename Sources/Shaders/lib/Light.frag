@@ -11,72 +11,156 @@ const int _ShadowVoxRID = 0;
 #endif
 
 
-bool getVolumeAt(ivec3 pos, int mip){
-	int bit = (pos.x & 1) | ((pos.y & 1) << 1) | ((pos.z & 1) << 2);
-	int mask = 1 << bit;
-    pos /= 2;
+// Must match ShadowVolume, the build passes its values as SHADOW_VOLUME_* to check them
+#define SHADOW_VOX_LEVELS 4
+#define SHADOW_VOX_WINDOW 32
+#define SHADOW_VOX_BRICK_SHIFT 4
+#define SHADOW_VOX_MAX_MIP 4
+
+#if defined(SHADOW_VOLUME_LEVELCOUNT) && SHADOW_VOLUME_LEVELCOUNT != SHADOW_VOX_LEVELS
+#error SHADOW_VOX_LEVELS must match ShadowVolume::LevelCount
+#endif
+#if defined(SHADOW_VOLUME_WINDOWSIZE) && SHADOW_VOLUME_WINDOWSIZE != SHADOW_VOX_WINDOW
+#error SHADOW_VOX_WINDOW must match ShadowVolume::WindowSize
+#endif
+#if defined(SHADOW_VOLUME_BRICKSHIFT) && SHADOW_VOLUME_BRICKSHIFT != SHADOW_VOX_BRICK_SHIFT
+#error SHADOW_VOX_BRICK_SHIFT must match ShadowVolume::BrickShift
+#endif
+#if defined(SHADOW_VOLUME_MAXMIP) && SHADOW_VOLUME_MAXMIP != SHADOW_VOX_MAX_MIP
+#error SHADOW_VOX_MAX_MIP must match ShadowVolume::MaxMip
+#endif
 
-    int realMip = mip/2;
-    uint voxel = texelFetch(SHADOW_VOX_TEXTURE, pos, realMip).r;
+//ShadowVoxBuffer (requires: _ShadowVoxRID)
+// Origins has the first brick of the window of every level, Pages the atlas brick of every window slot (-1 when empty)
+BINDING_BUFFER(ShadowVoxBuffer, \
+    int AtlasRID;               \
+    int MasksRID;               \
+    int Pad1;                   \
+    int Pad2;                   \
+    ivec4 Origins[SHADOW_VOX_LEVELS]; \
+    int Pages[];                \
+)
+
+// Bit x + y*4 + z*16 of every atlas brick is set when its block of 4^3 cells has any cell set
+BINDING_BUFFER(ShadowVoxMasksBuffer, \
+    uvec2 Masks[];                   \
+)
+
+// Finest level with the cell inside its window, pos in cells of the first level (0.1)
+// cell is pos in cells of that level
+bool getVolumeLevel(ivec3 pos, out int level, out ivec3 cell){
+    for(level = 0; level < SHADOW_VOX_LEVELS; level++){
+        cell = pos >> level;
+        ivec3 brick = (cell >> SHADOW_VOX_BRICK_SHIFT) - ShadowVoxBuffer[_ShadowVoxRID].Origins[level].xyz;
+        if(all(greaterThanEqual(brick, ivec3(0))) && all(lessThan(brick, ivec3(SHADOW_VOX_WINDOW)))){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tells if pos (in cells of the first level) is inside the coarsest window
+bool insideShadowVolume(ivec3 pos){
+    int level = SHADOW_VOX_LEVELS - 1;
+    ivec3 brick = (pos >> (level + SHADOW_VOX_BRICK_SHIFT)) - ShadowVoxBuffer[_ShadowVoxRID].Origins[level].xyz;
+    return all(greaterThanEqual(brick, ivec3(0))) && all(lessThan(brick, ivec3(SHADOW_VOX_WINDOW)));
+}
+
+// Page of the brick with the cell of the level, -1 when empty
+int getVolumePage(int level, ivec3 cell){
+    ivec3 slot = (cell >> SHADOW_VOX_BRICK_SHIFT) & (SHADOW_VOX_WINDOW - 1);
+    return ShadowVoxBuffer[_ShadowVoxRID].Pages[level * SHADOW_VOX_WINDOW * SHADOW_VOX_WINDOW * SHADOW_VOX_WINDOW + slot.x + slot.y * SHADOW_VOX_WINDOW + slot.z * SHADOW_VOX_WINDOW * SHADOW_VOX_WINDOW];
+}
+
+// Byte of 2x2x2 cells with the cell, the bit of the cell in bit
+uint getVolumeByte(ivec3 pos, out int bit){
+    int level;
+    ivec3 cell;
+    bit = 0;
+    if(!getVolumeLevel(pos, level, cell)){ return 0u; }
+
+    int page = getVolumePage(level, cell);
+    if(page < 0){ return 0u; }
+
+    bit = (cell.x & 1) | ((cell.y & 1) << 1) | ((cell.z & 1) << 2);
+    ivec3 atlas = ivec3(page & 15, (page >> 4) & 15, page >> 8) * 8 + ((cell >> 1) & 7);
+    return texelFetch(SHADOW_VOX_TEXTURE, atlas, 0).r;
+}
+
+// pos in cells of the first level, far from the camera the cells of the coarse levels are used
+// odd mips tell if any cell of the byte is set
+bool getVolumeAt(ivec3 pos, int mip){
+    int bit;
+    uint voxel = getVolumeByte(pos, bit);
 
     if(mip % 2 == 1){
         return voxel != 0;
     } else {
-        return (voxel & mask) != 0;
+        return (voxel & (1u << bit)) != 0;
     }
 }
 
-bool raycastShadowVolume(vec3 origin, vec3 direction, float maxt, out vec3 hit, out vec3 normal){
-    ivec3 u_VolumeDimension = textureSize(SHADOW_VOX_TEXTURE, 0);
+// Tells if any cell of the block is set, block is in cells of the first level divided by 2^mip
+// mip 1 reads the bytes, 2 and 3 the brick masks and 4 the pages
+bool getVolumeMip(ivec3 block, int mip){
+    int level;
+    ivec3 cell;
+    if(!getVolumeLevel(block << mip, level, cell)){ return false; }
+
+    int page = getVolumePage(level, cell);
+    if(page < 0){ return false; }
+
+    //Blocks smaller than the cells of the level are answered by their cell
+    int levelMip = mip - level;
+    if(levelMip <= 1){
+        return getVolumeAt(block << mip, levelMip <= 0 ? 0 : 1);
+    }
+    if(levelMip >= SHADOW_VOX_MAX_MIP){ return true; }
 
+    uvec2 mask = ShadowVoxMasksBuffer[ShadowVoxBuffer[_ShadowVoxRID].MasksRID].Masks[page];
+    ivec3 local = (cell & 15) >> levelMip;
+    if(levelMip == 2){
+        int bit = local.x + local.y * 4 + local.z * 16;
+        return ((bit < 32 ? mask.x : mask.y) & (1u << (bit & 31))) != 0;
+    }
+    return ((local.z == 0 ? mask.x : mask.y) & (0x00330033u << (local.x * 2 + local.y * 8))) != 0;
+}
+
+// Walks the blocks of the occupancy mips, going up while they are empty and down when they aren't
+// origin, hit and maxt are in cells of the first level (0.1)
+bool raycastShadowVolume(vec3 origin, vec3 direction, float maxt, out vec3 hit, out vec3 normal){
     vec3 stepSign = sign(direction);
-    vec3 t_delta = 1.0/(direction*stepSign);
+    vec3 upper = step(0.0, direction);
+    vec3 invDir = 1.0/max(abs(direction), vec3(0.00000001));
 
-    int mip = 0;
-    
+    int mip = SHADOW_VOX_MAX_MIP;
+    float t = 0.0;
+    vec3 select = vec3(0.0);
+    normal = vec3(0.0);
 
-    int i = 0, nt = 0;
-    float totalt = 0.0;
-    do{
-        float mipSize = float(1 << mip);
+    for(int i = 0; i < 512 && t < maxt; i++){
+        vec3 pos = origin + direction*t;
+        ivec3 block = ivec3(floor(pos)) >> mip;
 
-        origin /= mipSize;
-        ivec3 current_voxel = ivec3(floor(origin));
-        vec3 next_voxel_bounds = vec3(current_voxel) + (stepSign*0.5 + 0.5);
-        vec3 t_max = (next_voxel_bounds - origin)/direction;
-        
-        int n = 0;
-        
-        do{
-            vec3 select = step(t_max.xyz, t_max.zxy) * step(t_max.xyz, t_max.yzx);
-            
-            if(clamp(current_voxel, ivec3(0), ivec3(u_VolumeDimension/mipSize)*2+1) != current_voxel){ return false; }
+        if(!insideShadowVolume(block << mip)){ return false; }
 
-            bool voxel = getVolumeAt(ivec3(current_voxel), mip);
-            
-            float best_t = dot(t_max, select);
-            if(voxel){
-                
-                if(mip == 0){
-                    normal = -stepSign * select;
-                    hit = (origin + direction*best_t)*mipSize;
-                    return true;
-                } else {
-                    mip--;
-                    origin = origin + direction*best_t/mipSize;
-                    break;
-                }
+        if(getVolumeMip(block, mip)){
+            if(mip == 0){
+                normal = -stepSign * select;
+                hit = pos;
+                return true;
             }
-            
-            current_voxel += ivec3(select*stepSign);
-            t_max += t_delta * select;
-            totalt = best_t;
-            nt++;
-        }while(++n < 256 && totalt < maxt);
-
-        origin *= mipSize;
+            mip--;
+            continue;
+        }
 
-    }while(++i < 4);
+        //Exit of the block, a bit past it so the next one is the neighbor
+        vec3 bounds = (vec3(block) + upper) * float(1 << mip);
+        vec3 t_max = abs(bounds - origin) * invDir;
+        select = step(t_max.xyz, t_max.zxy) * step(t_max.xyz, t_max.yzx);
+        t = min(t_max.x, min(t_max.y, t_max.z)) + 0.001;
+        mip = min(mip + 1, SHADOW_VOX_MAX_MIP);
+    }
     return false;
 }
 /*
@@ -136,17 +220,7 @@ float raycastShadowVolumeSparse(vec3 origin, vec3 dir, float dist) {
     float d = stepFactor;
 
     while(d < 16.0){
-        #if 0
-            bool voxel = getVolumeAt(ivec3(pos), 0);
-        #else
-            uint vol = texelFetch(SHADOW_VOX_TEXTURE, ivec3(pos/2), 0).r;
-            uint bit = 0u;
-            bit += mod(pos.x, 0.5) > 0.25 ? 1u : 0u;
-            bit += mod(pos.y, 0.5) > 0.25 ? 2u : 0u;
-            bit += mod(pos.z, 0.5) > 0.25 ? 4u : 0u;
-            uint mask = 1u << bit;
-            bool voxel = (mask & vol) != 0;
-        #endif
+        bool voxel = getVolumeAt(ivec3(floor(pos)), 0);
 
         if(voxel) {
             return d;
@@ -159,7 +233,7 @@ float raycastShadowVolumeSparse(vec3 origin, vec3 dir, float dist) {
     stepDir *= 2.0;
     float lod1MaxT = min(dist, 164.0);
     while(d < lod1MaxT){//TODO: lower this when implemented New Lod
-        bool voxel = getVolumeAt(ivec3(pos), 1);
+        bool voxel = getVolumeAt(ivec3(floor(pos)), 1);
         if(voxel)
             return d;
         
@@ -180,17 +254,7 @@ float raycastShadowVolumeSuperSparse(vec3 origin, vec3 dir, float dist) {
     float d = stepFactor;
 
     while(d < 16.0){
-        #if 0
-            bool voxel = getVolumeAt(ivec3(pos), 0);
-        #else
-            uint vol = texelFetch(SHADOW_VOX_TEXTURE, ivec3(pos/2), 0).r;
-            uint bit = 0u;
-            bit += mod(pos.x, 0.5) > 0.25 ? 1u : 0u;
-            bit += mod(pos.y, 0.5) > 0.25 ? 2u : 0u;
-            bit += mod(pos.z, 0.5) > 0.25 ? 4u : 0u;
-            uint mask = 1u << bit;
-            bool voxel = (mask & vol) != 0;
-        #endif
+        bool voxel = getVolumeAt(ivec3(floor(pos)), 0);
 
         if(voxel) {
             return d;
@@ -203,7 +267,7 @@ float raycastShadowVolumeSuperSparse(vec3 origin, vec3 dir, float dist) {
     stepDir *= 2.0;
     float lod1MaxT = min(dist, 164.0);
     while(d < lod1MaxT){//TODO: lower this when implemented New Lod
-        bool voxel = getVolumeAt(ivec3(pos), 1);
+        bool voxel = getVolumeAt(ivec3(floor(pos)), 1);
         if(voxel)
             return d;
         
@@ -0,0 +1,109 @@
+#include "Tests.h"
+
+#include "Physics/AABBTree.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+
+// Boxes of 0.5 to 4 units spread with the same density for every count, like the props of a world
+static std::vector<AABB> RandomBoxes(std::mt19937& random, int32 count, float side) {
+	std::uniform_real_distribution<float> position(0.0f, side);
+	std::uniform_real_distribution<float> extent(0.25f, 2.0f);
+	std::vector<AABB> boxes(count);
+	for (AABB& box : boxes) {
+		glm::vec3 center(position(random), position(random), position(random));
+		glm::vec3 half(extent(random), extent(random), extent(random));
+		box = AABB(center - half, center + half);
+	}
+	return boxes;
+}
+
+// Tree against testing every box, for the ray, box, sphere and frustum queries and the moves of 10% of the boxes every frame
+// the hits of both are compared, so it also checks the tree
+BENCH(AABBTree) {
+	std::mt19937 random(26);
+	for (int32 count : { 10000, 100000, 1000000 }) {
+		float side = std::cbrt((float)count) * 10.0f;
+		std::vector<AABB> boxes = RandomBoxes(random, count, side);
+
+		AABBTree tree;
+		std::vector<int32> proxies(count);
+		double build = Tests::Measure(1, [&]() {
+			for (int32 i = 0; i < count; i++) {
+				proxies[i] = tree.Insert(boxes[i], i);
+			}
+		});
+
+		std::uniform_real_distribution<float> step(-0.3f, 0.3f);
+		std::uniform_int_distribution<int32> pick(0, count - 1);
+		constexpr int32 Frames = 10;
+		double move = Tests::Measure(Frames, [&]() {
+			for (int32 i = 0; i < count / 10; i++) {
+				int32 index = pick(random);
+				glm::vec3 delta(step(random), step(random), step(random));
+				boxes[index] = AABB(boxes[index].Min + delta, boxes[index].Max + delta);
+				tree.Move(proxies[index], boxes[index]);
+			}
+		});
+
+		//Brute force over the fat boxes, the ones the tree tests
+		std::vector<AABB> fat(count);
+		for (int32 i = 0; i < count; i++) {
+			fat[i] = tree.GetFatAABB(proxies[i]);
+		}
+
+		constexpr int32 Queries = 100;
+		std::uniform_real_distribution<float> position(0.0f, side);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		std::vector<Ray> rays(Queries);
+		std::vector<AABB> regions(Queries);
+		std::vector<Frustum> frustums(Queries);
+		for (int32 i = 0; i < Queries; i++) {
+			glm::vec3 origin(position(random), position(random), position(random));
+			glm::vec3 dir = glm::normalize(glm::vec3(direction(random), direction(random), direction(random)) + glm::vec3(0.0f, 0.0f, 0.001f));
+			rays[i] = Ray(origin, dir, 100.0f);
+			regions[i] = AABB(origin - glm::vec3(5.0f), origin + glm::vec3(5.0f));
+			frustums[i] = Frustum::FromMatrix(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * glm::lookAt(origin, origin + dir, glm::vec3(0, 1, 0)));
+		}
+
+		uint64 treeHits = 0;
+		uint64 bruteHits = 0;
+		auto countHit = [&](int32) { treeHits++; return true; };
+
+		double treeRay = Tests::Measure(1, [&]() {
+			for (const Ray& ray : rays) {
+				tree.RayCast(ray.Origin, ray.Direction, ray.MaxT, [&](int32, float maxT) { treeHits++; return maxT; });
+			}
+		});
+		double bruteRay = Tests::Measure(1, [&]() {
+			for (const Ray& ray : rays) {
+				glm::vec3 invDir = 1.0f / ray.Direction;
+				float t;
+				for (const AABB& box : fat) bruteHits += box.RayCast(ray.Origin, invDir, ray.MaxT, t);
+			}
+		});
+		TEST_CHECK(treeHits == bruteHits, "{} boxes, ray hits {} != {}", count, treeHits, bruteHits);
+
+		treeHits = bruteHits = 0;
+		double treeBox = Tests::Measure(1, [&]() { for (const AABB& region : regions) tree.Query(region, countHit); });
+		double bruteBox = Tests::Measure(1, [&]() { for (const AABB& region : regions) for (const AABB& box : fat) bruteHits += box.Overlaps(region); });
+		TEST_CHECK(treeHits == bruteHits, "{} boxes, box hits {} != {}", count, treeHits, bruteHits);
+
+		treeHits = bruteHits = 0;
+		double treeSphere = Tests::Measure(1, [&]() { for (const AABB& region : regions) tree.QuerySphere(region.GetCenter(), 5.0f, countHit); });
+		double bruteSphere = Tests::Measure(1, [&]() { for (const AABB& region : regions) for (const AABB& box : fat) bruteHits += box.OverlapsSphere(region.GetCenter(), 5.0f); });
+		TEST_CHECK(treeHits == bruteHits, "{} boxes, sphere hits {} != {}", count, treeHits, bruteHits);
+
+		treeHits = bruteHits = 0;
+		double treeFrustum = Tests::Measure(1, [&]() { for (const Frustum& frustum : frustums) tree.QueryFrustum(frustum, countHit); });
+		double bruteFrustum = Tests::Measure(1, [&]() { for (const Frustum& frustum : frustums) for (const AABB& box : fat) bruteHits += frustum.Overlaps(box); });
+		TEST_CHECK(treeHits == bruteHits, "{} boxes, frustum hits {} != {}", count, treeHits, bruteHits);
+
+		Log::info("[Bench] AABBTree {} boxes, height {}: build {:.1f}ms, move 10% {:.2f}ms per frame", count, tree.GetHeight(), build, move);
+		Log::info("[Bench]   per query (tree / brute force): ray {:.1f}us / {:.1f}us, box {:.1f}us / {:.1f}us, sphere {:.1f}us / {:.1f}us, frustum {:.1f}us / {:.1f}us",
+			treeRay * 1000.0 / Queries, bruteRay * 1000.0 / Queries, treeBox * 1000.0 / Queries, bruteBox * 1000.0 / Queries,
+			treeSphere * 1000.0 / Queries, bruteSphere * 1000.0 / Queries, treeFrustum * 1000.0 / Queries, bruteFrustum * 1000.0 / Queries);
+	}
+	return true;
+}
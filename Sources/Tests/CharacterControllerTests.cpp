@@ -0,0 +1,129 @@
+#include "Tests.h"
+
+#include "Asset/VoxAsset.h"
+#include "Job/Jobs.h"
+#include "World/Components.h"
+#include "World/World.h"
+#include "World/Systems/PhysicsSystem.h"
+#include "World/Systems/TransformSystem.h"
+
+#include <random>
+
+// Tile of 12.8m with a floor 0.4m thick, steps of 0.3m to climb and pillars of 1.2m to slide along
+static AssetRefT<VoxAsset> CreateTile(std::mt19937& random) {
+	VoxGrid grid{ glm::ivec3(128, 16, 128) };
+	auto fill = [&](const glm::ivec3& min, const glm::ivec3& max) {
+		for (int32 z = min.z; z < max.z; z++) {
+			for (int32 y = min.y; y < max.y; y++) {
+				for (int32 x = min.x; x < max.x; x++) {
+					grid.Set(glm::ivec3(x, y, z), 1);
+				}
+			}
+		}
+	};
+	fill(glm::ivec3(0), glm::ivec3(128, 4, 128));
+
+	std::uniform_int_distribution<int32> position(0, 112);
+	std::uniform_int_distribution<int32> side(4, 16);
+	for (int32 i = 0; i < 12; i++) {
+		glm::ivec3 min(position(random), 4, position(random));
+		fill(min, min + glm::ivec3(side(random), 3, side(random)));
+	}
+	for (int32 i = 0; i < 6; i++) {
+		glm::ivec3 min(position(random), 4, position(random));
+		fill(min, min + glm::ivec3(4, 12, 4));
+	}
+
+	AssetRefT<VoxAsset> asset = new VoxAsset(std::move(grid));
+	asset->Upload();
+	return asset;
+}
+
+// 500 agents walking over 4x4 tiles, every frame is a parallel UpdateControllers
+// once they stop all of them have to be on the ground, none fell through the floor
+BENCH(CharacterController) {
+	constexpr int32 AgentCount = 500;
+	constexpr int32 Tiles = 4;
+	constexpr float TileSize = 12.8f;
+	constexpr float Floor = 0.4f;
+	constexpr float dt = 1.0f / 60.0f;
+
+	std::mt19937 random(31);
+	World world;
+	world.SetSimulate(true);
+	entt::registry& R = world.GetRegistry();
+
+	//Without Hierarchy the entities are in world space
+	AssetRefT<VoxAsset> tile = CreateTile(random);
+	for (int32 z = 0; z < Tiles; z++) {
+		for (int32 x = 0; x < Tiles; x++) {
+			entt::entity e = R.create();
+			Transform t;
+			t.Position = glm::vec3(x * TileSize, 0.0f, z * TileSize);
+			R.emplace<Transform>(e, t);
+			VoxRenderer vr;
+			vr.Vox = tile;
+			R.emplace<VoxRenderer>(e, vr);
+		}
+	}
+	world.Physics->UpdateBroadphase();
+
+	//Spawned over the pillars, they fall and then walk
+	std::uniform_real_distribution<float> position(1.0f, Tiles * TileSize - 1.0f);
+	std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+	std::uniform_real_distribution<float> speed(1.0f, 4.0f);
+	std::vector<entt::entity> agents(AgentCount);
+	std::vector<glm::vec3> walk(AgentCount);
+	for (int32 i = 0; i < AgentCount; i++) {
+		agents[i] = R.create();
+		Transform t;
+		t.Position = glm::vec3(position(random), 3.0f, position(random));
+		R.emplace<Transform>(agents[i], t);
+		R.emplace<CharacterController>(agents[i]);
+
+		float a = angle(random);
+		walk[i] = glm::vec3(glm::cos(a), 0.0f, glm::sin(a)) * speed(random);
+	}
+
+	//Walks in its direction and turns back at the border, like CharacterSystem the gravity is added while in the air
+	auto frame = [&]() {
+		for (int32 i = 0; i < AgentCount; i++) {
+			CharacterController& cc = R.get<CharacterController>(agents[i]);
+			glm::vec3 p = world.Transform->GetWorldPosition(agents[i]);
+			if (p.x < 1.0f || p.x > Tiles * TileSize - 1.0f)walk[i].x = glm::abs(walk[i].x) * (p.x < 1.0f ? 1.0f : -1.0f);
+			if (p.z < 1.0f || p.z > Tiles * TileSize - 1.0f)walk[i].z = glm::abs(walk[i].z) * (p.z < 1.0f ? 1.0f : -1.0f);
+
+			cc.Velocity.x = walk[i].x;
+			cc.Velocity.z = walk[i].z;
+			cc.Velocity.y = cc.IsGrounded ? -1.0f : cc.Velocity.y + PhysicsSystem::Gravity.y * dt;
+		}
+		world.Physics->UpdateControllers(dt);
+	};
+
+	constexpr int32 SettleFrames = 120;
+	constexpr int32 Frames = 600;
+	double settle = Tests::Measure(SettleFrames, frame);
+	double walking = Tests::Measure(Frames, frame);
+
+	//Stopped, the ones walking off a step or a pillar land
+	for (glm::vec3& w : walk) {
+		w = glm::vec3(0.0f);
+	}
+	for (int32 i = 0; i < SettleFrames; i++) {
+		frame();
+	}
+
+	//The lowest center is on the floor, the steps and pillars only raise it
+	int32 grounded = 0;
+	for (int32 i = 0; i < AgentCount; i++) {
+		const CharacterController& cc = R.get<CharacterController>(agents[i]);
+		glm::vec3 p = world.Transform->GetWorldPosition(agents[i]);
+		TEST_CHECK(p.y >= Floor + cc.HalfExtents.y - 0.01f, "agent {} fell through the floor, at {} {} {}", i, p.x, p.y, p.z);
+		grounded += cc.IsGrounded;
+	}
+	TEST_CHECK(grounded == AgentCount, "only {} of {} agents are on the ground", grounded, AgentCount);
+
+	Log::info("[Bench] CharacterController {} agents, {} threads: {:.3f}ms per frame ({:.2f}us per agent) walking, {:.3f}ms falling",
+		AgentCount, Jobs::GetThreadCount(), walking, walking * 1000.0 / AgentCount, settle);
+	return true;
+}
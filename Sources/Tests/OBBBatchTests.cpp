@@ -0,0 +1,80 @@
+#include "Tests.h"
+
+#include "Physics/OBBBatch.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cfloat>
+#include <random>
+
+// Random boxes and rays, some along the axes and some starting inside, the SIMD kernels against the scalar one
+// and the scalar one against OBB::RayCast, the partial batches check the scalar tail of the SIMD kernels
+TEST(OBBBatchRayCast) {
+	std::mt19937 random(30);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	auto vec = [&](float scale) { return (glm::vec3(unit(random), unit(random), unit(random)) * 2.0f - 1.0f) * scale; };
+
+	using Kernel = void (OBBBatch::*)(const glm::vec3&, const glm::vec3&, float, float*) const;
+	std::vector<std::pair<const char*, Kernel>> kernels;
+#ifdef OBBBATCH_SSE
+	kernels.emplace_back("SSE", &OBBBatch::RayCastSSE);
+#endif
+#ifdef __AVX2__
+	kernels.emplace_back("AVX2", &OBBBatch::RayCastAVX2);
+#endif
+	kernels.emplace_back("RayCast", &OBBBatch::RayCast);
+
+	int32 hits = 0;
+	OBBBatch batch;
+	std::vector<OBB> boxes;
+	for (int32 test = 0; test < 2000; test++) {
+		batch.Clear();
+		boxes.clear();
+		int32 count = 1 + (int32)(unit(random) * OBBBatch::Capacity) % OBBBatch::Capacity;
+		for (int32 i = 0; i < count; i++) {
+			glm::quat rotation = glm::normalize(glm::quat(unit(random) * 2.0f - 1.0f, vec(1.0f)));
+			//A quarter of the boxes aligned with the world, they have zeroes in the matrix
+			if (unit(random) < 0.25f)rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			glm::mat4 matrix = glm::translate(glm::mat4(1.0f), vec(20.0f)) * glm::mat4_cast(rotation);
+			boxes.emplace_back(matrix, glm::vec3(unit(random), unit(random), unit(random)) * 8.0f + 0.1f);
+			batch.Add(boxes.back());
+		}
+
+		glm::vec3 origin = unit(random) < 0.2f ? glm::vec3(glm::inverse(boxes[0].InvMatrix) * glm::vec4(boxes[0].Size * 0.5f, 1.0f)) : vec(30.0f);
+		//Toward one of the boxes, so a good part of them is hit
+		glm::vec3 target = glm::inverse(boxes[count / 2].InvMatrix) * glm::vec4(boxes[count / 2].Size * 0.5f, 1.0f);
+		glm::vec3 dir = unit(random) < 0.5f ? target - origin + vec(2.0f) : vec(1.0f);
+		for (int axis = 0; axis < 3; axis++) {
+			if (unit(random) < 0.15f)dir[axis] = 0.0f;
+		}
+		if (dir == glm::vec3(0.0f))dir.x = 1.0f;
+		float maxT = unit(random) * 100.0f + 1.0f;
+
+		float expected[OBBBatch::Capacity];
+		batch.RayCastScalar(origin, dir, maxT, expected);
+		for (int32 i = 0; i < count; i++) {
+			float t;
+			bool hit = boxes[i].RayCast(origin, dir, maxT, t);
+			bool expectedHit = expected[i] != FLT_MAX;
+			//A ray entering right at maxT can round to either side
+			if (hit != expectedHit && glm::abs(t - maxT) <= 0.001f * glm::max(1.0f, maxT))continue;
+			TEST_CHECK(hit == expectedHit, "test {}, box {}: scalar hit {} but OBB::RayCast {}", test, i, expectedHit, hit);
+			if (hit) {
+				TEST_CHECK(glm::abs(t - expected[i]) <= 0.001f * glm::max(1.0f, t), "test {}, box {}: scalar t {} but OBB::RayCast {}", test, i, expected[i], t);
+			}
+			hits += hit;
+		}
+
+		for (auto& [name, kernel] : kernels) {
+			float tEnter[OBBBatch::Capacity];
+			(batch.*kernel)(origin, dir, maxT, tEnter);
+			for (int32 i = 0; i < count; i++) {
+				bool same = tEnter[i] == expected[i] || (tEnter[i] != FLT_MAX && expected[i] != FLT_MAX && glm::abs(tEnter[i] - expected[i]) <= 0.0001f * glm::max(1.0f, expected[i]));
+				TEST_CHECK(same, "test {}, box {} of {}: {} t {} but the scalar {}", test, i, count, name, tEnter[i], expected[i]);
+			}
+		}
+	}
+	Log::info("[Test] {} kernels checked, {} hits", kernels.size(), hits);
+	return true;
+}
@@ -0,0 +1,107 @@
+#include "Tests.h"
+
+#include "Vox/ShadowVolume.h"
+
+#include <set>
+
+// Cells of a box, min inclusive and max exclusive
+static void AddBox(std::vector<glm::ivec3>& cells, const glm::ivec3& min, const glm::ivec3& max) {
+	for (int32 z = min.z; z < max.z; z++) {
+		for (int32 y = min.y; y < max.y; y++) {
+			for (int32 x = min.x; x < max.x; x++) {
+				cells.emplace_back(x, y, z);
+			}
+		}
+	}
+}
+
+// Moves boxes through a static floor and wall (and through each other) one cell per step
+// every static cell has to stay set in every level while they pass, and once they are removed
+// the volume has to hold exactly the static cells, no holes and nothing left behind
+TEST(ShadowVolumeMovers) {
+	ShadowVolume volume;
+	std::vector<ShadowVolume::Region> exposed;
+	volume.SetFocus(glm::vec3(0.0f), exposed);
+	ShadowVolume::Bounds bounds = volume.GetWindowBounds();
+
+	std::vector<glm::ivec3> statics;
+	AddBox(statics, glm::ivec3(-40, 0, -40), glm::ivec3(40, 2, 40)); // Floor
+	AddBox(statics, glm::ivec3(10, 2, -20), glm::ivec3(13, 30, 20)); // Wall
+
+	std::vector<int32> dirty;
+	std::vector<int32> changed;
+	volume.WriteCells(statics, 1, bounds, dirty);
+	volume.Flush(dirty, changed);
+
+	//Every level keeps the cells divided by 2^level
+	std::set<std::tuple<int32, int32, int32, int32>> expected;
+	for (const glm::ivec3& cell : statics) {
+		for (int32 level = 0; level < ShadowVolume::LevelCount; level++) {
+			glm::ivec3 c = cell >> level;
+			expected.emplace(level, c.x, c.y, c.z);
+		}
+	}
+
+	struct Mover {
+		glm::ivec3 Start;
+		glm::ivec3 Step;
+		glm::ivec3 Size;
+		std::vector<glm::ivec3> Cells;
+	};
+	std::vector<Mover> movers = {
+		{ glm::ivec3(-30, -3, -4), glm::ivec3(1, 0, 0), glm::ivec3(6), {} }, // Through the floor and the wall
+		{ glm::ivec3(30, 5, -3), glm::ivec3(-1, 0, 0), glm::ivec3(5), {} }, // Through the wall, crosses the first one
+		{ glm::ivec3(0, 20, 0), glm::ivec3(0, -1, 1), glm::ivec3(3, 7, 4), {} }, // Down through the floor
+	};
+
+	for (int32 step = 0; step <= 60; step++) {
+		dirty.clear();
+		for (Mover& mover : movers) {
+			volume.WriteCells(mover.Cells, 0, bounds, dirty);
+			mover.Cells.clear();
+			glm::ivec3 min = mover.Start + mover.Step * step;
+			AddBox(mover.Cells, min, min + mover.Size);
+			volume.WriteCells(mover.Cells, 1, bounds, dirty);
+		}
+		changed.clear();
+		volume.Flush(dirty, changed);
+
+		for (auto& [level, x, y, z] : expected) {
+			TEST_CHECK(volume.GetCell(glm::ivec3(x, y, z), level), "step {}: static cell {} {} {} of level {} cleared", step, x, y, z, level);
+		}
+		for (const Mover& mover : movers) {
+			for (const glm::ivec3& cell : mover.Cells) {
+				TEST_CHECK(volume.GetCell(cell, 0), "step {}: mover cell {} {} {} not set", step, cell.x, cell.y, cell.z);
+			}
+		}
+	}
+
+	dirty.clear();
+	for (Mover& mover : movers) {
+		volume.WriteCells(mover.Cells, 0, bounds, dirty);
+	}
+	changed.clear();
+	volume.Flush(dirty, changed);
+
+	//Exactly the static cells, over the whole region the movers went through
+	for (int32 level = 0; level < ShadowVolume::LevelCount; level++) {
+		glm::ivec3 min = glm::ivec3(-64) >> level;
+		glm::ivec3 max = glm::ivec3(64) >> level;
+		for (int32 z = min.z; z < max.z; z++) {
+			for (int32 y = min.y; y < max.y; y++) {
+				for (int32 x = min.x; x < max.x; x++) {
+					bool set = volume.GetCell(glm::ivec3(x, y, z), level);
+					bool shouldBe = expected.count({ level, x, y, z }) > 0;
+					TEST_CHECK(set == shouldBe, "cell {} {} {} of level {} is {} after the movers left", x, y, z, level, set ? "set" : "a hole");
+				}
+			}
+		}
+	}
+
+	//The bricks of the movers are freed when they leave
+	volume.WriteCells(statics, 0, bounds, dirty);
+	changed.clear();
+	volume.Flush(dirty, changed);
+	TEST_CHECK(volume.GetBrickCount() == 0, "{} bricks left once everything was removed", volume.GetBrickCount());
+	return true;
+}
@@ -0,0 +1,48 @@
+#include "Tests.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+bool Tests::Run(bool bench, const std::vector<std::string>& filters) {
+	const char* kind = bench ? "Bench" : "Test";
+
+	//Registered in the order the files are initialized, sorted so every run has the same order
+	std::vector<Entry> entries = Registry(bench);
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.Name < b.Name; });
+
+	int32 ran = 0;
+	int32 failed = 0;
+	for (const Entry& entry : entries) {
+		bool selected = filters.empty() || std::any_of(filters.begin(), filters.end(), [&](const std::string& filter) {
+			return entry.Name.compare(0, filter.size(), filter) == 0;
+		});
+		if (!selected)continue;
+
+		Log::info("[{}] {}", kind, entry.Name);
+		bool passed = false;
+		//A CHECK failing inside the code tested throws
+		double ms = Measure(1, [&]() {
+			try {
+				passed = entry.Run();
+			}
+			catch (const std::exception& e) {
+				Log::error("[{}] {} threw: {}", kind, entry.Name, e.what());
+			}
+		});
+		if (passed) {
+			Log::info("[{}] {} passed in {:.1f}ms", kind, entry.Name, ms);
+		}
+		else {
+			Log::error("[{}] {} failed", kind, entry.Name);
+			failed++;
+		}
+		ran++;
+	}
+
+	if (ran == 0 && !filters.empty()) {
+		Log::error("[{}] Nothing matches the names given", kind);
+		return false;
+	}
+	Log::info("[{}] {} ran, {} failed", kind, ran, failed);
+	return failed == 0;
+}
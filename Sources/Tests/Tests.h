@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "IO/Log.h"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Correctness tests and benchmarks, run without a window by the --test and --bench command lines
+// Declared with TEST(Name) and BENCH(Name) in Sources/Tests, a test returns false (or fails a TEST_CHECK) when broken
+// a benchmark logs its timings and returns false only when it couldn't run
+class Tests {
+	struct Entry {
+		std::string Name;
+		std::function<bool()> Run;
+	};
+	static std::vector<Entry>& Registry(bool bench) {
+		static std::vector<Entry> tests;
+		static std::vector<Entry> benches;
+		return bench ? benches : tests;
+	}
+
+public:
+	static bool Register(const char* name, bool bench, std::function<bool()> run) {
+		Registry(bench).push_back(Entry{ name, std::move(run) });
+		return true;
+	}
+
+	// Runs the tests, or the benchmarks, whose name starts with one of the filters, all of them when empty
+	// false when one of them failed
+	static bool Run(bool bench, const std::vector<std::string>& filters);
+
+	// Average milliseconds of fn over count runs
+	template<typename F>
+	static double Measure(int32 count, F fn) {
+		auto start = std::chrono::steady_clock::now();
+		for (int32 i = 0; i < count; i++) {
+			fn();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+	}
+};
+
+#define TEST(name) \
+static bool Test_##name(); \
+static const bool Test_##name##_Registered = Tests::Register(#name, false, Test_##name); \
+static bool Test_##name()
+
+#define BENCH(name) \
+static bool Bench_##name(); \
+static const bool Bench_##name##_Registered = Tests::Register(#name, true, Bench_##name); \
+static bool Bench_##name()
+
+// Fails the test running when the condition is false, the message is formatted with the arguments
+#define TEST_CHECK(condition, ...) \
+if (!(condition)) { \
+	Log::error("[Test] {}:{} {} failed: {}", __FILE__, __LINE__, #condition, fmt::format(__VA_ARGS__)); \
+	return false; \
+}
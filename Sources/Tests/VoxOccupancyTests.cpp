@@ -0,0 +1,158 @@
+#include "Tests.h"
+
+#include "Physics/Geometry.h"
+#include "Physics/VoxOccupancy.h"
+
+#include <random>
+
+// First solid voxel along the ray testing every voxel box, t is 0 when the ray starts inside it
+// slack is the length of the ray inside that voxel, the rays grazing an edge are too short to compare
+static bool RayCastBruteForce(const std::vector<glm::ivec3>& solids, const glm::vec3& origin, const glm::vec3& invDir, float maxT, float& t, float& slack) {
+	bool hit = false;
+	t = maxT;
+	for (const glm::ivec3& voxel : solids) {
+		glm::vec3 t1 = (glm::vec3(voxel) - origin) * invDir;
+		glm::vec3 t2 = (glm::vec3(voxel + 1) - origin) * invDir;
+		glm::vec3 tNear = glm::min(t1, t2);
+		glm::vec3 tFar = glm::max(t1, t2);
+		float tEnter = glm::max(glm::max(glm::max(tNear.x, tNear.y), tNear.z), 0.0f);
+		float tExit = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+		if (tEnter <= tExit && tEnter <= t) {
+			hit = true;
+			t = tEnter;
+			slack = tExit - tEnter;
+		}
+	}
+	return hit;
+}
+
+// The axes of dir set to 0 are replaced like VoxOccupancy does
+static glm::vec3 InverseDirection(glm::vec3 dir) {
+	for (int axis = 0; axis < 3; axis++) {
+		if (dir[axis] == 0.0f)dir[axis] = 0.00000001f;
+	}
+	return 1.0f / dir;
+}
+
+// Random grids, with sizes that aren't multiple of the bricks and regions, against testing every voxel
+TEST(VoxOccupancyRayCast) {
+	std::mt19937 random(28);
+	std::uniform_int_distribution<int32> sizes(1, 70);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	int32 compared = 0;
+	for (int32 grid = 0; grid < 60; grid++) {
+		glm::ivec3 size(sizes(random), sizes(random), sizes(random));
+		float density = grid % 3 == 0 ? 0.001f : (grid % 3 == 1 ? 0.02f : 0.3f);
+
+		VoxGrid voxels(size);
+		std::vector<glm::ivec3> solids;
+		for (int32 z = 0; z < size.z; z++) {
+			for (int32 y = 0; y < size.y; y++) {
+				for (int32 x = 0; x < size.x; x++) {
+					if (unit(random) < density) {
+						voxels.Set(glm::ivec3(x, y, z), 1);
+						solids.emplace_back(x, y, z);
+					}
+				}
+			}
+		}
+		VoxOccupancy occupancy;
+		occupancy.Build(voxels);
+
+		for (int32 i = 0; i < 300; i++) {
+			//From outside and inside the grid, some along the axes
+			glm::vec3 origin = (glm::vec3(unit(random), unit(random), unit(random)) * 1.4f - 0.2f) * glm::vec3(size);
+			glm::vec3 dir = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f - 1.0f;
+			for (int axis = 0; axis < 3; axis++) {
+				if (unit(random) < 0.1f)dir[axis] = 0.0f;
+			}
+			if (dir == glm::vec3(0.0f))dir.y = -1.0f;
+			float maxT = unit(random) * 150.0f;
+
+			float expected, slack = 0.0f;
+			bool expectedHit = RayCastBruteForce(solids, origin, InverseDirection(dir), maxT, expected, slack);
+			if (expectedHit && slack < 0.001f)continue;
+
+			float t;
+			glm::ivec3 voxel;
+			bool hit = occupancy.RayCast(origin, dir, maxT, t, voxel);
+			TEST_CHECK(hit == expectedHit, "grid {}, ray {}: hit {} but the brute force {}", grid, i, hit, expectedHit);
+			if (hit) {
+				TEST_CHECK(glm::abs(t - expected) <= 0.001f * glm::max(1.0f, expected), "grid {}, ray {}: t {} but the brute force {}", grid, i, t, expected);
+				TEST_CHECK(occupancy.IsSolid(voxel), "grid {}, ray {}: the voxel hit is empty", grid, i);
+			}
+
+			float referenceT;
+			bool referenceHit = occupancy.RayCastReference(origin, dir, maxT, referenceT, voxel);
+			TEST_CHECK(referenceHit == expectedHit, "grid {}, ray {}: reference hit {} but the brute force {}", grid, i, referenceHit, expectedHit);
+			if (referenceHit) {
+				TEST_CHECK(glm::abs(referenceT - expected) <= 0.001f * glm::max(1.0f, expected), "grid {}, ray {}: reference t {} but the brute force {}", grid, i, referenceT, expected);
+			}
+			compared++;
+		}
+
+		//A ray starting inside a solid voxel hits it at 0
+		if (!solids.empty()) {
+			glm::vec3 inside = glm::vec3(solids[solids.size() / 2]) + 0.5f;
+			float t;
+			glm::ivec3 voxel;
+			TEST_CHECK(occupancy.RayCast(inside, glm::vec3(0.3f, -1.0f, 0.2f), 10.0f, t, voxel) && t == 0.0f && voxel == solids[solids.size() / 2], "grid {}: a ray starting in a voxel must hit it at 0", grid);
+		}
+	}
+	Log::info("[Test] {} rays compared", compared);
+	return true;
+}
+
+// Rays per second of the hierarchical DDA and of stepping every voxel, on a 256^3 island
+// ground probes (short rays down from above the ground) and long random rays over the island
+BENCH(VoxOccupancyRayCast) {
+	constexpr int32 Size = 256;
+	VoxGrid voxels{ glm::ivec3(Size) };
+	for (int32 z = 0; z < Size; z++) {
+		for (int32 x = 0; x < Size; x++) {
+			//Hills in the middle, nothing near the borders
+			float distance = glm::length(glm::vec2(x, z) - glm::vec2(Size / 2)) / (Size / 2);
+			int32 height = (int32)((1.0f - distance) * 60.0f + glm::sin(x * 0.1f) * glm::cos(z * 0.13f) * 10.0f);
+			for (int32 y = 0; y < height; y++) {
+				voxels.Set(glm::ivec3(x, y, z), 1);
+			}
+		}
+	}
+	VoxOccupancy occupancy;
+	occupancy.Build(voxels);
+
+	std::mt19937 random(28);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	constexpr int32 Count = 100000;
+	std::vector<Ray> probes(Count);
+	std::vector<Ray> rays(Count);
+	for (int32 i = 0; i < Count; i++) {
+		probes[i] = Ray(glm::vec3(unit(random) * Size, 80.0f, unit(random) * Size), glm::vec3(0.0f, -1.0f, 0.0f), 90.0f);
+		glm::vec3 origin = glm::vec3(unit(random), unit(random) * 0.5f + 0.5f, unit(random)) * (float)Size;
+		glm::vec3 dir = glm::normalize(glm::vec3(unit(random) * 2.0f - 1.0f, -unit(random) * 0.3f, unit(random) * 2.0f - 1.0f));
+		rays[i] = Ray(origin, dir, 1000.0f);
+	}
+
+	auto run = [&](const std::vector<Ray>& batch, bool reference) {
+		int32 hits = 0;
+		double ms = Tests::Measure(1, [&]() {
+			for (const Ray& ray : batch) {
+				float t;
+				glm::ivec3 voxel;
+				hits += reference ? occupancy.RayCastReference(ray.Origin, ray.Direction, ray.MaxT, t, voxel) : occupancy.RayCast(ray.Origin, ray.Direction, ray.MaxT, t, voxel);
+			}
+		});
+		return std::make_pair(batch.size() / (ms * 1000.0), hits);
+	};
+
+	auto probesFast = run(probes, false);
+	auto probesReference = run(probes, true);
+	auto raysFast = run(rays, false);
+	auto raysReference = run(rays, true);
+	TEST_CHECK(probesFast.second == probesReference.second && raysFast.second == raysReference.second, "the hits differ");
+
+	Log::info("[Bench] VoxOccupancy 256^3 island, million rays per second (hierarchical / every voxel): ground probes {:.2f} / {:.2f}, random rays {:.2f} / {:.2f}",
+		probesFast.first, probesReference.first, raysFast.first, raysReference.first);
+	return true;
+}
@@ -0,0 +1,63 @@
+#include "Tests.h"
+
+#include "Vox/VoxSurface.h"
+
+#include <algorithm>
+#include <random>
+
+// Voxels of the surface sorted, the order they are added in doesn't matter
+static std::vector<glm::ivec3> SortedVoxels(const VoxSurface& surface) {
+	//Scaled by 10 a voxel is a cell of 0.1, without rounding
+	std::vector<glm::ivec3> voxels;
+	surface.TransformScalar(glm::mat4(10.0f), voxels);
+	std::sort(voxels.begin(), voxels.end(), [](const glm::ivec3& a, const glm::ivec3& b) {
+		return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+	});
+	return voxels;
+}
+
+// Boxes are added and carved in random grids, rebuilding only the edited bounds has to give the same surface as building all of it
+TEST(VoxSurfaceRebuild) {
+	std::mt19937 random(44);
+	std::uniform_int_distribution<int32> sizes(1, 40);
+	std::uniform_int_distribution<int32> values(0, 3);
+	const uint8 minValue = 2;
+
+	for (int32 test = 0; test < 30; test++) {
+		glm::ivec3 size(sizes(random), sizes(random), sizes(random));
+		VoxGrid grid{ size };
+		auto edit = [&](glm::ivec3& min, glm::ivec3& max) {
+			std::uniform_int_distribution<int32> x(0, size.x - 1), y(0, size.y - 1), z(0, size.z - 1);
+			min = glm::ivec3(x(random), y(random), z(random));
+			max = glm::min(min + glm::ivec3(x(random), y(random), z(random)) / 3, size - 1);
+			//Some edits only change the value, with the voxels still set
+			uint8 value = (uint8)values(random);
+			for (int32 vz = min.z; vz <= max.z; vz++) {
+				for (int32 vy = min.y; vy <= max.y; vy++) {
+					for (int32 vx = min.x; vx <= max.x; vx++) {
+						grid.Set(glm::ivec3(vx, vy, vz), value);
+					}
+				}
+			}
+		};
+
+		glm::ivec3 min, max;
+		for (int32 i = 0; i < 10; i++) {
+			edit(min, max);
+		}
+		VoxSurface surface;
+		surface.Build(grid, minValue);
+
+		for (int32 i = 0; i < 20; i++) {
+			edit(min, max);
+			VoxSurface rebuilt;
+			rebuilt.Rebuild(surface, grid, minValue, min, max);
+			VoxSurface built;
+			built.Build(grid, minValue);
+
+			TEST_CHECK(SortedVoxels(rebuilt) == SortedVoxels(built), "grid {} {} {} edit {}: {} surface voxels rebuilt, {} built", size.x, size.y, size.z, i, rebuilt.GetCount(), built.GetCount());
+			surface = rebuilt;
+		}
+	}
+	return true;
+}
@@ -45,9 +45,16 @@ public:
 		}
 	}
 
+	//The callbacks can be added from other threads while running, they run the next time
 	void ExecuteAndClear() {
-		ExecuteAll();
-		_Callbacks.clear();
+		std::vector<std::function<void()>> callbacks;
+		{
+			std::unique_lock l(_Mutex);
+			callbacks.swap(_Callbacks);
+		}
+		for (auto& _Cb : callbacks) {
+			_Cb();
+		}
 	}
 
 	auto begin() { return _Callbacks.begin(); }
@@ -0,0 +1,128 @@
+#include "LZ.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static constexpr int32 HashBits = 14;
+
+static inline uint32 Read32(const uint8* p) {
+	uint32 v;
+	memcpy(&v, p, sizeof(uint32));
+	return v;
+}
+
+static inline uint32 Hash(uint32 v) {
+	return (v * 2654435761u) >> (32 - HashBits);
+}
+
+static inline uint8* WriteLength(uint8* dst, size_t length) {
+	while (length >= 255) {
+		*dst++ = 255;
+		length -= 255;
+	}
+	*dst++ = (uint8)length;
+	return dst;
+}
+
+static uint8* WriteSequence(uint8* dst, const uint8* literals, size_t literalCount, size_t offset, size_t matchLength) {
+	uint8* token = dst++;
+	*token = (uint8)(std::min<size_t>(literalCount, 15) << 4);
+	if (literalCount >= 15)dst = WriteLength(dst, literalCount - 15);
+	memcpy(dst, literals, literalCount);
+	dst += literalCount;
+
+	if (matchLength == 0)return dst;
+
+	*dst++ = (uint8)(offset & 0xFF);
+	*dst++ = (uint8)(offset >> 8);
+	size_t length = matchLength - LZ::MinMatch;
+	*token |= (uint8)std::min<size_t>(length, 15);
+	if (length >= 15)dst = WriteLength(dst, length - 15);
+	return dst;
+}
+
+size_t LZ::Compress(const uint8* src, size_t size, uint8* dst) {
+	//Last position seen of every hash of 4 bytes
+	std::vector<int64_t> table(1 << HashBits, -1);
+	uint8* out = dst;
+	size_t anchor = 0;
+	size_t i = 0;
+
+	while (i + MinMatch <= size) {
+		uint32 value = Read32(src + i);
+		uint32 h = Hash(value);
+		int64_t candidate = table[h];
+		table[h] = (int64_t)i;
+
+		if (candidate < 0 || i - candidate > MaxOffset || Read32(src + candidate) != value) {
+			i++;
+			continue;
+		}
+
+		size_t length = MinMatch;
+		while (i + length < size && src[candidate + length] == src[i + length])length++;
+
+		out = WriteSequence(out, src + anchor, i - anchor, i - (size_t)candidate, length);
+
+		//Keeps the end of the match findable, long runs are mostly found again through it
+		if (i + length + MinMatch <= size && length > 2) {
+			table[Hash(Read32(src + i + length - 2))] = (int64_t)(i + length - 2);
+		}
+		i += length;
+		anchor = i;
+	}
+
+	out = WriteSequence(out, src + anchor, size - anchor, 0, 0);
+	return out - dst;
+}
+
+static inline bool ReadLength(const uint8*& src, const uint8* end, size_t& length) {
+	uint8 b;
+	do {
+		if (src >= end)return false;
+		b = *src++;
+		length += b;
+	} while (b == 255);
+	return true;
+}
+
+bool LZ::Decompress(const uint8* src, size_t size, uint8* dst, size_t dstSize) {
+	const uint8* end = src + size;
+	uint8* out = dst;
+	uint8* outEnd = dst + dstSize;
+
+	while (src < end) {
+		uint8 token = *src++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(src, end, literalCount))return false;
+		if ((size_t)(end - src) < literalCount || (size_t)(outEnd - out) < literalCount)return false;
+		memcpy(out, src, literalCount);
+		src += literalCount;
+		out += literalCount;
+
+		//The last sequence has no match
+		if (src == end)break;
+
+		if (end - src < 2)return false;
+		size_t offset = (size_t)src[0] | ((size_t)src[1] << 8);
+		src += 2;
+		size_t length = (token & 15);
+		if (length == 15 && !ReadLength(src, end, length))return false;
+		length += MinMatch;
+
+		if (offset == 0 || offset > (size_t)(out - dst) || (size_t)(outEnd - out) < length)return false;
+		const uint8* match = out - offset;
+		//The match can overlap the output, runs are copies with a short offset
+		if (offset >= length) {
+			memcpy(out, match, length);
+			out += length;
+		}
+		else {
+			for (size_t j = 0; j < length; j++) *out++ = *match++;
+		}
+	}
+
+	return out == outEnd;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Core/Core.h"
+
+// Byte oriented LZ77 codec, made to be fast to decode rather than to compress the most
+// A block is a list of sequences: token (literal count << 4 | match length - 4), literals, 16 bit offset
+// counts of 15 continue in the next bytes, the last sequence has only literals
+class LZ {
+public:
+	inline static constexpr int32 MinMatch = 4;
+	inline static constexpr int32 MaxOffset = 65535;
+
+	// Size dst needs for any src of size bytes
+	static size_t GetBound(size_t size) { return size + size / 255 + 16; }
+
+	// Returns the bytes written in dst, that has to have GetBound(size) bytes
+	static size_t Compress(const uint8* src, size_t size, uint8* dst);
+	// Returns false when src is corrupted or doesn't decode to exactly dstSize bytes
+	static bool Decompress(const uint8* src, size_t size, uint8* dst, size_t dstSize);
+};
@@ -2,24 +2,22 @@
 
 #include "IO/Log.h"
 
+#include <chrono>
 #include <string>
-#include <profileapi.h>
 
 class PreciseTimer {
+	using Clock = std::chrono::high_resolution_clock;
+
 	std::string identifier;
-	LARGE_INTEGER frequency;        // ticks per second
-	LARGE_INTEGER t1, t2;           // ticks
-	double elapsedTime;
+	Clock::time_point t1;
 
 public:
 	PreciseTimer(std::string identifier) : identifier(identifier) {
-		QueryPerformanceFrequency(&frequency);
-		QueryPerformanceCounter(&t1);
+		t1 = Clock::now();
 	}
 
 	~PreciseTimer() {
-		QueryPerformanceCounter(&t2);
-		elapsedTime = (t2.QuadPart - t1.QuadPart) * 1000.0 / frequency.QuadPart;
+		double elapsedTime = std::chrono::duration<double, std::milli>(Clock::now() - t1).count();
 
 		Log::info("{}: {}ms", identifier, elapsedTime);
 	}
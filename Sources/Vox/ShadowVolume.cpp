@@ -0,0 +1,313 @@
+#include "ShadowVolume.h"
+
+#include <cstring>
+
+ShadowVolume::ShadowVolume() {
+	_Pages = std::make_unique<std::atomic<int32>[]>(LevelCount * PagesPerLevel);
+	_PageDirty = std::make_unique<std::atomic<uint8>[]>(LevelCount * PagesPerLevel);
+	for (int32 i = 0; i < LevelCount * PagesPerLevel; i++) {
+		_Pages[i].store(-1, std::memory_order_relaxed);
+		_PageDirty[i].store(0, std::memory_order_relaxed);
+	}
+
+	for (int32 level = 0; level < LevelCount; level++) {
+		_Origins[level] = glm::ivec3(0, 0, 0);
+	}
+}
+
+int32 ShadowVolume::AllocateBrick(int32 page) {
+	std::lock_guard<std::mutex> lock(_AllocMutex);
+
+	//Another thread could have allocated it while waiting
+	int32 brick = _Pages[page].load(std::memory_order_relaxed);
+	if (brick >= 0)return brick;
+
+	if (!_FreeBricks.empty()) {
+		brick = _FreeBricks.back();
+		_FreeBricks.pop_back();
+	}
+	else {
+		if (_BrickCount == _ChunkCount * ChunkBricks) {
+			//Out of bricks, the cells are dropped until some are freed
+			if (_ChunkCount == MaxChunks)return -1;
+			_Chunks[_ChunkCount] = std::make_unique<uint8[]>((size_t)ChunkBricks * BrickBytes);
+			_ChunkMasks[_ChunkCount] = std::make_unique<uint64[]>(ChunkBricks);
+			_ChunkCounts[_ChunkCount] = std::make_unique<uint16[]>((size_t)ChunkBricks * BrickCells);
+			_ChunkCount++;
+		}
+		brick = _BrickCount++;
+	}
+
+	memset(GetBrickData(brick), 0, BrickBytes);
+	memset(GetBrickCounts(brick), 0, sizeof(uint16) * BrickCells);
+	_Pages[page].store(brick, std::memory_order_release);
+	_PagesChanged = true;
+	return brick;
+}
+
+void ShadowVolume::FreePage(int32 page) {
+	int32 brick = _Pages[page].load(std::memory_order_relaxed);
+	if (brick < 0)return;
+
+	_FreeBricks.push_back(brick);
+	_Pages[page].store(-1, std::memory_order_relaxed);
+	_PagesChanged = true;
+}
+
+void ShadowVolume::ClearBricks(int32 level, const glm::ivec3& min, const glm::ivec3& max) {
+	for (int32 z = min.z; z <= max.z; z++) {
+		for (int32 y = min.y; y <= max.y; y++) {
+			for (int32 x = min.x; x <= max.x; x++) {
+				FreePage(GetPageIndex(level, glm::ivec3(x, y, z)));
+			}
+		}
+	}
+}
+
+void ShadowVolume::SetFocus(const glm::vec3& position, std::vector<Region>& exposed) {
+	for (int32 level = 0; level < LevelCount; level++) {
+		glm::ivec3 cell = glm::ivec3(glm::floor(position * (10.0f / (float)(1 << level))));
+		glm::ivec3 origin = (cell >> BrickShift) - WindowSize / 2;
+		glm::ivec3 previous = _Origins[level];
+		if (_HasFocus && origin == previous)continue;
+
+		_Origins[level] = origin;
+		glm::ivec3 max = origin + WindowSize - 1;
+		glm::ivec3 delta = origin - previous;
+
+		//Nothing is kept when moved a whole window
+		if (!_HasFocus || glm::any(glm::greaterThanEqual(glm::abs(delta), glm::ivec3(WindowSize)))) {
+			ClearBricks(level, origin, max);
+			exposed.push_back(Region{ level, origin, max });
+			continue;
+		}
+
+		//A slab for every axis that moved, the next ones skip what the previous ones have
+		glm::ivec3 lo = origin;
+		glm::ivec3 hi = max;
+		for (int axis = 0; axis < 3; axis++) {
+			if (delta[axis] == 0)continue;
+
+			Region region{ level, lo, hi };
+			if (delta[axis] > 0) {
+				region.Min[axis] = previous[axis] + WindowSize;
+				hi[axis] = region.Min[axis] - 1;
+			}
+			else {
+				region.Max[axis] = previous[axis] - 1;
+				lo[axis] = previous[axis];
+			}
+
+			ClearBricks(level, region.Min, region.Max);
+			exposed.push_back(region);
+		}
+	}
+
+	_HasFocus = true;
+}
+
+ShadowVolume::Bounds ShadowVolume::GetWindowBounds() const {
+	Bounds bounds;
+	for (int32 level = 0; level < LevelCount; level++) {
+		bounds.Min[level] = _Origins[level];
+		bounds.Max[level] = _Origins[level] + WindowSize - 1;
+	}
+	return bounds;
+}
+
+ShadowVolume::Bounds ShadowVolume::GetRegionBounds(const Region& region) const {
+	Bounds bounds;
+	for (int32 level = 0; level < LevelCount; level++) {
+		bounds.Min[level] = glm::ivec3(1, 1, 1);
+		bounds.Max[level] = glm::ivec3(0, 0, 0);
+	}
+	bounds.Min[region.Level] = region.Min;
+	bounds.Max[region.Level] = region.Max;
+	return bounds;
+}
+
+void ShadowVolume::GetRegionWorldBounds(const Region& region, glm::vec3& min, glm::vec3& max) const {
+	float brickSize = 0.1f * (float)(BrickSize << region.Level);
+	min = glm::vec3(region.Min) * brickSize;
+	max = glm::vec3(region.Max + 1) * brickSize;
+}
+
+void ShadowVolume::WriteCells(const std::vector<glm::ivec3>& cells, int value, const Bounds& bounds, std::vector<int32>& dirty) {
+	for (const glm::ivec3& cell : cells) {
+		for (int32 level = 0; level < LevelCount; level++) {
+			glm::ivec3 c = cell >> level;
+			glm::ivec3 brick = c >> BrickShift;
+			if (glm::any(glm::lessThan(brick, bounds.Min[level])) || glm::any(glm::greaterThan(brick, bounds.Max[level])))continue;
+
+			int32 page = GetPageIndex(level, brick);
+			int32 b = _Pages[page].load(std::memory_order_acquire);
+			if (b < 0) {
+				//Nothing to erase in a missing brick
+				if (value == 0)continue;
+				b = AllocateBrick(page);
+				if (b < 0)continue;
+			}
+
+			//Relaxed is enough, the Jobs are completed before the bricks are flushed
+			glm::ivec3 local = c & (BrickSize - 1);
+			std::atomic<uint16>* count = reinterpret_cast<std::atomic<uint16>*>(GetBrickCounts(b) + local.x + local.y * BrickSize + local.z * BrickSize * BrickSize);
+			uint16 previous = count->load(std::memory_order_relaxed);
+			if (value) {
+				while (previous != UINT16_MAX && !count->compare_exchange_weak(previous, previous + 1, std::memory_order_relaxed));
+				if (previous != 0)continue;
+			}
+			else {
+				while (previous != 0 && !count->compare_exchange_weak(previous, previous - 1, std::memory_order_relaxed));
+				if (previous != 1)continue;
+			}
+
+			//The cell was set or cleared
+			if (_PageDirty[page].load(std::memory_order_relaxed) == 0 && _PageDirty[page].exchange(1, std::memory_order_relaxed) == 0) {
+				dirty.push_back(page);
+			}
+		}
+	}
+}
+
+void ShadowVolume::Flush(const std::vector<int32>& dirty, std::vector<int32>& changed) {
+	for (int32 page : dirty) {
+		_PageDirty[page].store(0, std::memory_order_relaxed);
+
+		int32 brick = _Pages[page].load(std::memory_order_relaxed);
+		if (brick < 0)continue;
+
+		//Only the dirty bricks are built again
+		const uint16* counts = GetBrickCounts(brick);
+		uint8* bytes = GetBrickData(brick);
+		constexpr int32 Texels = BrickSize / 2;
+		for (int32 i = 0; i < BrickBytes; i++) {
+			glm::ivec3 first = glm::ivec3(i % Texels, (i / Texels) % Texels, i / (Texels * Texels)) * 2;
+			uint8 byte = 0;
+			for (int32 bit = 0; bit < 8; bit++) {
+				glm::ivec3 c = first + glm::ivec3(bit & 1, (bit >> 1) & 1, bit >> 2);
+				if (counts[c.x + c.y * BrickSize + c.z * BrickSize * BrickSize] != 0)byte |= (uint8)(1 << bit);
+			}
+			bytes[i] = byte;
+		}
+
+		uint64 mask = ComputeMask(bytes);
+		_ChunkMasks[brick / ChunkBricks][brick % ChunkBricks] = mask;
+
+		if (mask == 0) {
+			FreePage(page);
+		}
+		else {
+			changed.push_back(brick);
+		}
+	}
+}
+
+void ShadowVolume::GetBricks(std::vector<int32>& bricks) const {
+	for (int32 i = 0; i < LevelCount * PagesPerLevel; i++) {
+		int32 brick = _Pages[i].load(std::memory_order_relaxed);
+		if (brick >= 0)bricks.push_back(brick);
+	}
+}
+
+bool ShadowVolume::GetCell(const glm::ivec3& cell, int32 level) const {
+	glm::ivec3 brick = cell >> BrickShift;
+	if (glm::any(glm::lessThan(brick, _Origins[level])) || glm::any(glm::greaterThanEqual(brick, _Origins[level] + WindowSize)))return false;
+
+	int32 b = _Pages[GetPageIndex(level, brick)].load(std::memory_order_relaxed);
+	if (b < 0)return false;
+
+	glm::ivec3 local = cell & (BrickSize - 1);
+	uint8 mask = (uint8)(1 << ((local.x & 1) | ((local.y & 1) << 1) | ((local.z & 1) << 2)));
+	local >>= 1;
+	return (GetBrickData(b)[local.x + local.y * (BrickSize / 2) + local.z * (BrickSize / 2) * (BrickSize / 2)] & mask) != 0;
+}
+
+uint64 ShadowVolume::ComputeMask(const uint8* brick) {
+	//A row of 8 bytes has 4 blocks, 2 bytes each
+	constexpr int32 Texels = BrickSize / 2;
+	uint64 mask = 0;
+	for (int32 z = 0; z < Texels; z++) {
+		for (int32 y = 0; y < Texels; y++) {
+			uint64 row;
+			memcpy(&row, brick + y * Texels + z * Texels * Texels, sizeof(uint64));
+			if (row == 0)continue;
+
+			for (int32 x = 0; x < 4; x++) {
+				if ((row >> (x * 16)) & 0xFFFF) {
+					mask |= uint64(1) << (x + (y >> 1) * 4 + (z >> 1) * 16);
+				}
+			}
+		}
+	}
+	return mask;
+}
+
+bool ShadowVolume::IsOccupied(const glm::ivec3& block, int32 mip) const {
+	glm::ivec3 pos = block << mip;
+
+	for (int32 level = 0; level < LevelCount; level++) {
+		glm::ivec3 cell = pos >> level;
+		glm::ivec3 brick = cell >> BrickShift;
+		if (glm::any(glm::lessThan(brick, _Origins[level])) || glm::any(glm::greaterThanEqual(brick, _Origins[level] + WindowSize)))continue;
+
+		int32 b = _Pages[GetPageIndex(level, brick)].load(std::memory_order_relaxed);
+		if (b < 0)return false;
+
+		//Blocks smaller than the cells of the level are answered by their cell
+		int32 levelMip = mip - level;
+		if (levelMip <= 0)return GetCell(cell, level);
+
+		glm::ivec3 local = cell & (BrickSize - 1);
+		uint64 mask = GetBrickMask(b);
+		switch (levelMip) {
+		case 1:
+			local >>= 1;
+			return GetBrickData(b)[local.x + local.y * (BrickSize / 2) + local.z * (BrickSize / 2) * (BrickSize / 2)] != 0;
+		case 2:
+			local >>= 2;
+			return (mask >> (local.x + local.y * 4 + local.z * 16)) & 1;
+		case 3:
+			local >>= 3;
+			return (mask & (uint64(0x00330033) << (local.x * 2 + local.y * 8 + local.z * 32))) != 0;
+		default:
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ShadowVolume::IsOccupied(const glm::vec3& min, const glm::vec3& max) const {
+	glm::ivec3 lo = glm::ivec3(glm::floor(min * 10.0f));
+	glm::ivec3 hi = glm::ivec3(glm::floor(max * 10.0f));
+
+	//Bricks first, then the 4^3 blocks of the occupied ones, then the cells
+	std::vector<glm::ivec3> stack;
+	for (int32 z = lo.z >> MaxMip; z <= hi.z >> MaxMip; z++) {
+		for (int32 y = lo.y >> MaxMip; y <= hi.y >> MaxMip; y++) {
+			for (int32 x = lo.x >> MaxMip; x <= hi.x >> MaxMip; x++) {
+				if (IsOccupied(glm::ivec3(x, y, z), MaxMip))stack.push_back(glm::ivec3(x, y, z));
+			}
+		}
+	}
+
+	for (int32 mip = MaxMip - 2; mip >= 0 && !stack.empty(); mip -= 2) {
+		std::vector<glm::ivec3> next;
+		for (const glm::ivec3& parent : stack) {
+			glm::ivec3 first = glm::max(parent << 2, lo >> mip);
+			glm::ivec3 last = glm::min((parent << 2) + 3, hi >> mip);
+			for (int32 z = first.z; z <= last.z; z++) {
+				for (int32 y = first.y; y <= last.y; y++) {
+					for (int32 x = first.x; x <= last.x; x++) {
+						if (!IsOccupied(glm::ivec3(x, y, z), mip))continue;
+						if (mip == 0)return true;
+						next.push_back(glm::ivec3(x, y, z));
+					}
+				}
+			}
+		}
+		stack.swap(next);
+	}
+
+	return false;
+}
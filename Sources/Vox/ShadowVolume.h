@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Sparse binary volume of the shadow casters around a focus point (the camera)
+// Made of clipmap levels with cells of 0.1 * 2^level, every level keeps a window of WindowSize^3 bricks centered on the focus
+// A brick has BrickSize^3 cells stored as bytes of 2x2x2 cells (the layout read by the shaders) and only exists when a cell is set
+// Every cell counts the surface voxels written in it, so removing one never clears a cell that another one still has
+// The window slots wrap around, so moving the focus only clears and rebuilds the bricks entering the window
+// Every brick keeps a mask of its 4^3 blocks of 4^3 cells with any cell set, the mips above the bytes are read from it
+class ShadowVolume {
+public:
+	inline static constexpr int32 LevelCount = 4;
+	inline static constexpr int32 WindowSize = 32;  // Bricks per axis of every level
+	inline static constexpr int32 BrickShift = 4;
+	inline static constexpr int32 BrickSize = 1 << BrickShift; // Cells per axis of a brick
+	inline static constexpr int32 BrickBytes = (BrickSize / 2) * (BrickSize / 2) * (BrickSize / 2);
+	inline static constexpr int32 BrickCells = BrickSize * BrickSize * BrickSize;
+	inline static constexpr int32 PagesPerLevel = WindowSize * WindowSize * WindowSize;
+	inline static constexpr int32 ChunkBricks = 256; // Bricks allocated at once
+	inline static constexpr int32 MaxChunks = 256;
+	inline static constexpr int32 MaxMip = 4;        // Blocks of 2^mip cells, the last one is the whole brick
+
+	// Range of bricks written in every level, inclusive
+	struct Bounds {
+		glm::ivec3 Min[LevelCount];
+		glm::ivec3 Max[LevelCount];
+	};
+
+	// Bricks of a level that entered the window and have to be voxelized again
+	struct Region {
+		int32 Level;
+		glm::ivec3 Min;
+		glm::ivec3 Max;
+	};
+
+private:
+	glm::ivec3 _Origins[LevelCount]; // First brick of the window of every level
+	bool _HasFocus{ false };
+
+	// Brick of every window slot, -1 when has no cells set
+	std::unique_ptr<std::atomic<int32>[]> _Pages;
+	std::unique_ptr<std::atomic<uint8>[]> _PageDirty;
+	std::atomic<bool> _PagesChanged{ true };
+
+	// Chunks are never moved, the Jobs threads keep pointers to the bricks while others are allocated
+	std::unique_ptr<uint8[]> _Chunks[MaxChunks];
+	std::unique_ptr<uint64[]> _ChunkMasks[MaxChunks];
+	std::unique_ptr<uint16[]> _ChunkCounts[MaxChunks];
+	int32 _ChunkCount{ 0 };
+	int32 _BrickCount{ 0 };
+	std::vector<int32> _FreeBricks;
+	std::mutex _AllocMutex;
+
+	int32 AllocateBrick(int32 page);
+	void FreePage(int32 page);
+	void ClearBricks(int32 level, const glm::ivec3& min, const glm::ivec3& max);
+
+public:
+
+	ShadowVolume();
+
+	static int32 GetPageIndex(int32 level, const glm::ivec3& brick) {
+		constexpr int32 mask = WindowSize - 1;
+		return level * PagesPerLevel + (brick.x & mask) + (brick.y & mask) * WindowSize + (brick.z & mask) * WindowSize * WindowSize;
+	}
+
+	// Centers the windows in position, the slots of the bricks that left are cleared
+	// the bricks that entered are appended to exposed, all of them the first time
+	void SetFocus(const glm::vec3& position, std::vector<Region>& exposed);
+
+	// Every brick of the windows
+	Bounds GetWindowBounds() const;
+	// Only the bricks of the region
+	Bounds GetRegionBounds(const Region& region) const;
+	// World bounds of the bricks of the region
+	void GetRegionWorldBounds(const Region& region, glm::vec3& min, glm::vec3& max) const;
+
+	// Adds (value 1) or removes (value 0) the cells (of 0.1) in every level, skipping the bricks outside bounds
+	// every add has to be removed with the same cells, the counts saturate at 65535
+	// appends to dirty the pages with cells set or cleared for the first time since the last Flush
+	// Can be called from the Jobs threads, each with its own dirty
+	void WriteCells(const std::vector<glm::ivec3>& cells, int value, const Bounds& bounds, std::vector<int32>& dirty);
+
+	// Builds the bytes and masks of the dirty bricks from the counts, frees the ones left empty and appends the others to changed
+	// Not thread safe, call it after the writes completed
+	void Flush(const std::vector<int32>& dirty, std::vector<int32>& changed);
+
+	// Appends every allocated brick
+	void GetBricks(std::vector<int32>& bricks) const;
+
+	bool GetCell(const glm::ivec3& cell, int32 level) const;
+
+	// Tells if any cell of the block is set, block is in cells of the first level divided by 2^mip
+	// far from the focus the coarse levels answer, the same as the shaders do
+	bool IsOccupied(const glm::ivec3& block, int32 mip) const;
+	// Tells if any cell in the world bounds is set, only the surface of the casters is in the volume
+	bool IsOccupied(const glm::vec3& min, const glm::vec3& max) const;
+
+	static uint64 ComputeMask(const uint8* brick);
+
+	// Tells if any page changed since the last call
+	bool ConsumePagesChanged() { return _PagesChanged.exchange(false); }
+
+	int32 GetPage(int32 index) const { return _Pages[index].load(std::memory_order_relaxed); }
+	const glm::ivec3& GetOrigin(int32 level) const { return _Origins[level]; }
+	int32 GetChunkCount() const { return _ChunkCount; }
+	int32 GetBrickCount() const { return _BrickCount - (int32)_FreeBricks.size(); }
+	uint8* GetBrickData(int32 brick) { return _Chunks[brick / ChunkBricks].get() + (size_t)(brick % ChunkBricks) * BrickBytes; }
+	const uint8* GetBrickData(int32 brick) const { return _Chunks[brick / ChunkBricks].get() + (size_t)(brick % ChunkBricks) * BrickBytes; }
+	uint16* GetBrickCounts(int32 brick) { return _ChunkCounts[brick / ChunkBricks].get() + (size_t)(brick % ChunkBricks) * BrickCells; }
+	const uint16* GetBrickCounts(int32 brick) const { return _ChunkCounts[brick / ChunkBricks].get() + (size_t)(brick % ChunkBricks) * BrickCells; }
+	// Bit x + y*4 + z*16 is set when the block of 4^3 cells has any cell set
+	uint64 GetBrickMask(int32 brick) const { return _ChunkMasks[brick / ChunkBricks][brick % ChunkBricks]; }
+};
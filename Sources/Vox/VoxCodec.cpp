@@ -0,0 +1,217 @@
+#include "VoxCodec.h"
+
+#include "Util/LZ.h"
+
+#include <cstring>
+
+int32 VoxCodec::PackBrick(const uint8* cells, uint8* dst) {
+	//Palette
+	uint8 palette[16];
+	int32 paletteCount = 0;
+	uint8 indices[256];
+	memset(indices, 0xFF, sizeof(indices));
+	for (int32 i = 0; i < BrickCells && paletteCount <= 16; i++) {
+		if (indices[cells[i]] != 0xFF)continue;
+		if (paletteCount < 16) {
+			indices[cells[i]] = (uint8)paletteCount;
+			palette[paletteCount] = cells[i];
+		}
+		paletteCount++;
+	}
+
+	int32 bits = paletteCount <= 1 ? 0 : paletteCount <= 2 ? 1 : paletteCount <= 4 ? 2 : 4;
+	int32 paletteSize = paletteCount <= 16 ? 2 + paletteCount + BrickCells * bits / 8 : INT32_MAX;
+
+	//Runs of up to 256 cells
+	int32 runCount = 0;
+	for (int32 i = 0; i < BrickCells;) {
+		int32 start = i;
+		while (i < BrickCells && i - start < 256 && cells[i] == cells[start])i++;
+		runCount++;
+	}
+	int32 runsSize = 1 + runCount * 2;
+
+	if (paletteSize <= runsSize && paletteSize < 1 + BrickCells) {
+		dst[0] = (uint8)BrickMode::Palette;
+		dst[1] = (uint8)paletteCount;
+		memcpy(dst + 2, palette, paletteCount);
+		uint8* packed = dst + 2 + paletteCount;
+		if (bits > 0) {
+			memset(packed, 0, BrickCells * bits / 8);
+			for (int32 i = 0; i < BrickCells; i++) {
+				int32 bit = i * bits;
+				packed[bit >> 3] |= (uint8)(indices[cells[i]] << (bit & 7));
+			}
+		}
+		return paletteSize;
+	}
+
+	if (runsSize < 1 + BrickCells) {
+		dst[0] = (uint8)BrickMode::Runs;
+		uint8* run = dst + 1;
+		for (int32 i = 0; i < BrickCells;) {
+			int32 start = i;
+			while (i < BrickCells && i - start < 256 && cells[i] == cells[start])i++;
+			*run++ = cells[start];
+			*run++ = (uint8)(i - start - 1);
+		}
+		return runsSize;
+	}
+
+	dst[0] = (uint8)BrickMode::Raw;
+	memcpy(dst + 1, cells, BrickCells);
+	return 1 + BrickCells;
+}
+
+int32 VoxCodec::UnpackBrick(const uint8* src, int32 size, uint8* cells) {
+	if (size < 1)return 0;
+
+	switch ((BrickMode)src[0]) {
+	case BrickMode::Raw:
+		if (size < 1 + BrickCells)return 0;
+		memcpy(cells, src + 1, BrickCells);
+		return 1 + BrickCells;
+
+	case BrickMode::Palette: {
+		if (size < 2)return 0;
+		int32 paletteCount = src[1];
+		if (paletteCount < 1 || paletteCount > 16)return 0;
+		int32 bits = paletteCount <= 1 ? 0 : paletteCount <= 2 ? 1 : paletteCount <= 4 ? 2 : 4;
+		int32 packedSize = 2 + paletteCount + BrickCells * bits / 8;
+		if (size < packedSize)return 0;
+
+		const uint8* palette = src + 2;
+		if (bits == 0) {
+			memset(cells, palette[0], BrickCells);
+			return packedSize;
+		}
+
+		//Every index is read from its own byte, bits divides 8
+		const uint8* packed = src + 2 + paletteCount;
+		uint8 mask = (uint8)((1 << bits) - 1);
+		for (int32 i = 0; i < BrickCells; i++) {
+			int32 bit = i * bits;
+			uint8 index = (packed[bit >> 3] >> (bit & 7)) & mask;
+			if (index >= paletteCount)return 0;
+			cells[i] = palette[index];
+		}
+		return packedSize;
+	}
+
+	case BrickMode::Runs: {
+		int32 read = 1;
+		int32 i = 0;
+		while (i < BrickCells) {
+			if (read + 2 > size)return 0;
+			uint8 value = src[read];
+			int32 length = src[read + 1] + 1;
+			read += 2;
+			if (i + length > BrickCells)return 0;
+			memset(cells + i, value, length);
+			i += length;
+		}
+		return read;
+	}
+	}
+
+	return 0;
+}
+
+void VoxCodec::Write(Stream& S, const VoxGrid& grid) {
+	glm::ivec3 bricks = grid.GetBrickCount();
+	int32 brickCount = bricks.x * bricks.y * bricks.z;
+
+	std::vector<uint64> bitmap((brickCount + 63) / 64, 0);
+	std::vector<uint8> block;
+	block.reserve(BlockSize);
+	std::vector<uint8> packed(LZ::GetBound(BlockSize));
+	std::vector<std::vector<uint8>> blocks;
+	uint8 brickData[1 + BrickCells];
+
+	auto flushBlock = [&]() {
+		if (block.empty())return;
+		size_t packedSize = LZ::Compress(block.data(), block.size(), packed.data());
+		std::vector<uint8> data(sizeof(uint32) * 2 + packedSize);
+		uint32 rawSize = (uint32)block.size();
+		uint32 compressedSize = (uint32)packedSize;
+		memcpy(data.data(), &rawSize, sizeof(uint32));
+		memcpy(data.data() + sizeof(uint32), &compressedSize, sizeof(uint32));
+		memcpy(data.data() + sizeof(uint32) * 2, packed.data(), packedSize);
+		blocks.push_back(std::move(data));
+		block.clear();
+	};
+
+	//Bricks never span blocks, so a block is decoded alone
+	for (int32 i = 0; i < brickCount; i++) {
+		glm::ivec3 brick(i % bricks.x, (i / bricks.x) % bricks.y, i / (bricks.x * bricks.y));
+		if (grid.IsBrickEmpty(brick))continue;
+
+		bitmap[i / 64] |= 1ull << (i % 64);
+		int32 brickSize = PackBrick(grid.GetBrick(brick).Cells, brickData);
+		if ((int32)block.size() + brickSize > BlockSize)flushBlock();
+		block.insert(block.end(), brickData, brickData + brickSize);
+	}
+	flushBlock();
+
+	S.Serialize(bitmap.data(), bitmap.size() * sizeof(uint64));
+	uint32 blockCount = (uint32)blocks.size();
+	S | blockCount;
+	for (std::vector<uint8>& data : blocks) {
+		S.Serialize(data.data(), data.size());
+	}
+}
+
+bool VoxCodec::Read(Stream& S, VoxGrid& grid) {
+	glm::ivec3 bricks = grid.GetBrickCount();
+	int32 brickCount = bricks.x * bricks.y * bricks.z;
+
+	std::vector<uint64> bitmap((brickCount + 63) / 64, 0);
+	S.Serialize(bitmap.data(), bitmap.size() * sizeof(uint64));
+	uint32 blockCount = 0;
+	S | blockCount;
+
+	int32 allocated = 0;
+	for (uint64 bits : bitmap) {
+		for (; bits != 0; bits &= bits - 1)allocated++;
+	}
+	grid.Reserve(allocated);
+
+	std::vector<uint8> packed;
+	std::vector<uint8> block(BlockSize);
+	int32 brick = -1;
+
+	auto nextBrick = [&]() {
+		for (brick++; brick < brickCount; brick++) {
+			if (bitmap[brick / 64] & (1ull << (brick % 64)))return true;
+		}
+		return false;
+	};
+
+	for (uint32 b = 0; b < blockCount; b++) {
+		uint32 rawSize = 0, packedSize = 0;
+		S | rawSize | packedSize;
+		if (rawSize > BlockSize || packedSize > LZ::GetBound(BlockSize))return false;
+
+		//Decompressed in place from mapped files
+		const uint8* src = S.ReadView(packedSize);
+		if (src == nullptr) {
+			packed.resize(packedSize);
+			S.Serialize(packed.data(), packedSize);
+			src = packed.data();
+		}
+		if (!LZ::Decompress(src, packedSize, block.data(), rawSize))return false;
+
+		int32 read = 0;
+		while (read < (int32)rawSize) {
+			if (!nextBrick())return false;
+			glm::ivec3 position(brick % bricks.x, (brick / bricks.x) % bricks.y, brick / (bricks.x * bricks.y));
+			int32 brickSize = UnpackBrick(block.data() + read, (int32)rawSize - read, grid.WriteBrick(position));
+			grid.UpdateBrick(position);
+			if (brickSize == 0)return false;
+			read += brickSize;
+		}
+	}
+
+	//Every brick in the bitmap has to be in the blocks
+	return !nextBrick();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "IO/Stream.h"
+#include "VoxGrid.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Compressed format of the voxel grids saved by the VoxAssets
+// The grid is split in bricks of BrickSize^3, a bitmap tells which have any voxel and only those are written
+// every brick is packed as raw bytes, a palette of up to 16 values or runs, whatever is smaller
+// the packed bricks are grouped in blocks of up to BlockSize bytes compressed with LZ
+class VoxCodec {
+public:
+	// The bricks are the ones of the VoxGrid
+	inline static constexpr int32 BrickSize = VoxGrid::BrickSize;
+	inline static constexpr int32 BrickCells = VoxGrid::BrickCells;
+	inline static constexpr int32 BlockSize = 64 * 1024;
+
+	enum class BrickMode : uint8 {
+		Raw,
+		Palette,
+		Runs,
+	};
+
+	static void Write(Stream& S, const VoxGrid& grid);
+
+	// Decodes the bricks in grid as every block is read, only one block is kept in memory
+	// grid has to be empty and sized
+	// Returns false when the data is corrupted
+	static bool Read(Stream& S, VoxGrid& grid);
+
+	// Packs the brick cells (x + y*8 + z*64) in dst, that has to have 1 + BrickCells bytes, returns the bytes written
+	static int32 PackBrick(const uint8* cells, uint8* dst);
+	// Returns the bytes read from src, 0 when is corrupted
+	static int32 UnpackBrick(const uint8* src, int32 size, uint8* cells);
+};
@@ -0,0 +1,136 @@
+#include "VoxGrid.h"
+
+#include <cstring>
+
+VoxGrid::VoxGrid() {
+	_Bricks.resize(1);
+	memset(&_Bricks[0], 0, sizeof(Brick));
+}
+
+void VoxGrid::Resize(const glm::ivec3& size) {
+	_Size = size;
+	_BrickCount = (size + BrickSize - 1) / BrickSize;
+	_Table.assign((size_t)_BrickCount.x * _BrickCount.y * _BrickCount.z, 0);
+	_Bricks.resize(1);
+	_FreeBricks.clear();
+}
+
+uint8* VoxGrid::WriteBrick(const glm::ivec3& brick) {
+	int32& index = _Table[SlotIndex(brick)];
+	if (index == 0) {
+		if (!_FreeBricks.empty()) {
+			index = _FreeBricks.back();
+			_FreeBricks.pop_back();
+		}
+		else {
+			index = (int32)_Bricks.size();
+			_Bricks.emplace_back();
+		}
+		memset(&_Bricks[index], 0, sizeof(Brick));
+	}
+	return _Bricks[index].Cells;
+}
+
+void VoxGrid::UpdateBrick(const glm::ivec3& brick) {
+	int32& index = _Table[SlotIndex(brick)];
+	if (index == 0)return;
+	Brick& b = _Bricks[index];
+
+	//Edge bricks may have cells outside the grid
+	glm::ivec3 inside = glm::min(_Size - brick * BrickSize, glm::ivec3(BrickSize));
+	bool any = false;
+	for (int32 word = 0; word < BrickCells / 64; word++) {
+		uint64 bits = 0;
+		for (int32 i = 0; i < 64; i++) {
+			int32 cell = word * 64 + i;
+			glm::ivec3 p = CellPosition(cell);
+			if (p.x >= inside.x || p.y >= inside.y || p.z >= inside.z)b.Cells[cell] = 0;
+			bits |= (uint64)(b.Cells[cell] != 0) << i;
+		}
+		b.Occupancy[word] = bits;
+		any |= bits != 0;
+	}
+
+	if (!any) {
+		_FreeBricks.push_back(index);
+		index = 0;
+	}
+}
+
+void VoxGrid::Set(const glm::ivec3& voxel, uint8 value) {
+	if (glm::any(glm::lessThan(voxel, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(voxel, _Size)))return;
+
+	glm::ivec3 brick = voxel >> BrickShift;
+	int32 cell = CellIndex(voxel & (BrickSize - 1));
+	if (IsBrickEmpty(brick)) {
+		if (value == 0)return;
+		WriteBrick(brick);
+	}
+
+	int32& index = _Table[SlotIndex(brick)];
+	Brick& b = _Bricks[index];
+	b.Cells[cell] = value;
+
+	uint64 bit = 1ull << (cell & 63);
+	if (value != 0) {
+		b.Occupancy[cell / 64] |= bit;
+		return;
+	}
+
+	b.Occupancy[cell / 64] &= ~bit;
+	for (int32 word = 0; word < BrickCells / 64; word++) {
+		if (b.Occupancy[word] != 0)return;
+	}
+	_FreeBricks.push_back(index);
+	index = 0;
+}
+
+void VoxGrid::CopyToDense(uint8* dst) const {
+	const size_t strideY = (size_t)_Size.x;
+	const size_t strideZ = (size_t)_Size.x * _Size.y;
+
+	for (int32 z = 0; z < _Size.z; z++) {
+		for (int32 y = 0; y < _Size.y; y++) {
+			uint8* row = dst + (size_t)y * strideY + (size_t)z * strideZ;
+			for (int32 bx = 0; bx < _BrickCount.x; bx++) {
+				glm::ivec3 brick(bx, y >> BrickShift, z >> BrickShift);
+				int32 width = glm::min(BrickSize, _Size.x - bx * BrickSize);
+				const uint8* src = GetBrick(brick).Cells + CellIndex(glm::ivec3(0, y & (BrickSize - 1), z & (BrickSize - 1)));
+				memcpy(row + bx * BrickSize, src, width);
+			}
+		}
+	}
+}
+
+void VoxGrid::CopyFromDense(const uint8* src, const glm::ivec3& size) {
+	Resize(size);
+	const size_t strideY = (size_t)_Size.x;
+	const size_t strideZ = (size_t)_Size.x * _Size.y;
+
+	for (int32 bz = 0; bz < _BrickCount.z; bz++) {
+		for (int32 by = 0; by < _BrickCount.y; by++) {
+			for (int32 bx = 0; bx < _BrickCount.x; bx++) {
+				glm::ivec3 brick(bx, by, bz);
+				glm::ivec3 min = brick * BrickSize;
+				glm::ivec3 max = glm::min(min + BrickSize, _Size);
+				int32 width = max.x - min.x;
+
+				//Only allocated when a row has any voxel
+				uint8* cells = nullptr;
+				for (int32 z = min.z; z < max.z; z++) {
+					for (int32 y = min.y; y < max.y; y++) {
+						const uint8* row = src + (size_t)min.x + (size_t)y * strideY + (size_t)z * strideZ;
+						bool any = false;
+						for (int32 x = 0; x < width; x++) any |= row[x] != 0;
+						if (!any)continue;
+
+						if (cells == nullptr)cells = WriteBrick(brick);
+						memcpy(cells + CellIndex(glm::ivec3(0, y - min.y, z - min.z)), row, width);
+					}
+				}
+				if (cells != nullptr)UpdateBrick(brick);
+			}
+		}
+	}
+	_Bricks.shrink_to_fit();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Core/Core.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Sparse voxel grid split in bricks of BrickSize^3, only the bricks with any voxel set are allocated
+// the others point to a shared empty brick, so reading a voxel never checks if its brick exists
+class VoxGrid {
+public:
+	inline static constexpr int32 BrickShift = 3;
+	inline static constexpr int32 BrickSize = 1 << BrickShift;
+	inline static constexpr int32 BrickCells = BrickSize * BrickSize * BrickSize;
+
+	// Cell index = x + y*8 + z*64, bit i of Occupancy is set when Cells[i] is not 0
+	struct Brick {
+		uint8 Cells[BrickCells];
+		uint64 Occupancy[BrickCells / 64];
+	};
+
+private:
+	glm::ivec3 _Size{ 0, 0, 0 };
+	glm::ivec3 _BrickCount{ 0, 0, 0 };
+	// Brick of every slot, 0 is the shared empty brick
+	std::vector<int32> _Table;
+	std::vector<Brick> _Bricks;
+	std::vector<int32> _FreeBricks;
+
+	inline size_t SlotIndex(const glm::ivec3& brick) const {
+		return (size_t)brick.x + (size_t)brick.y * _BrickCount.x + (size_t)brick.z * _BrickCount.x * _BrickCount.y;
+	}
+
+	static inline uint32 FirstBit(uint64 bits) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+
+public:
+
+	VoxGrid();
+	VoxGrid(const glm::ivec3& size) : VoxGrid() { Resize(size); }
+
+	// Clears every voxel
+	void Resize(const glm::ivec3& size);
+	// Allocates room for the bricks at once, when their count is known
+	void Reserve(int32 bricks) { _Bricks.reserve((size_t)bricks + 1); }
+
+	static inline int32 CellIndex(const glm::ivec3& cell) {
+		return cell.x + (cell.y << BrickShift) + (cell.z << (BrickShift * 2));
+	}
+	static inline glm::ivec3 CellPosition(int32 index) {
+		return glm::ivec3(index & (BrickSize - 1), (index >> BrickShift) & (BrickSize - 1), index >> (BrickShift * 2));
+	}
+
+	// Voxels outside the grid are 0
+	inline uint8 Get(const glm::ivec3& voxel) const {
+		if (glm::any(glm::lessThan(voxel, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(voxel, _Size)))return 0;
+		return _Bricks[_Table[SlotIndex(voxel >> BrickShift)]].Cells[CellIndex(voxel & (BrickSize - 1))];
+	}
+	// Voxels outside the grid are ignored, the brick is allocated or freed when needed
+	void Set(const glm::ivec3& voxel, uint8 value);
+
+	inline const Brick& GetBrick(const glm::ivec3& brick) const { return _Bricks[_Table[SlotIndex(brick)]]; }
+	inline bool IsBrickEmpty(const glm::ivec3& brick) const { return _Table[SlotIndex(brick)] == 0; }
+
+	// Cells of the brick to be written, allocates it, call UpdateBrick after writing them
+	uint8* WriteBrick(const glm::ivec3& brick);
+	// Rebuilds the occupancy of the brick from its cells, clearing the ones outside the grid, frees it when is empty
+	void UpdateBrick(const glm::ivec3& brick);
+
+	// Calls callback(glm::ivec3 brick, const Brick&) for every allocated brick, in x, y, z order
+	template<typename T>
+	void ForEachBrick(T callback) const {
+		for (int32 z = 0; z < _BrickCount.z; z++) {
+			for (int32 y = 0; y < _BrickCount.y; y++) {
+				for (int32 x = 0; x < _BrickCount.x; x++) {
+					glm::ivec3 brick(x, y, z);
+					int32 index = _Table[SlotIndex(brick)];
+					if (index != 0)callback(brick, _Bricks[index]);
+				}
+			}
+		}
+	}
+
+	// Calls callback(glm::ivec3 voxel, uint8 value) for every voxel not 0, only visits the occupied bits
+	template<typename T>
+	void ForEachVoxel(T callback) const {
+		ForEachBrick([&](const glm::ivec3& brick, const Brick& b) {
+			glm::ivec3 origin = brick * BrickSize;
+			for (int32 word = 0; word < BrickCells / 64; word++) {
+				uint64 bits = b.Occupancy[word];
+				while (bits != 0) {
+					int32 cell = word * 64 + (int32)FirstBit(bits);
+					bits &= bits - 1;
+					callback(origin + CellPosition(cell), b.Cells[cell]);
+				}
+			}
+		});
+	}
+
+	// Writes the dense grid (index = x + y*sizeX + z*sizeX*sizeY) in dst, every byte is written
+	void CopyToDense(uint8* dst) const;
+	// Resizes the grid to size and fills it from a dense grid
+	void CopyFromDense(const uint8* src, const glm::ivec3& size);
+
+	glm::ivec3 GetSize() const { return _Size; }
+	glm::ivec3 GetBrickCount() const { return _BrickCount; }
+	int32 GetAllocatedBricks() const { return (int32)(_Bricks.size() - 1 - _FreeBricks.size()); }
+	// Bytes used by the table and the bricks
+	size_t GetMemoryUsage() const { return _Table.capacity() * sizeof(int32) + _Bricks.capacity() * sizeof(Brick) + _FreeBricks.capacity() * sizeof(int32); }
+};
@@ -0,0 +1,175 @@
+#include "VoxSurface.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define VOXSURFACE_SSE
+#include <emmintrin.h>
+#endif
+
+// A voxel with at least minValue is surface when any of its 26 neighbors is under it
+static inline bool IsSurface(const VoxGrid& grid, const glm::ivec3& voxel, uint8 minValue) {
+	for (int32 n = 0; n < 27; n++) {
+		if (grid.Get(voxel + glm::ivec3(n % 3 - 1, (n / 3) % 3 - 1, n / 9 - 1)) < minValue)return true;
+	}
+	return false;
+}
+
+void VoxSurface::Add(const glm::ivec3& voxel) {
+	_X.push_back((float)voxel.x);
+	_Y.push_back((float)voxel.y);
+	_Z.push_back((float)voxel.z);
+}
+
+void VoxSurface::Pad() {
+	//Padding repeats the last voxel, writing it twice is harmless
+	_Count = (uint32)_X.size();
+	while (!_X.empty() && _X.size() % 4 != 0) {
+		_X.push_back(_X.back());
+		_Y.push_back(_Y.back());
+		_Z.push_back(_Z.back());
+	}
+}
+
+void VoxSurface::Build(const VoxGrid& grid, uint8 minValue) {
+	_X.clear();
+	_Y.clear();
+	_Z.clear();
+
+	grid.ForEachVoxel([&](const glm::ivec3& voxel, uint8 value) {
+		if (value >= minValue && IsSurface(grid, voxel, minValue)) {
+			Add(voxel);
+		}
+	});
+	Pad();
+}
+
+void VoxSurface::Rebuild(const VoxSurface& previous, const VoxGrid& grid, uint8 minValue, const glm::ivec3& min, const glm::ivec3& max) {
+	_X.clear();
+	_Y.clear();
+	_Z.clear();
+
+	glm::ivec3 lo = glm::max(min - 1, glm::ivec3(0));
+	glm::ivec3 hi = glm::min(max + 1, grid.GetSize() - 1);
+
+	//The voxels outside keep the same neighbors
+	glm::vec3 flo(lo);
+	glm::vec3 fhi(hi);
+	_X.reserve(previous._X.size());
+	_Y.reserve(previous._X.size());
+	_Z.reserve(previous._X.size());
+	for (uint32 i = 0; i < previous._Count; i++) {
+		float x = previous._X[i], y = previous._Y[i], z = previous._Z[i];
+		if (x >= flo.x && y >= flo.y && z >= flo.z && x <= fhi.x && y <= fhi.y && z <= fhi.z)continue;
+		_X.push_back(x);
+		_Y.push_back(y);
+		_Z.push_back(z);
+	}
+
+	//The bricks without voxels are skipped
+	glm::ivec3 brickLo = lo >> VoxGrid::BrickShift;
+	glm::ivec3 brickHi = hi >> VoxGrid::BrickShift;
+	for (int32 bz = brickLo.z; bz <= brickHi.z; bz++) {
+		for (int32 by = brickLo.y; by <= brickHi.y; by++) {
+			for (int32 bx = brickLo.x; bx <= brickHi.x; bx++) {
+				glm::ivec3 brick(bx, by, bz);
+				if (grid.IsBrickEmpty(brick))continue;
+
+				glm::ivec3 from = glm::max(lo, brick * VoxGrid::BrickSize);
+				glm::ivec3 to = glm::min(hi, brick * VoxGrid::BrickSize + (VoxGrid::BrickSize - 1));
+				for (int32 z = from.z; z <= to.z; z++) {
+					for (int32 y = from.y; y <= to.y; y++) {
+						for (int32 x = from.x; x <= to.x; x++) {
+							glm::ivec3 voxel(x, y, z);
+							if (grid.Get(voxel) >= minValue && IsSurface(grid, voxel, minValue)) {
+								Add(voxel);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	Pad();
+}
+
+void VoxSurface::Extract(const glm::ivec3& min, const glm::ivec3& max, VoxSurface& out) const {
+	out._X.clear();
+	out._Y.clear();
+	out._Z.clear();
+
+	glm::vec3 lo(min);
+	glm::vec3 hi(max);
+	for (uint32 i = 0; i < _Count; i++) {
+		if (_X[i] < lo.x || _Y[i] < lo.y || _Z[i] < lo.z || _X[i] > hi.x || _Y[i] > hi.y || _Z[i] > hi.z)continue;
+		out._X.push_back(_X[i]);
+		out._Y.push_back(_Y[i]);
+		out._Z.push_back(_Z[i]);
+	}
+
+	out.Pad();
+}
+
+void VoxSurface::TransformScalar(const glm::mat4& gridToWorld, std::vector<glm::ivec3>& cells) const {
+	cells.resize(_Count);
+
+	glm::vec3 o = gridToWorld[3];
+	glm::vec3 dx = gridToWorld[0] * 0.1f;
+	glm::vec3 dy = gridToWorld[1] * 0.1f;
+	glm::vec3 dz = gridToWorld[2] * 0.1f;
+
+	for (uint32 i = 0; i < _Count; i++) {
+		glm::vec3 wp = o + _X[i] * dx + _Y[i] * dy + _Z[i] * dz;
+		cells[i] = glm::ivec3(glm::floor(wp * 10.0f));
+	}
+}
+
+#ifdef VOXSURFACE_SSE
+
+void VoxSurface::Transform(const glm::mat4& gridToWorld, std::vector<glm::ivec3>& cells) const {
+	//The padded voxels are written past _Count and dropped by the last resize
+	cells.resize(_X.size());
+
+	glm::vec3 o = gridToWorld[3];
+	glm::vec3 dx = gridToWorld[0] * 0.1f;
+	glm::vec3 dy = gridToWorld[1] * 0.1f;
+	glm::vec3 dz = gridToWorld[2] * 0.1f;
+
+	const __m128 ten = _mm_set1_ps(10.0f);
+	__m128 row[3][4];
+	for (int axis = 0; axis < 3; axis++) {
+		row[axis][0] = _mm_set1_ps(o[axis]);
+		row[axis][1] = _mm_set1_ps(dx[axis]);
+		row[axis][2] = _mm_set1_ps(dy[axis]);
+		row[axis][3] = _mm_set1_ps(dz[axis]);
+	}
+
+	for (size_t i = 0; i < _X.size(); i += 4) {
+		__m128 x = _mm_loadu_ps(&_X[i]);
+		__m128 y = _mm_loadu_ps(&_Y[i]);
+		__m128 z = _mm_loadu_ps(&_Z[i]);
+
+		alignas(16) int32 c[3][4];
+		for (int axis = 0; axis < 3; axis++) {
+			//Same order of operations as the scalar version
+			__m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(row[axis][0], _mm_mul_ps(x, row[axis][1])), _mm_mul_ps(y, row[axis][2])), _mm_mul_ps(z, row[axis][3]));
+			//Floor without SSE4.1, truncated values above the input are one too big (the mask is -1)
+			__m128 v = _mm_mul_ps(w, ten);
+			__m128i t = _mm_cvttps_epi32(v);
+			t = _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), v)));
+			_mm_store_si128((__m128i*)c[axis], t);
+		}
+
+		for (int lane = 0; lane < 4; lane++) {
+			cells[i + lane] = glm::ivec3(c[0][lane], c[1][lane], c[2][lane]);
+		}
+	}
+
+	cells.resize(_Count);
+}
+
+#else
+
+void VoxSurface::Transform(const glm::mat4& gridToWorld, std::vector<glm::ivec3>& cells) const {
+	TransformScalar(gridToWorld, cells);
+}
+
+#endif
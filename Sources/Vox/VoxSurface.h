@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "VoxGrid.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Coordinates of the voxels with a value of at least MinValue that touch one without it (26 neighbors)
+// Writing only the surface in a binary volume is enough to stop the rays, and scales with the area instead of the volume
+// Stored as a structure of arrays padded to 4 so they are transformed 4 at a time
+class VoxSurface {
+	std::vector<float> _X;
+	std::vector<float> _Y;
+	std::vector<float> _Z;
+	uint32 _Count{ 0 };
+
+	void Add(const glm::ivec3& voxel);
+	// Sets _Count and pads the arrays to 4
+	void Pad();
+
+public:
+
+	// Only the occupied voxels of the grid are visited
+	void Build(const VoxGrid& grid, uint8 minValue);
+
+	// Copies previous and builds again only the voxels in [min - 1, max + 1] (min and max inclusive), after the grid was edited in [min, max]
+	// the voxels next to the edit may have become (or stopped being) surface
+	void Rebuild(const VoxSurface& previous, const VoxGrid& grid, uint8 minValue, const glm::ivec3& min, const glm::ivec3& max);
+
+	// Only the voxels inside [min, max] (inclusive), to rewrite an edited part of a surface
+	void Extract(const glm::ivec3& min, const glm::ivec3& max, VoxSurface& out) const;
+
+	uint32 GetCount() const { return _Count; }
+
+	// Writes in cells the voxels corners transformed by gridToWorld (one voxel = 0.1), in cells of 0.1 rounded down
+	// cells is resized to GetCount()
+	void Transform(const glm::mat4& gridToWorld, std::vector<glm::ivec3>& cells) const;
+
+	// Scalar version of Transform, used as reference to check the SIMD one
+	void TransformScalar(const glm::mat4& gridToWorld, std::vector<glm::ivec3>& cells) const;
+};
@@ -98,6 +98,51 @@ struct Character {
 	float FootAirTime{ 0.0f };
 };
 
+// Physics collision layers of the entity and its children without a Collider
+// Entities without a Collider above them are in the Default layer, or in the Character layer if under a Character
+// The layers are resolved when the entity enters the PhysicsSystem, replace the Collider to refresh them
+struct Collider {
+	enum Layer : uint32 {
+		Default = 1 << 0,
+		Character = 1 << 1,
+		Trigger = 1 << 2,
+		Debris = 1 << 3,
+		All = 0xFFFFFFFF
+	};
+
+	uint32 Layers{ Default };
+};
+
+// Kinematic collision against the voxel world
+// Every simulated frame the PhysicsSystem moves the entity by Velocity, sliding along walls and stepping up small ledges
+// The collision shape is an axis aligned box centered at the entity position plus Offset
+struct CharacterController {
+	glm::vec3 Velocity{ 0.0f, 0.0f, 0.0f };
+	glm::vec3 HalfExtents{ 0.25f, 0.7f, 0.25f };
+	glm::vec3 Offset{ 0.0f, 0.0f, 0.0f };
+	float StepHeight{ 0.35f };
+	uint32 CollisionMask{ ~uint32(Collider::Character) };
+
+	//Set by the PhysicsSystem
+	bool IsGrounded{ false };
+};
+
+// Dynamic body simulated by the PhysicsSystem, the collision shape is the VoxRenderer voxels
+// Mass and inertia are computed from the solid voxels, the Transform scale is ignored
+// Resting bodies go to sleep and stop being simulated, replace the RigidBody to wake it up
+struct RigidBody {
+	glm::vec3 LinearVelocity{ 0.0f, 0.0f, 0.0f };
+	glm::vec3 AngularVelocity{ 0.0f, 0.0f, 0.0f };
+	float VoxelMass{ 0.5f }; // Kg per voxel
+	float Friction{ 0.5f };
+	float Restitution{ 0.1f };
+	uint32 CollisionMask{ ~uint32(Collider::Character | Collider::Trigger) };
+
+	//Set by the PhysicsSystem
+	bool IsSleeping{ false };
+	float SleepTime{ 0.0f };
+};
+
 // There should be only one Network Component per Hierarchy
 // Scripts will search bottom top for Network rpc commands
 // Set an callback in the NetworkingSystem to handle per NetworkComponent rpc
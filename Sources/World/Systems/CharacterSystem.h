@@ -1,11 +1,20 @@
 #pragma once
 
 #include "System.h"
+#include "World/Components.h"
+#include "World/Systems/PhysicsSystem.h"
+
 #include <glm/glm.hpp>
+#include <vector>
 
 class CharacterSystem : public System {
+	// Per frame feet probes, two rays per character (left, right)
+	std::vector<entt::entity> _Probes;
+	std::vector<Ray> _FeetRays;
+	std::vector<RayHit> _FeetHits;
 
 	void AttractEntity(entt::entity e, glm::vec3 target, float factor);
+	void UpdateCharacter(entt::entity e, Transform& t, Character& c, float dt, glm::vec3 target_left_foot, float hit_tl, glm::vec3 target_right_foot, float hit_tr);
 
 public:
 	virtual void OnCreate() {}
@@ -1,8 +1,15 @@
 #include "PhysicsSystem.h"
 
 #include "World/Components.h"
+#include "World/World.h"
+#include "World/Systems/TransformSystem.h"
 #include "Editor/EUI/EUI.h"
 #include "Asset/VoxAsset.h"
+#include "Profiler/Profiler.h"
+#include "Job/Jobs.h"
+#include "Physics/OBBBatch.h"
+
+#include <algorithm>
 
 bool RayPlaneCast(
 	const glm::vec3& planePos,
@@ -24,165 +31,927 @@ bool RayPlaneCast(
 	return true;
 }
 
-bool RayDoublePlaneCast(
-	const glm::vec3& planePos,
-	const glm::vec3& planeNormal,
-	const float      planeDist,
+// Casts the ray against the voxels of the box using the occupancy pyramid
+// t is in the same units as the ray so the hit point is rayPos + rayDir*t
+// a ray starting inside a solid voxel hits it at t = 0, it doesn't go through to the next surface
+bool RayVoxCast(
+	const OBB& box,
+	const VoxOccupancy& occupancy,
 	const glm::vec3& rayPos,
 	const glm::vec3& rayDir,
-	float& tMin,
-	float& tMax) {
+	float maxT,
+	float& t
+) {
+	//The box is in meters, the occupancy in voxels
+	glm::vec3 localPos = (box.InvMatrix * glm::vec4(rayPos, 1.0f)) * 10.0f;
+	glm::vec3 localDir = (box.InvMatrix * glm::vec4(rayDir, 0.0f)) * 10.0f;
 
-	glm::vec3 delta = rayPos - planePos;
-	float x = glm::dot(delta, planeNormal); //Distance to plane
-	float y = glm::dot(rayDir, planeNormal);//projected rayDir
+	glm::ivec3 voxel;
+	return occupancy.RayCast(localPos, localDir, maxT, t, voxel);
+}
 
-	//If don't hit both planes
-	if (y * x > 0.0f && y * (x - planeDist) > 0.0f) {
-		return false;
+// The voxel grid to world matrix and the grid size in voxels
+static void GetVoxOBB(Transform& tr, VoxRenderer& v, glm::mat4& obb, glm::vec3& size) {
+	obb = glm::translate(tr.WorldMatrix, -v.Pivot);
+	size = v.Vox->GetGrid().GetSize();
+}
+
+void PhysicsSystem::OnCreate() {
+	R->on_construct<VoxRenderer>().connect<&PhysicsSystem::OnVoxRendererChanged>(this);
+	R->on_update<VoxRenderer>().connect<&PhysicsSystem::OnVoxRendererChanged>(this);
+	R->on_destroy<VoxRenderer>().connect<&PhysicsSystem::OnProxyDestroyed>(this);
+	R->on_destroy<Transform>().connect<&PhysicsSystem::OnProxyDestroyed>(this);
+
+	R->on_construct<Collider>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_update<Collider>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_destroy<Collider>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_construct<Character>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_destroy<Character>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_construct<CharacterController>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_destroy<CharacterController>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_construct<RigidBody>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	R->on_destroy<RigidBody>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+	//World::SetParent patches the Hierarchy
+	R->on_update<Hierarchy>().connect<&PhysicsSystem::OnHierarchyChanged>(this);
+
+	R->on_update<RigidBody>().connect<&PhysicsSystem::OnRigidBodyUpdated>(this);
+}
+
+void PhysicsSystem::OnVoxRendererChanged(entt::registry& r, entt::entity e) {
+	_PendingProxies.push_back(e);
+}
+
+void PhysicsSystem::OnProxyDestroyed(entt::registry& r, entt::entity e) {
+	RemoveProxy(e);
+}
+
+void PhysicsSystem::OnHierarchyChanged(entt::registry& r, entt::entity e) {
+	_PendingHierarchy.push_back(e);
+}
+
+uint32 PhysicsSystem::ResolveLayers(entt::entity e) {
+	//Called from UpdateBroadphase, so components destroyed this frame are already removed
+	for (entt::entity p = e; p != entt::null; p = W->GetParent(p)) {
+		if (R->has<Collider>(p)) {
+			return R->get<Collider>(p).Layers;
+		}
+		if (R->has<Character>(p)) {
+			return Collider::Character;
+		}
+	}
+	return Collider::Default;
+}
+
+entt::entity PhysicsSystem::ResolveOwner(entt::entity e) {
+	for (entt::entity p = e; p != entt::null; p = W->GetParent(p)) {
+		if (R->has<RigidBody>(p) || R->has<CharacterController>(p)) {
+			return p;
+		}
+	}
+	return e;
+}
+
+void PhysicsSystem::UpdateHierarchyRecursive(entt::entity e) {
+	auto it = _Proxies.find(e);
+	if (it != _Proxies.end()) {
+		ProxyData& data = _ProxyData[it->second];
+		data.Layers = ResolveLayers(e);
+		data.Owner = ResolveOwner(e);
 	}
 
-	float t1 = -(x / y);
-	float t2 = -((x - planeDist) / y);
+	if (R->has<Hierarchy>(e)) {
+		W->ForEachChild(e, [&](entt::entity child) {
+			UpdateHierarchyRecursive(child);
+		});
+	}
+}
+
+void PhysicsSystem::UpdateProxy(entt::entity e) {
+	if (!R->valid(e) || !R->has<Transform, VoxRenderer>(e)) {
+		RemoveProxy(e);
+		return;
+	}
 
-	if (t1 < t2) {
-		tMin = t1;
-		tMax = t2;
+	VoxRenderer& v = R->get<VoxRenderer>(e);
+	if (!v.Vox.IsValid()) {
+		RemoveProxy(e);
+		return;
+	}
+
+	glm::mat4 obb;
+	glm::vec3 size;
+	GetVoxOBB(R->get<Transform>(e), v, obb, size);
+	AABB box = AABB::FromOBB(obb, size * 0.1f);
+
+	int32 proxy;
+	auto it = _Proxies.find(e);
+	if (it == _Proxies.end()) {
+		proxy = _Tree.Insert(box, static_cast<int32>(entt::to_integral(e)));
+		_Proxies.emplace(e, proxy);
+
+		if ((size_t)proxy >= _ProxyData.size()) {
+			_ProxyData.resize((size_t)proxy + 1);
+		}
+		_ProxyData[proxy].Layers = ResolveLayers(e);
+		_ProxyData[proxy].Owner = ResolveOwner(e);
 	}
 	else {
-		tMin = t2;
-		tMax = t1;
+		proxy = it->second;
+		AABB previous = _Tree.GetFatAABB(proxy);
+		_Tree.Move(proxy, box);
+
+		//Something moved the static world, the bodies resting on it have to fall
+		if (!R->has<RigidBody>(e)) {
+			WakeBodies(AABB::Union(previous, box), _ProxyData[proxy].Layers);
+		}
 	}
 
-	return true;
+	ProxyData& data = _ProxyData[proxy];
+	data.Box = OBB(obb, size * 0.1f);
+	data.Vox = v.Vox;
 }
 
-bool RayOBBCast(
-	const glm::mat4& obb,
-	const glm::vec3& obbSize,
-	const glm::vec3& rayPos,
-	const glm::vec3& rayDir,
-	float& t
-	) {
+void PhysicsSystem::RemoveProxy(entt::entity e) {
+	auto it = _Proxies.find(e);
+	if (it != _Proxies.end()) {
+		AABB box = _Tree.GetFatAABB(it->second);
+		uint32 layers = _ProxyData[it->second].Layers;
+		_Tree.Remove(it->second);
+		_ProxyData[it->second] = ProxyData();
+		_Proxies.erase(it);
 
-	glm::vec3 pos = obb[3];
+		WakeBodies(box, layers);
+	}
+}
 
-	float greatestMin = -99999999.0f;
-	float smallestMax = 99999999.0f;
+void PhysicsSystem::UpdateBroadphase() {
+	PROFILE_FUNC();
 
-	//TODO: Normalize Directions
-	float xMin = 0.0f;
-	float xMax = 0.0f;
+	for (entt::entity e : _PendingProxies) {
+		UpdateProxy(e);
+	}
+	_PendingProxies.clear();
 
-	for (int i = 0; i < 3; i++) {
-		if (RayDoublePlaneCast(pos, glm::normalize(obb[i]), obbSize[i]*glm::length(obb[i]), rayPos, rayDir, xMin, xMax)) {
-			greatestMin = glm::max(greatestMin, xMin);
-			smallestMax = glm::min(smallestMax, xMax);
+	for (entt::entity e : _PendingHierarchy) {
+		if (R->valid(e)) {
+			UpdateHierarchyRecursive(e);
 		}
-		else {
-			return false;
+	}
+	_PendingHierarchy.clear();
+
+	R->view<Transform, VoxRenderer, Changed>().each([&](const entt::entity e, Transform& tr, VoxRenderer& v) {
+		UpdateProxy(e);
+	});
+}
+
+bool PhysicsSystem::RayCast(glm::vec3 start, glm::vec3 dir, float& hitt, entt::entity& hitEntity, const QueryFilter& filter) {
+	RayHit hit;
+	RayCast(Ray(start, dir), hit, filter);
+
+	hitt = hit.T;
+	if (hit.Hit) {
+		hitEntity = hit.Entity;
+	}
+	return hit.Hit;
+}
+
+void PhysicsSystem::RayCast(const Ray& ray, RayHit& hit, const QueryFilter& filter) {
+	const glm::vec3& start = ray.Origin;
+	const glm::vec3& dir = ray.Direction;
+
+	float bestt = ray.MaxT;
+	hit = RayHit();
+
+	//The tree gathers the candidates, the OBBs are tested with SIMD and then the voxels nearest first
+	OBBBatch batch;
+	int32 proxies[OBBBatch::Capacity];
+	float tEnter[OBBBatch::Capacity];
+	std::pair<float, int32> order[OBBBatch::Capacity];
+
+	auto flush = [&]() {
+		batch.RayCast(start, dir, bestt, tEnter);
+
+		int32 count = 0;
+		for (int32 i = 0; i < batch.GetCount(); i++) {
+			if (tEnter[i] < bestt) {
+				order[count++] = { tEnter[i], proxies[i] };
+			}
+		}
+		std::sort(order, order + count);
+
+		for (int32 i = 0; i < count && order[i].first < bestt; i++) {
+			ProxyData& data = _ProxyData[order[i].second];
+
+			//The occupancy clips the ray to the grid, so it's cast from the start and never behind it
+			float t;
+			if (RayVoxCast(data.Box, data.Vox->GetOccupancy(), start, dir, bestt, t)) {
+				bestt = t;
+				hit.Entity = static_cast<entt::entity>(_Tree.GetUserData(order[i].second));
+				hit.Hit = true;
+			}
+		}
+
+		batch.Clear();
+	};
+
+	_Tree.RayCast(start, dir, bestt, [&](int32 proxy, float maxT) {
+		if (!filter.Accepts(_ProxyData[proxy].Layers))return maxT;
+
+		proxies[batch.GetCount()] = proxy;
+		batch.Add(_ProxyData[proxy].Box);
+		if (batch.IsFull()) {
+			flush();
+		}
+
+		return bestt;
+	});
+
+	if (batch.GetCount() > 0) {
+		flush();
+	}
+
+	hit.T = bestt;
+}
+
+// Interleave the lower 10 bits of v with two zeros between each bit
+static uint32 ExpandBits(uint32 v) {
+	v = (v * 0x00010001u) & 0xFF0000FFu;
+	v = (v * 0x00000101u) & 0x0F00F00Fu;
+	v = (v * 0x00000011u) & 0xC30C30C3u;
+	v = (v * 0x00000005u) & 0x49249249u;
+	return v;
+}
+
+void PhysicsSystem::RayCastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits, const QueryFilter& filter) {
+	PROFILE_FUNC();
+
+	hits.resize(rays.size());
+	if (rays.empty())return;
+
+	//Small batches are not worth the Jobs overhead
+	if (rays.size() < 64) {
+		for (int i = 0; i < rays.size(); i++) {
+			RayCast(rays[i], hits[i], filter);
 		}
+		return;
+	}
+
+	//Sort by direction octant then by the morton code of the origin
+	glm::vec3 boundsMin = rays[0].Origin;
+	glm::vec3 boundsMax = rays[0].Origin;
+	for (const Ray& r : rays) {
+		boundsMin = glm::min(boundsMin, r.Origin);
+		boundsMax = glm::max(boundsMax, r.Origin);
 	}
+	glm::vec3 scale = 1023.0f / glm::max(boundsMax - boundsMin, glm::vec3(0.0001f));
+
+	std::vector<std::pair<uint32, uint32>> order(rays.size()); // (key, ray index)
+	for (uint32 i = 0; i < rays.size(); i++) {
+		const Ray& r = rays[i];
+		glm::uvec3 q = glm::uvec3((r.Origin - boundsMin) * scale);
+		uint32 octant = (r.Direction.x < 0.0f ? 1 : 0) | (r.Direction.y < 0.0f ? 2 : 0) | (r.Direction.z < 0.0f ? 4 : 0);
+		uint32 morton = ExpandBits(q.x) | (ExpandBits(q.y) << 1) | (ExpandBits(q.z) << 2);
+		order[i] = { (octant << 29) | (morton >> 1), i };
+	}
+	std::sort(order.begin(), order.end());
+
+	Jobs::Context ctx;
+	Jobs::ParallelFor(static_cast<uint32>(order.size()), [&](int index, int group) {
+		uint32 i = order[index].second;
+		RayCast(rays[i], hits[i], filter);
+	}, ctx);
+	Jobs::Complete(ctx);
+}
+
+void PhysicsSystem::OnUpdate(float dt) {
+	PROFILE_FUNC();
+
+	UpdateBodies(dt);
+}
+
+bool PhysicsSystem::OverlapsVoxels(const AABB& box, const std::vector<int32>& candidates) {
+	//Shrinks the box so touching a voxel face isn't an overlap
+	constexpr float Skin = 0.001f;
+
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extent = box.GetExtent();
+
+	for (int32 proxy : candidates) {
+		ProxyData& data = _ProxyData[proxy];
 
-	//src: http://www.opengl-tutorial.org/miscellaneous/clicking-on-objects/picking-with-custom-ray-obb-function/
-	if (greatestMin < smallestMax) {
-		t = greatestMin;
+		//The box in the voxel space of the candidate, enlarged if the candidate is rotated
+		const glm::mat4& m = data.Box.InvMatrix;
+		glm::vec3 localCenter = glm::vec3(m * glm::vec4(center, 1.0f)) * 10.0f;
+		glm::vec3 localExtent = (glm::abs(glm::vec3(m[0])) * extent.x + glm::abs(glm::vec3(m[1])) * extent.y + glm::abs(glm::vec3(m[2])) * extent.z) * 10.0f;
+
+		glm::ivec3 lo = glm::ivec3(glm::floor(localCenter - localExtent + Skin));
+		glm::ivec3 hi = glm::ivec3(glm::floor(localCenter + localExtent - Skin));
+
+		if (data.Vox->GetOccupancy().Overlaps(lo, hi)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+float PhysicsSystem::SweepAxis(AABB& box, int axis, float distance, const std::vector<int32>& candidates) {
+	if (distance == 0.0f)return 0.0f;
+
+	//Half a voxel per step so a thin wall can't be skipped
+	constexpr float MaxStep = 0.05f;
+	int32 steps = (int32)glm::ceil(glm::abs(distance) / MaxStep);
+
+	auto moved = [&](float d) {
+		AABB b = box;
+		b.Min[axis] += d;
+		b.Max[axis] += d;
+		return b;
+	};
+
+	float free = 0.0f;
+	for (int32 i = 1; i <= steps; i++) {
+		float d = distance * (float)i / (float)steps;
+		if (OverlapsVoxels(moved(d), candidates)) {
+			//Refine the contact between the last free and the blocked distance
+			float blocked = d;
+			for (int j = 0; j < 6; j++) {
+				float mid = (free + blocked) * 0.5f;
+				if (OverlapsVoxels(moved(mid), candidates)) {
+					blocked = mid;
+				}
+				else {
+					free = mid;
+				}
+			}
+			break;
+		}
+		free = d;
+	}
+
+	box = moved(free);
+	return free;
+}
+
+void PhysicsSystem::MoveController(ControllerMove& move, std::vector<int32>& candidates, float dt) {
+	CharacterController& cc = move.Controller;
+	QueryFilter filter(cc.CollisionMask);
+
+	glm::vec3 delta = cc.Velocity * dt;
+	glm::vec3 center = move.Position + cc.Offset;
+	AABB box(center - cc.HalfExtents, center + cc.HalfExtents);
+	glm::vec3 start = box.Min;
+
+	//Candidates around the whole movement, including the step up
+	AABB bounds = AABB::Union(box, AABB(box.Min + delta, box.Max + delta)).Expand(cc.StepHeight + 0.1f);
+	candidates.clear();
+	_Tree.Query(bounds, [&](int32 proxy) {
+		//The voxels of the character itself are skipped
+		if (filter.Accepts(_ProxyData[proxy].Layers) && _ProxyData[proxy].Owner != move.Entity) {
+			candidates.push_back(proxy);
+		}
 		return true;
+	});
+
+	bool wasGrounded = cc.IsGrounded;
+	cc.IsGrounded = false;
+
+	if (candidates.empty()) {
+		move.Delta = delta;
+		return;
+	}
+
+	//Started inside the voxels, push it up or let it move freely this frame
+	if (OverlapsVoxels(box, candidates)) {
+		bool solved = false;
+		for (float up = 0.05f; up <= cc.StepHeight + 0.0001f && !solved; up += 0.05f) {
+			AABB upBox(box.Min + glm::vec3(0, up, 0), box.Max + glm::vec3(0, up, 0));
+			if (!OverlapsVoxels(upBox, candidates)) {
+				box = upBox;
+				solved = true;
+			}
+		}
+		if (!solved) {
+			move.Delta = delta;
+			return;
+		}
+	}
+
+	//Horizontal movement, each axis is moved alone so it slides along the walls
+	for (int axis : { 0, 2 }) {
+		float moved = SweepAxis(box, axis, delta[axis], candidates);
+		if (glm::abs(moved - delta[axis]) < 0.00001f)continue;
+
+		//Blocked, try to step over it
+		if (wasGrounded && cc.StepHeight > 0.0f) {
+			AABB stepBox = box;
+			float up = SweepAxis(stepBox, 1, cc.StepHeight, candidates);
+			float stepMoved = SweepAxis(stepBox, axis, delta[axis] - moved, candidates);
+			SweepAxis(stepBox, 1, -up, candidates);
+
+			if (glm::abs(stepMoved) > 0.001f) {
+				box = stepBox;
+				moved += stepMoved;
+			}
+		}
+
+		if (glm::abs(moved - delta[axis]) >= 0.00001f) {
+			cc.Velocity[axis] = 0.0f;
+		}
+	}
+
+	//Vertical movement
+	float movedY = SweepAxis(box, 1, delta.y, candidates);
+	if (glm::abs(movedY - delta.y) >= 0.00001f) {
+		cc.IsGrounded = delta.y < 0.0f;
+		cc.Velocity.y = 0.0f;
+	}
+	else if (delta.y <= 0.0f) {
+		AABB probe(box.Min - glm::vec3(0, 0.02f, 0), box.Max - glm::vec3(0, 0.02f, 0));
+		cc.IsGrounded = OverlapsVoxels(probe, candidates);
+	}
+
+	move.Delta = box.Min - start;
+}
+
+void PhysicsSystem::UpdateControllers(float dt) {
+	_ControllerMoves.clear();
+	R->view<Transform, CharacterController>().each([&](const entt::entity e, Transform& t, CharacterController& cc) {
+		ControllerMove move;
+		move.Entity = e;
+		move.Position = W->Transform->GetWorldPosition(e);
+		move.Delta = glm::vec3(0.0f);
+		move.Controller = cc;
+		_ControllerMoves.push_back(move);
+	});
+
+	if (_ControllerMoves.empty())return;
+
+	//Small counts are not worth the Jobs overhead
+	if (_ControllerMoves.size() < 16) {
+		_Candidates.resize(1);
+		for (ControllerMove& move : _ControllerMoves) {
+			MoveController(move, _Candidates[0], dt);
+		}
 	}
 	else {
-		return false;
+		_Candidates.resize(Jobs::GetThreadCount());
+
+		Jobs::Context ctx;
+		Jobs::ParallelFor(static_cast<uint32>(_ControllerMoves.size()), [&](int index, int group) {
+			MoveController(_ControllerMoves[index], _Candidates[group], dt);
+		}, ctx);
+		Jobs::Complete(ctx);
+	}
+
+	for (ControllerMove& move : _ControllerMoves) {
+		CharacterController& cc = R->get<CharacterController>(move.Entity);
+		cc.Velocity = move.Controller.Velocity;
+		cc.IsGrounded = move.Controller.IsGrounded;
+
+		if (glm::length2(move.Delta) > 0.0f) {
+			W->Transform->SetWorldPosition(move.Entity, move.Position + move.Delta);
+		}
 	}
 }
 
+// Bodies are stepped at most this much per frame, big steps make the contacts explode
+static constexpr float MaxBodyStep = 1.0f / 30.0f;
+static constexpr int32 SolverIterations = 8;
+static constexpr int32 MaxContactsPerPair = 32;
+// Bodies slower than this (m/s and rad/s) for TimeToSleep seconds can sleep
+static constexpr float SleepVelocity = 0.1f;
+static constexpr float TimeToSleep = 0.5f;
+
+void PhysicsSystem::OnRigidBodyUpdated(entt::registry& r, entt::entity e) {
+	RigidBody& rb = r.get<RigidBody>(e);
+	rb.IsSleeping = false;
+	rb.SleepTime = 0.0f;
+}
 
-bool RayVoxCast(
-	const glm::mat4& obb,
-	const glm::vec3& obbSize,
-	AssetRefT<VoxAsset>& obbVox,
-	const glm::vec3& rayPos,
-	const glm::vec3& rayDir,
-	float& t
-) {
-	glm::mat4 invObb = glm::inverse(obb);
-	glm::vec3 localPos = (invObb * glm::vec4(rayPos, 1.0f))*10.0f;
-	invObb[3] = glm::vec4(0,0,0,1);
-	glm::vec3 localDir = invObb * glm::vec4(rayDir, 0.0f);
+void PhysicsSystem::WakeBodies(const AABB& bounds, uint32 layers) {
+	_Tree.Query(bounds, [&](int32 proxy) {
+		entt::entity e = static_cast<entt::entity>(_Tree.GetUserData(proxy));
+		RigidBody* rb = R->valid(e) ? R->try_get<RigidBody>(e) : nullptr;
+		if (rb && rb->IsSleeping && (rb->CollisionMask & layers) != 0) {
+			rb->IsSleeping = false;
+			rb->SleepTime = 0.0f;
+		}
+		return true;
+	});
+}
 
-	//Fix aligned directions (zeroes in localDir)
-	if (localDir.x == 0.0f)localDir.x = 0.00000001f;
-	if (localDir.y == 0.0f)localDir.y = 0.00000001f;
-	if (localDir.z == 0.0f)localDir.z = 0.00000001f;
+void PhysicsSystem::InitBody(int32 index) {
+	BodyInfo& info = _BodyInfos[index];
+	BodyState& body = _Bodies[index];
+	ProxyData& data = _ProxyData[info.Proxy];
+	const RigidBody& rb = R->get<RigidBody>(info.Entity);
+	const MassProperties& mass = data.Vox->GetMassProperties();
+
+	//The Transform may have been changed after the last UpdateBroadphase
+	glm::mat4 gridToWorld = glm::translate(W->Transform->GetWorldMatrix(info.Entity), -R->get<VoxRenderer>(info.Entity).Pivot);
+	data.Box = OBB(gridToWorld, data.Box.Size);
+
+	body.Position = gridToWorld * glm::vec4(mass.CenterOfMass, 1.0f);
+	body.Rotation = glm::normalize(W->Transform->GetWorldRotation(info.Entity));
+	body.LinearVelocity = rb.LinearVelocity;
+	body.AngularVelocity = rb.AngularVelocity;
+	body.InvMass = 1.0f / (mass.Mass * rb.VoxelMass);
+	body.InvInertiaLocal = glm::inverse(mass.Inertia * rb.VoxelMass);
+	body.Friction = rb.Friction;
+	body.Restitution = rb.Restitution;
+	body.SleepTime = rb.SleepTime;
+	body.UpdateInertia();
+
+	info.Offset = glm::inverse(body.Rotation) * (W->Transform->GetWorldPosition(info.Entity) - body.Position);
+	info.Awake = true;
+	_AwakeBodies.push_back(index);
+}
+
+void PhysicsSystem::CollideBody(int32 index, std::vector<int32>& candidates, std::vector<Contact>& contacts) {
+	const BodyInfo& info = _BodyInfos[index];
+	const ProxyData& data = _ProxyData[info.Proxy];
+	QueryFilter filter(info.CollisionMask);
 
-	glm::vec3 stepSign = glm::sign(localDir);
-	glm::vec3 tDelta = glm::vec3(1.0f,1.0f,1.0f) / (localDir*stepSign);
-	glm::ivec3 currentVoxel = glm::ivec3(glm::floor(localPos));
-	glm::vec3 nextVoxelBounds = glm::vec3(currentVoxel) + (stepSign*0.5f+0.5f);
-	glm::vec3 tMax = (nextVoxelBounds - localPos) / localDir;
+	candidates.clear();
+	_Tree.Query(AABB::FromOBB(glm::inverse(data.Box.InvMatrix), data.Box.Size).Expand(0.1f), [&](int32 proxy) {
+		if (proxy != info.Proxy && filter.Accepts(_ProxyData[proxy].Layers)) {
+			candidates.push_back(proxy);
+		}
+		return true;
+	});
 
-	int i = 0;
-	do {
-		glm::vec3 select = glm::step(tMax, glm::vec3(tMax.z, tMax.x, tMax.y)) * glm::step(tMax, glm::vec3(tMax.y, tMax.z, tMax.x));
-		currentVoxel += select * stepSign;
+	for (int32 proxy : candidates) {
+		const ProxyData& other = _ProxyData[proxy];
 
-		if (glm::clamp(currentVoxel, glm::ivec3(0, 0, 0), glm::ivec3(obbSize)-1) != currentVoxel) {
-			return false;
+		if (other.Body >= 0) {
+			//Both have to collide with each other, and pairs woken in the same pass are collided once by the lower index
+			//the bodies of earlier passes collided this one while it was sleeping
+			const BodyInfo& otherInfo = _BodyInfos[other.Body];
+			if (!QueryFilter(otherInfo.CollisionMask).Accepts(data.Layers))continue;
+			if (otherInfo.Awake && (otherInfo.Pass < info.Pass || (otherInfo.Pass == info.Pass && other.Body < index)))continue;
 		}
 
-		uint8 voxel = *obbVox->PixelAt(currentVoxel.x, currentVoxel.y, currentVoxel.z);
+		//The voxels attached to the body move with it
+		if (other.Owner == info.Entity)continue;
 
+		int32 count = CollideVoxels(data.Box, data.Vox->GetOccupancy(), other.Box, other.Vox->GetOccupancy(), MaxContactsPerPair, contacts);
+		for (size_t i = contacts.size() - count; i < contacts.size(); i++) {
+			contacts[i].A = index;
+			contacts[i].B = other.Body;
+		}
+	}
+}
 
-		if (voxel != 0) {
-			t = glm::dot(tMax, select)*0.1f;
-			return true;
+int32 PhysicsSystem::FindIsland(int32 body) {
+	while (_Islands[body] != body) {
+		_Islands[body] = _Islands[_Islands[body]];
+		body = _Islands[body];
+	}
+	return body;
+}
+
+void PhysicsSystem::CollideBodies(float dt) {
+	//Small counts are not worth the Jobs overhead
+	uint32 groups = _AwakeBodies.size() < 16 ? 1 : Jobs::GetThreadCount();
+	_Candidates.resize(glm::max<size_t>(_Candidates.size(), groups));
+	_GroupContacts.resize(groups);
+	for (std::vector<Contact>& contacts : _GroupContacts) {
+		contacts.clear();
+	}
+
+	std::vector<size_t> contactStart(_GroupContacts.size());
+	size_t first = 0;
+	for (int32 pass = 0; first < _AwakeBodies.size(); pass++) {
+		size_t last = _AwakeBodies.size();
+		for (size_t i = first; i < last; i++) {
+			IntegrateVelocity(_Bodies[_AwakeBodies[i]], Gravity, dt);
+		}
+		for (size_t group = 0; group < _GroupContacts.size(); group++) {
+			contactStart[group] = _GroupContacts[group].size();
+		}
+
+		if (groups == 1 || last - first < 16) {
+			for (size_t i = first; i < last; i++) {
+				CollideBody(_AwakeBodies[i], _Candidates[0], _GroupContacts[0]);
+			}
 		}
 		else {
-			tMax += tDelta * select;
+			Jobs::Context ctx;
+			Jobs::ParallelFor(static_cast<uint32>(last - first), [&](int index, int group) {
+				CollideBody(_AwakeBodies[first + index], _Candidates[group], _GroupContacts[group]);
+			}, ctx);
+			Jobs::Complete(ctx);
 		}
 
-	} while (i++ < 256);
+		//The sleeping bodies touched wake up, InitBody adds them to _AwakeBodies for the next pass
+		for (size_t group = 0; group < _GroupContacts.size(); group++) {
+			for (size_t i = contactStart[group]; i < _GroupContacts[group].size(); i++) {
+				int32 b = _GroupContacts[group][i].B;
+				if (b < 0 || _BodyInfos[b].Awake)continue;
 
-	return false;
+				InitBody(b);
+				_Bodies[b].SleepTime = 0.0f;
+				_BodyInfos[b].Pass = pass + 1;
+			}
+		}
+		first = last;
+	}
+}
+
+void PhysicsSystem::UpdateIslands() {
+	//Union-find over the contacts, the bodies touching are solved together
+	_Islands.resize(_Bodies.size());
+	for (int32 i = 0; i < _Islands.size(); i++) {
+		_Islands[i] = i;
+	}
+
+	for (const std::vector<Contact>& contacts : _GroupContacts) {
+		for (const Contact& c : contacts) {
+			if (c.B < 0)continue;
+
+			int32 a = FindIsland(c.A);
+			int32 b = FindIsland(c.B);
+			if (a != b) {
+				_Islands[a] = b;
+			}
+		}
+	}
+
+	//Number the islands in their roots, then store the island of every awake body
+	_BodyIsland.assign(_Bodies.size(), -1);
+	int32 islandCount = 0;
+	for (int32 i : _AwakeBodies) {
+		int32 root = FindIsland(i);
+		if (_BodyIsland[root] < 0) {
+			_BodyIsland[root] = islandCount++;
+		}
+	}
+	for (int32 i : _AwakeBodies) {
+		_BodyIsland[i] = _BodyIsland[FindIsland(i)];
+	}
+
+	//Counting sort of the bodies and contacts by island
+	_IslandBodyStart.assign(islandCount + 1, 0);
+	_IslandContactStart.assign(islandCount + 1, 0);
+	size_t contactCount = 0;
+	for (int32 i : _AwakeBodies) {
+		_IslandBodyStart[_BodyIsland[i] + 1]++;
+	}
+	for (const std::vector<Contact>& contacts : _GroupContacts) {
+		for (const Contact& c : contacts) {
+			_IslandContactStart[_BodyIsland[c.A] + 1]++;
+		}
+		contactCount += contacts.size();
+	}
+	for (int32 i = 1; i <= islandCount; i++) {
+		_IslandBodyStart[i] += _IslandBodyStart[i - 1];
+		_IslandContactStart[i] += _IslandContactStart[i - 1];
+	}
+
+	//Scattering moves every start to the next one, shift them back after
+	_IslandBodies.resize(_AwakeBodies.size());
+	_Contacts.resize(contactCount);
+	for (int32 i : _AwakeBodies) {
+		_IslandBodies[_IslandBodyStart[_BodyIsland[i]]++] = i;
+	}
+	for (const std::vector<Contact>& contacts : _GroupContacts) {
+		for (const Contact& c : contacts) {
+			_Contacts[_IslandContactStart[_BodyIsland[c.A]]++] = c;
+		}
+	}
+	for (int32 i = islandCount; i > 0; i--) {
+		_IslandBodyStart[i] = _IslandBodyStart[i - 1];
+		_IslandContactStart[i] = _IslandContactStart[i - 1];
+	}
+	_IslandBodyStart[0] = 0;
+	_IslandContactStart[0] = 0;
+}
+
+void PhysicsSystem::SolveIsland(int32 island, float dt) {
+	int32 contactStart = _IslandContactStart[island];
+	SolveContacts(_Bodies.data(), _Contacts.data() + contactStart, _IslandContactStart[island + 1] - contactStart, dt, SolverIterations);
+
+	//The island sleeps when all its bodies have been resting for a while
+	bool resting = true;
+	for (int32 i = _IslandBodyStart[island]; i < _IslandBodyStart[island + 1]; i++) {
+		BodyState& body = _Bodies[_IslandBodies[i]];
+		IntegratePosition(body, dt);
+
+		bool slow = glm::length2(body.LinearVelocity) < SleepVelocity * SleepVelocity && glm::length2(body.AngularVelocity) < SleepVelocity * SleepVelocity;
+		body.SleepTime = slow ? body.SleepTime + dt : 0.0f;
+		resting &= body.SleepTime >= TimeToSleep;
+	}
+
+	if (resting) {
+		for (int32 i = _IslandBodyStart[island]; i < _IslandBodyStart[island + 1]; i++) {
+			BodyState& body = _Bodies[_IslandBodies[i]];
+			body.LinearVelocity = glm::vec3(0.0f);
+			body.AngularVelocity = glm::vec3(0.0f);
+			_BodyInfos[_IslandBodies[i]].FellAsleep = true;
+		}
+	}
 }
 
-bool PhysicsSystem::RayCast(glm::vec3 start, glm::vec3 dir, float& hitt, entt::entity& hitEntity) {
-	float bestt = 999999.0f;
-	bool hit = false;
-	
-	R->view<Transform, VoxRenderer>().each([&](const entt::entity e, Transform& tr, VoxRenderer& v) {
-		if (!v.Vox.IsValid())return;
+void PhysicsSystem::UpdateBodies(float dt) {
+	PROFILE_FUNC();
+
+	dt = glm::min(dt, MaxBodyStep);
+	if (dt <= 0.0f)return;
+
+	_BodyInfos.clear();
+	_Bodies.clear();
+	_AwakeBodies.clear();
+	R->view<Transform, VoxRenderer, RigidBody>().each([&](const entt::entity e, Transform& t, VoxRenderer& v, RigidBody& rb) {
+		//Empty shapes and massless bodies stay static, InitBody divides by the mass
+		auto it = _Proxies.find(e);
+		if (it == _Proxies.end() || !(_ProxyData[it->second].Vox->GetMassProperties().Mass * rb.VoxelMass > 0.0f))return;
+
+		int32 index = static_cast<int32>(_Bodies.size());
+		_ProxyData[it->second].Body = index;
+		_BodyInfos.push_back({ e, it->second, glm::vec3(0.0f), rb.CollisionMask, false, false, 0 });
+		_Bodies.emplace_back();
 
-		//TODO: Remove this
-		// This disables the Character collision raycast test but it's slow
-		entt::entity te = e;
-		do {
-			if (R->has<Character>(te)) {
-				return;
+		//Sleeping bodies cost nothing unless an awake body touches them
+		if (!rb.IsSleeping) {
+			InitBody(index);
+		}
+	});
+
+	if (!_AwakeBodies.empty()) {
+		CollideBodies(dt);
+		UpdateIslands();
+
+		//Islands don't share bodies so they are solved in parallel
+		int32 islandCount = static_cast<int32>(_IslandBodyStart.size()) - 1;
+		if (islandCount < 4) {
+			for (int32 island = 0; island < islandCount; island++) {
+				SolveIsland(island, dt);
 			}
-			else {
-				te = W->GetParent(te);
+		}
+		else {
+			Jobs::Context ctx;
+			Jobs::ParallelFor(static_cast<uint32>(islandCount), [&](int island, int group) {
+				SolveIsland(island, dt);
+			}, ctx);
+			Jobs::Complete(ctx);
+		}
+
+		//Only the awake bodies touch their Transform, so sleeping ones are never Changed
+		for (int32 i : _AwakeBodies) {
+			const BodyInfo& info = _BodyInfos[i];
+			const BodyState& body = _Bodies[i];
+
+			RigidBody& rb = R->get<RigidBody>(info.Entity);
+			rb.LinearVelocity = body.LinearVelocity;
+			rb.AngularVelocity = body.AngularVelocity;
+			rb.SleepTime = body.SleepTime;
+			rb.IsSleeping = info.FellAsleep;
+
+			W->Transform->SetWorldPosition(info.Entity, body.Position + body.Rotation * info.Offset);
+			W->Transform->SetWorldRotation(info.Entity, body.Rotation);
+		}
+	}
+
+	for (const BodyInfo& info : _BodyInfos) {
+		_ProxyData[info.Proxy].Body = -1;
+	}
+}
+
+// Shapes of the overlap queries
+// Classify tells if a sphere bounding a brick is outside (-1), inside (1) or partially inside (0)
+struct SphereShape {
+	Sphere S;
+
+	SphereShape(const Sphere& s) : S(s) {}
+
+	AABB GetBounds() const { return AABB(S.Center - S.Radius, S.Center + S.Radius); }
+
+	bool Contains(const glm::vec3& p) const {
+		glm::vec3 d = p - S.Center;
+		return glm::dot(d, d) <= S.Radius * S.Radius;
+	}
+
+	int Classify(const glm::vec3& center, float radius) const {
+		float distance = glm::length(center - S.Center);
+		if (distance > S.Radius + radius)return -1;
+		if (distance + radius <= S.Radius)return 1;
+		return 0;
+	}
+};
+
+struct BoxShape {
+	AABB B;
+
+	BoxShape(const AABB& b) : B(b) {}
+
+	AABB GetBounds() const { return B; }
+
+	bool Contains(const glm::vec3& p) const {
+		return glm::all(glm::greaterThanEqual(p, B.Min)) && glm::all(glm::lessThanEqual(p, B.Max));
+	}
+
+	int Classify(const glm::vec3& center, float radius) const {
+		AABB bounds(center - radius, center + radius);
+		if (!B.Overlaps(bounds))return -1;
+		if (B.Contains(bounds))return 1;
+		return 0;
+	}
+};
+
+template<typename TShape>
+uint32 PhysicsSystem::Overlap(const TShape& shape, OverlapHit* hits, uint32 maxHits, const QueryFilter& filter) {
+	if (maxHits == 0)return 0;
+
+	uint32 count = 0;
+	AABB bounds = shape.GetBounds();
+	glm::vec3 center = bounds.GetCenter();
+	glm::vec3 extent = bounds.GetExtent();
+
+	_Tree.Query(bounds, [&](int32 proxy) {
+		ProxyData& data = _ProxyData[proxy];
+		if (!filter.Accepts(data.Layers))return true;
+
+		//The bounds in the voxel space of the candidate
+		const glm::mat4& m = data.Box.InvMatrix;
+		glm::vec3 localCenter = glm::vec3(m * glm::vec4(center, 1.0f)) * 10.0f;
+		glm::vec3 localExtent = (glm::abs(glm::vec3(m[0])) * extent.x + glm::abs(glm::vec3(m[1])) * extent.y + glm::abs(glm::vec3(m[2])) * extent.z) * 10.0f;
+		glm::ivec3 lo = glm::ivec3(glm::floor(localCenter - localExtent));
+		glm::ivec3 hi = glm::ivec3(glm::floor(localCenter + localExtent));
+
+		glm::mat4 voxelToWorld = glm::scale(glm::inverse(m), glm::vec3(0.1f));
+		glm::vec3 c0 = voxelToWorld[0], c1 = voxelToWorld[1], c2 = voxelToWorld[2];
+		float brickRadius = 2.0f * glm::sqrt(glm::max(
+			glm::max(glm::length2(c0 + c1 + c2), glm::length2(c0 + c1 - c2)),
+			glm::max(glm::length2(c0 - c1 + c2), glm::length2(c0 - c1 - c2))
+		));
+
+		//Whole bricks are counted at once when they are inside the shape
+		uint32 voxels = 0;
+		data.Vox->GetOccupancy().ForEachBrick(lo, hi, [&](const glm::ivec3& origin, uint64 bits) {
+			glm::vec3 brickCenter = voxelToWorld * glm::vec4(glm::vec3(origin) + 2.0f, 1.0f);
+			int side = shape.Classify(brickCenter, brickRadius);
+
+			if (side > 0) {
+				voxels += VoxOccupancy::CountBits(bits);
 			}
-		}while(te != entt::null);
-
-		auto s = v.Vox->GetImage().getExtent();
-
-		glm::mat4 worldMatrix = tr.WorldMatrix;
-		worldMatrix = glm::translate(worldMatrix, -v.Pivot);
-
-		glm::vec3 size = glm::ivec3(s.width, s.height, s.depth);
-		float t = 0.0f;
-		if (RayOBBCast(worldMatrix, size*0.1f, start, dir, t)) {
-			t = glm::max(t, 0.0f);// Prevent from casting from the start of the obb, which can be behind the camera
-			float t2 = 0.0f;
-			if (RayVoxCast(worldMatrix, size, v.Vox, start+dir*(t-0.001f), dir, t2)) {
-				if (t+t2 < bestt) {
-					bestt = t + t2;
-					hitEntity = e;
+			else if (side == 0) {
+				while (bits != 0) {
+					uint32 bit = VoxOccupancy::FirstBit(bits);
+					bits &= bits - 1;
+
+					glm::vec3 p = voxelToWorld * glm::vec4(glm::vec3(origin + VoxOccupancy::BitPosition(bit)) + 0.5f, 1.0f);
+					if (shape.Contains(p)) {
+						voxels++;
+					}
 				}
-				hit = true;
 			}
+			return true;
+		});
+
+		if (voxels > 0) {
+			hits[count].Entity = static_cast<entt::entity>(_Tree.GetUserData(proxy));
+			hits[count].VoxelCount = voxels;
+			count++;
 		}
+
+		return count < maxHits;
 	});
-	
-	hitt = bestt;
-	return hit;
+
+	return count;
+}
+
+template<typename TShape, typename T>
+void PhysicsSystem::OverlapBatch(const std::vector<T>& shapes, OverlapHit* hits, uint32 maxHits, uint32* counts, const QueryFilter& filter) {
+	PROFILE_FUNC();
+
+	//Small batches are not worth the Jobs overhead
+	if (shapes.size() < 16) {
+		for (int i = 0; i < shapes.size(); i++) {
+			counts[i] = Overlap(TShape(shapes[i]), hits + (size_t)i * maxHits, maxHits, filter);
+		}
+		return;
+	}
+
+	Jobs::Context ctx;
+	Jobs::ParallelFor(static_cast<uint32>(shapes.size()), [&](int i, int group) {
+		counts[i] = Overlap(TShape(shapes[i]), hits + (size_t)i * maxHits, maxHits, filter);
+	}, ctx);
+	Jobs::Complete(ctx);
+}
+
+uint32 PhysicsSystem::OverlapSphere(const Sphere& sphere, OverlapHit* hits, uint32 maxHits, const QueryFilter& filter) {
+	return Overlap(SphereShape(sphere), hits, maxHits, filter);
+}
+
+uint32 PhysicsSystem::OverlapBox(const AABB& box, OverlapHit* hits, uint32 maxHits, const QueryFilter& filter) {
+	return Overlap(BoxShape(box), hits, maxHits, filter);
+}
+
+void PhysicsSystem::OverlapSphereBatch(const std::vector<Sphere>& spheres, OverlapHit* hits, uint32 maxHits, uint32* counts, const QueryFilter& filter) {
+	OverlapBatch<SphereShape>(spheres, hits, maxHits, counts, filter);
+}
+
+void PhysicsSystem::OverlapBoxBatch(const std::vector<AABB>& boxes, OverlapHit* hits, uint32 maxHits, uint32* counts, const QueryFilter& filter) {
+	OverlapBatch<BoxShape>(boxes, hits, maxHits, counts, filter);
 }
@@ -1,17 +1,195 @@
 #pragma once
 
 #include "System.h"
+#include "Physics/AABBTree.h"
+#include "Physics/RigidBody.h"
+#include "World/Components.h"
 
 #include <glm/vec3.hpp>
+#include <unordered_map>
+#include <vector>
+
+struct RayHit {
+	float T{ 999999.0f }; // Ray MaxT if didn't hit
+	entt::entity Entity{ entt::null };
+	bool Hit{ false };
+};
+
+struct OverlapHit {
+	entt::entity Entity{ entt::null };
+	uint32 VoxelCount{ 0 }; // Solid voxels with the center inside the query shape
+};
+
+// Selects the entities tested by a query using their Collider layers
+struct QueryFilter {
+	uint32 Mask{ Collider::All };
+
+	QueryFilter() {}
+	QueryFilter(uint32 mask) : Mask(mask) {}
+
+	static QueryFilter Exclude(uint32 layers) { return QueryFilter(~layers); }
+
+	bool Accepts(uint32 layers) const { return (layers & Mask) != 0; }
+};
 
 class PhysicsSystem : public System {
+	// Broadphase with the world bounds of every Transform + VoxRenderer entity
+	AABBTree _Tree;
+	std::unordered_map<entt::entity, int32> _Proxies;
+
+	// Everything the queries need from an entity, so they don't touch the registry
+	struct ProxyData {
+		OBB Box;
+		AssetRefT<VoxAsset> Vox;
+		uint32 Layers{ Collider::Default };
+		int32 Body{ -1 }; // Index in _Bodies while the bodies are simulated
+		entt::entity Owner{ entt::null }; // The voxels move with it, see ResolveOwner
+	};
+	// Indexed by the proxy id
+	std::vector<ProxyData> _ProxyData;
+	// Entities that had the VoxRenderer created or replaced since the last UpdateBroadphase
+	std::vector<entt::entity> _PendingProxies;
+	// Entities that had a Collider, Character, body or parent changed, their children layers and owners have to be resolved again
+	std::vector<entt::entity> _PendingHierarchy;
+
+	void OnVoxRendererChanged(entt::registry& r, entt::entity e);
+	void OnProxyDestroyed(entt::registry& r, entt::entity e);
+	void OnHierarchyChanged(entt::registry& r, entt::entity e);
+
+	void UpdateProxy(entt::entity e);
+	void RemoveProxy(entt::entity e);
+
+	// Finds the Collider layers of the entity walking up the hierarchy
+	uint32 ResolveLayers(entt::entity e);
+	// Finds the RigidBody or CharacterController the entity is under, or the entity itself
+	entt::entity ResolveOwner(entt::entity e);
+	void UpdateHierarchyRecursive(entt::entity e);
+
+	// Only reads from the registry so it can be called from the Jobs threads
+	void RayCast(const Ray& ray, RayHit& hit, const QueryFilter& filter);
+
+	// A CharacterController being moved by the Jobs threads
+	struct ControllerMove {
+		entt::entity Entity;
+		glm::vec3 Position; // World position
+		glm::vec3 Delta;    // World movement after the collisions
+		CharacterController Controller;
+	};
+	std::vector<ControllerMove> _ControllerMoves;
+	// Broadphase candidates of every Jobs group, used by the controllers and the bodies
+	std::vector<std::vector<int32>> _Candidates;
+
+	// Tells if the box overlaps any solid voxel of the candidates
+	bool OverlapsVoxels(const AABB& box, const std::vector<int32>& candidates);
+	// Moves the box along the axis until it touches a voxel, returns the distance moved
+	float SweepAxis(AABB& box, int axis, float distance, const std::vector<int32>& candidates);
+	void MoveController(ControllerMove& move, std::vector<int32>& candidates, float dt);
+
+	// A RigidBody being simulated this frame, same index as in _Bodies
+	struct BodyInfo {
+		entt::entity Entity;
+		int32 Proxy;
+		glm::vec3 Offset;  // Entity position from the center of mass, in the body axes
+		uint32 CollisionMask;
+		bool Awake;        // Simulated this frame
+		bool FellAsleep;   // Went to sleep at the end of this frame
+		int32 Pass;        // Collision pass it woke in, 0 when awake at the start of the frame
+	};
+	std::vector<BodyInfo> _BodyInfos;
+	std::vector<BodyState> _Bodies;
+	std::vector<int32> _AwakeBodies;
+	// Contacts of every Jobs group, merged and sorted by island in _Contacts
+	std::vector<std::vector<Contact>> _GroupContacts;
+	std::vector<Contact> _Contacts;
+	// Union-find parents and the island of every awake body
+	std::vector<int32> _Islands;
+	std::vector<int32> _BodyIsland;
+	// Awake bodies and contacts sorted by island, with the start of every island
+	std::vector<int32> _IslandBodies;
+	std::vector<int32> _IslandBodyStart;
+	std::vector<int32> _IslandContactStart;
+
+	void OnRigidBodyUpdated(entt::registry& r, entt::entity e);
+	// Wakes the sleeping bodies touching the bounds that collide with the layers
+	// used when the static world around them changes
+	void WakeBodies(const AABB& bounds, uint32 layers);
+
+	void InitBody(int32 index);
+	int32 FindIsland(int32 body);
+	void CollideBody(int32 index, std::vector<int32>& candidates, std::vector<Contact>& contacts);
+	// Collides the awake bodies, the sleeping ones they touch wake up and are collided in the next pass
+	// so they have their own contacts (with the ground too) before the islands are solved
+	void CollideBodies(float dt);
+	void UpdateIslands();
+	void SolveIsland(int32 island, float dt);
+	void UpdateBodies(float dt);
+
+	// Used by the overlap queries, TShape tells which voxels are inside
+	template<typename TShape>
+	uint32 Overlap(const TShape& shape, OverlapHit* hits, uint32 maxHits, const QueryFilter& filter);
+	template<typename TShape, typename T>
+	void OverlapBatch(const std::vector<T>& shapes, OverlapHit* hits, uint32 maxHits, uint32* counts, const QueryFilter& filter);
+
+	template<typename T>
+	auto FilterProxies(const QueryFilter& filter, T& callback) {
+		return [&](int32 proxy) {
+			if (!filter.Accepts(_ProxyData[proxy].Layers))return true;
+			return callback(static_cast<entt::entity>(_Tree.GetUserData(proxy)));
+		};
+	}
+
 public:
 
-	bool RayCast(glm::vec3 start, glm::vec3 dir, float& t, entt::entity& hitEntity);
+	// Moves the CharacterControllers with their Velocity, called by the World after the CharacterSystem set it
+	void UpdateControllers(float dt);
+
+	inline static const glm::vec3 Gravity{ 0.0f, -9.81f, 0.0f };
+
+	// By default rays don't hit Characters
+	inline static const QueryFilter DefaultRayFilter = QueryFilter::Exclude(Collider::Character);
+
+	// A ray starting inside the voxels of an entity hits it at t = 0
+	bool RayCast(glm::vec3 start, glm::vec3 dir, float& t, entt::entity& hitEntity, const QueryFilter& filter = DefaultRayFilter);
+
+	// Casts many rays at once using the Jobs threads
+	// rays are sorted by direction and origin so nearby rays are traced by the same thread
+	// hits are resized to the rays count and keep the same order as the rays
+	void RayCastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits, const QueryFilter& filter = DefaultRayFilter);
+
+	// Finds the entities with solid voxels inside the shape, a voxel is inside when its center is
+	// writes up to maxHits results in hits without allocating and returns how many were written
+	uint32 OverlapSphere(const Sphere& sphere, OverlapHit* hits, uint32 maxHits, const QueryFilter& filter = QueryFilter());
+	uint32 OverlapBox(const AABB& box, OverlapHit* hits, uint32 maxHits, const QueryFilter& filter = QueryFilter());
+
+	// Runs many overlap queries at once using the Jobs threads
+	// hits has maxHits slots per query, the query i writes from hits[i * maxHits] and its count in counts[i]
+	void OverlapSphereBatch(const std::vector<Sphere>& spheres, OverlapHit* hits, uint32 maxHits, uint32* counts, const QueryFilter& filter = QueryFilter());
+	void OverlapBoxBatch(const std::vector<AABB>& boxes, OverlapHit* hits, uint32 maxHits, uint32* counts, const QueryFilter& filter = QueryFilter());
+
+	// Calls callback(entt::entity) for every entity with bounds overlapping the query
+	// return false in the callback to stop the query
+	template<typename T>
+	void QueryBox(const AABB& box, T callback, const QueryFilter& filter = QueryFilter()) {
+		_Tree.Query(box, FilterProxies(filter, callback));
+	}
+	template<typename T>
+	void QuerySphere(const glm::vec3& center, float radius, T callback, const QueryFilter& filter = QueryFilter()) {
+		_Tree.QuerySphere(center, radius, FilterProxies(filter, callback));
+	}
+	template<typename T>
+	void QueryFrustum(const Frustum& frustum, T callback, const QueryFilter& filter = QueryFilter()) {
+		_Tree.QueryFrustum(frustum, FilterProxies(filter, callback));
+	}
+
+	// Refits the broadphase with the Changed entities
+	// Should be called after the TransformSystem has updated the matrices
+	void UpdateBroadphase();
+
+	const AABBTree& GetBroadphase() { return _Tree; }
 
-	virtual void OnCreate() {}
-	virtual void OnUpdate(float dt) {}
+	virtual void OnCreate();
+	virtual void OnUpdate(float dt);
 	virtual void OnEvent(Event& e) {}
 	virtual void OnDestroy() {}
 
-};
\ No newline at end of file
+};
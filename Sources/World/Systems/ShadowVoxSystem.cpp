@@ -1,114 +1,315 @@
 #include "ShadowVoxSystem.h"
 
+#include "Core/Engine.h"
+#include "World/World.h"
 #include "World/Components.h"
 #include "World/Systems/TransformSystem.h"
+#include "World/Systems/PhysicsSystem.h"
 #include "Profiler/Profiler.h"
+#include "Job/Jobs.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Bricks per row and per column of an atlas slice
+static constexpr int32 AtlasBricks = 16;
+static constexpr uint32 BrickTexels = ShadowVolume::BrickSize / 2;
+
+void ShadowVoxSystem::OnVoxChanged(entt::registry& r, entt::entity e) {
+	_Pending.push_back(e);
+}
 
 void ShadowVoxSystem::OnVoxDestroyed(entt::registry& r, entt::entity e) {
-	AssetRefT<VoxAsset>& v = r.get<VoxRenderer>(e).Vox;
-	if (!v.IsValid())return;
-	Transform& t = r.get<Transform>(e);
-
-	int sx = v->GetImage().getExtent().width;
-	int sy = v->GetImage().getExtent().height;
-	int sz = v->GetImage().getExtent().depth;
-
-	glm::ivec3 startmin = glm::vec3(_Volume.getExtent().width - 1, _Volume.getExtent().height - 1, _Volume.getExtent().depth - 1);
-	glm::ivec3 startmax = glm::vec3(0, 0, 0);
-
-	glm::ivec3 aabbmin = startmin;
-	glm::ivec3 aabbmax = startmax;
-
-	glm::vec3 o = t.WorldMatrix[3];
-	glm::vec3 dx = t.WorldMatrix[0] * 0.1f;
-	glm::vec3 dy = t.WorldMatrix[1] * 0.1f;
-	glm::vec3 dz = t.WorldMatrix[2] * 0.1f;
-
-
-	for (int z = 0; z < sz; z++) {
-		for (int y = 0; y < sy; y++) {
-			for (int x = 0; x < sx; x++) {
-				if (*v->PixelAt(x, y, z) >= 16) {
-					glm::vec3 wp = o + (float)(x)*dx + (float)(y)*dy + (float)(z)*dz;
-					glm::ivec3 fwp = glm::ivec3(wp * 10.0f);
-					aabbmin = glm::min(aabbmin, fwp);
-					aabbmax = glm::max(aabbmax, fwp);
-					SetVolumeAt(fwp.x, fwp.y, fwp.z, 0);
-				}
+	auto it = _Written.find(e);
+	if (it == _Written.end())return;
+
+	//The pages are flushed in the next update
+	_GroupCells.resize(glm::max<size_t>(_GroupCells.size(), 1));
+	_GroupDirty.resize(glm::max<size_t>(_GroupDirty.size(), 1));
+	WriteSurface(*it->second.Surface, it->second.GridToWorld, 0, _Volume.GetWindowBounds(), _GroupCells[0], _GroupDirty[0]);
+	_Written.erase(it);
+}
+
+void ShadowVoxSystem::RewriteEntity(entt::entity e) {
+	SurfaceUpdate update;
+	update.Region = -1;
+
+	auto it = _Written.find(e);
+	if (it != _Written.end()) {
+		update.PreviousSurface = it->second.Surface;
+		update.Previous = it->second.GridToWorld;
+	}
+
+	VoxRenderer* vr = R->try_get<VoxRenderer>(e);
+	Transform* t = R->try_get<Transform>(e);
+	if (vr != nullptr && t != nullptr && vr->Vox.IsValid()) {
+		update.Surface = vr->Vox->GetShadowSurface();
+		update.Current = glm::translate(t->WorldMatrix, -vr->Pivot);
+		_Written[e] = WrittenSurface{ vr->Vox, update.Surface, update.Current, vr->Vox->GetRevision() };
+	}
+	else if (it != _Written.end()) {
+		_Written.erase(it);
+	}
+
+	if (update.PreviousSurface != nullptr || update.Surface != nullptr) {
+		_Updates.push_back(update);
+	}
+}
+
+void ShadowVoxSystem::RewriteEdited() {
+	_EditedParts.clear();
+	bool added = false;
+
+	for (auto& [e, written] : _Written) {
+		uint32 revision = written.Vox->GetRevision();
+		if (revision == written.Revision)continue;
+
+		const std::shared_ptr<const VoxSurface>& surface = written.Vox->GetShadowSurface();
+		SurfaceUpdate update;
+		update.Previous = written.GridToWorld;
+		update.Current = written.GridToWorld;
+		update.Region = -1;
+
+		//The entered bricks are written with the whole surface, so the edited part can't be written apart
+		glm::ivec3 min, max;
+		if (_Exposed.empty() && written.Vox->GetEditedBounds(written.Revision, min, max)) {
+			auto part = _EditedParts.find(written.Surface.get());
+			if (part == _EditedParts.end()) {
+				//The voxels around the edit may have become (or stopped being) surface
+				std::shared_ptr<VoxSurface> previous = std::make_shared<VoxSurface>();
+				std::shared_ptr<VoxSurface> current = std::make_shared<VoxSurface>();
+				written.Surface->Extract(min - 1, max + 1, *previous);
+				surface->Extract(min - 1, max + 1, *current);
+				part = _EditedParts.emplace(written.Surface.get(), std::make_pair(previous, current)).first;
 			}
+			update.PreviousSurface = part->second.first;
+			update.Surface = part->second.second;
+		}
+		else {
+			update.PreviousSurface = written.Surface;
+			update.Surface = surface;
+			_Rewritten.push_back(e);
+			added = true;
+		}
+
+		written.Surface = surface;
+		written.Revision = revision;
+		_Updates.push_back(update);
+	}
+
+	if (added) {
+		std::sort(_Rewritten.begin(), _Rewritten.end());
+	}
+	_EditedParts.clear();
+}
+
+void ShadowVoxSystem::WriteSurface(const VoxSurface& surface, const glm::mat4& gridToWorld, int value, const ShadowVolume::Bounds& bounds, std::vector<glm::ivec3>& cells, std::vector<int32>& dirty) {
+	surface.Transform(gridToWorld, cells);
+	_Volume.WriteCells(cells, value, bounds, dirty);
+}
+
+void ShadowVoxSystem::WriteSurfaces(int value) {
+	//Small counts are not worth the Jobs overhead
+	uint32 groups = _Updates.size() < 4 ? 1 : Jobs::GetThreadCount();
+	_GroupCells.resize(glm::max<size_t>(_GroupCells.size(), groups));
+	_GroupDirty.resize(glm::max<size_t>(_GroupDirty.size(), groups));
+
+	const ShadowVolume::Bounds window = _Volume.GetWindowBounds();
+	auto write = [&](int index, int group) {
+		SurfaceUpdate& u = _Updates[index];
+		if (u.Region < 0) {
+			const VoxSurface* surface = value ? u.Surface.get() : u.PreviousSurface.get();
+			if (surface == nullptr)return;
+			WriteSurface(*surface, value ? u.Current : u.Previous, value, window, _GroupCells[group], _GroupDirty[group]);
+		}
+		else if (value) {
+			WriteSurface(*u.Surface, u.Current, value, _Volume.GetRegionBounds(_Exposed[u.Region]), _GroupCells[group], _GroupDirty[group]);
+		}
+	};
+
+	if (groups == 1) {
+		for (int i = 0; i < _Updates.size(); i++) {
+			write(i, 0);
 		}
 	}
+	else {
+		Jobs::Context ctx;
+		Jobs::ParallelFor(static_cast<uint32>(_Updates.size()), write, ctx);
+		Jobs::Complete(ctx);
+	}
+}
 
-	//If isn't inside the ShadowVolume AABB
-	if (aabbmax != startmax) {
-		aabbmin /= 2;
-		aabbmax /= 2;
+void ShadowVoxSystem::ResizeAtlas() {
+	_AtlasChunks = glm::max(_Volume.GetChunkCount(), 1);
+	uint32 size = (uint32)(AtlasBricks * BrickTexels);
+	_Atlas = Image::Create(Image::Info(Format::R8Uint, { size, size, (uint32)_AtlasChunks * BrickTexels }));
+	_BrickMasks = Buffer::Create(sizeof(uint64) * ShadowVolume::ChunkBricks * _AtlasChunks, BufferUsage::Storage, MemoryType::CPU_TO_GPU);
 
-		aabbmin = glm::max(aabbmin, glm::ivec3(0, 0, 0));
-		aabbmax = glm::min(aabbmax, startmin);
+	std::vector<int32> bricks;
+	_Volume.GetBricks(bricks);
+	UploadMasks(bricks);
+	UploadBricks(bricks, true);
+}
 
-		glm::ivec3 size = aabbmax - aabbmin + glm::ivec3(1, 1, 1);
-		_UpdateRegions.push_back(ImageRegion{ aabbmin.x, aabbmin.y, aabbmin.z, (uint32)size.x, (uint32)size.y, (uint32)size.z, 0 });
+void ShadowVoxSystem::UploadMasks(const std::vector<int32>& bricks) {
+	//Written in place, the frame that reads them also gets the queued bricks
+	uint64* masks = (uint64*)_BrickMasks.getData();
+	for (int32 b : bricks) {
+		masks[b] = _Volume.GetBrickMask(b);
 	}
 }
 
-ShadowVoxSystem::ShadowVoxSystem() {
-	_SizeX = 524;
-	_SizeY = 188;
-	_SizeZ = 524;
-	_SizeXtimes_SizeY = _SizeX * _SizeY;
-
-	_Volume = Image::Create(Image::Info(Format::R8Uint, { _SizeX, _SizeY, _SizeZ }));
-	uint64_t size = _Volume.getExtent().width * _Volume.getExtent().height * _Volume.getExtent().depth;
-	_Buffer = Buffer::Create(size);
-	_Data.resize(size);
-
-	//Clear Volume
-	for (int i = 0; i < _SizeX*_SizeY*_SizeZ; i++) {
-		uint8* data = (uint8*)_Buffer.getData() + i;
-		*data = 0;
-	} 
-
-	Graphics::Transfer([&](CmdBuffer& cmd) {
-		cmd.barrier(_Volume, ImageLayout::Undefined, ImageLayout::TransferDst);
-		cmd.copy(_Buffer, _Volume, _UpdateRegions);
-		cmd.barrier(_Volume, ImageLayout::TransferDst, ImageLayout::ShaderReadOptimal);
-	});
+static inline uint64_t BoxBytes(const glm::ivec3& min, const glm::ivec3& max) {
+	glm::ivec3 size = max - min + 1;
+	return (uint64_t)size.x * (uint64_t)size.y * (uint64_t)size.z * ShadowVolume::BrickBytes;
+}
 
-	_UpdateRegions.push_back(ImageRegion{0,0,0, _Volume.getExtent().width, _Volume.getExtent().height, _Volume.getExtent().depth, 0});
+void ShadowVoxSystem::CoalesceBricks(std::vector<int32>& bricks) {
+	//A copy costs about as much as staging this many bytes
+	constexpr int64_t RegionCost = 2 * ShadowVolume::BrickBytes;
+	//Copies per upload, above it the boxes are merged even if they stage many unchanged bricks
+	constexpr size_t MaxRegions = 64;
+
+	std::sort(bricks.begin(), bricks.end());
+	bricks.erase(std::unique(bricks.begin(), bricks.end()), bricks.end());
+
+	_Boxes.clear();
+	for (int32 b : bricks) {
+		glm::ivec3 p(b % AtlasBricks, (b / AtlasBricks) % AtlasBricks, b / (AtlasBricks * AtlasBricks));
+		_Boxes.push_back(BrickBox{ p, p });
+	}
+
+	//Sorted by slice, row and column, so every box is merged with the previous one while it pays off
+	//the allowed cost grows until there are few enough boxes
+	int64_t cost = RegionCost;
+	while (true) {
+		size_t count = 0;
+		for (size_t i = 0; i < _Boxes.size(); i++) {
+			if (count > 0) {
+				BrickBox& last = _Boxes[count - 1];
+				glm::ivec3 min = glm::min(last.Min, _Boxes[i].Min);
+				glm::ivec3 max = glm::max(last.Max, _Boxes[i].Max);
+				int64_t extra = (int64_t)BoxBytes(min, max) - (int64_t)BoxBytes(last.Min, last.Max) - (int64_t)BoxBytes(_Boxes[i].Min, _Boxes[i].Max);
+				if (extra <= cost) {
+					last.Min = min;
+					last.Max = max;
+					continue;
+				}
+			}
+			_Boxes[count++] = _Boxes[i];
+		}
+		_Boxes.resize(count);
+
+		if (_Boxes.size() <= MaxRegions)break;
+		cost *= 4;
+	}
 }
 
+void ShadowVoxSystem::UploadBricks(std::vector<int32>& bricks, bool newAtlas) {
+	if (bricks.empty() && !newAtlas)return;
+
+	_Stats.Bricks += (uint32)bricks.size();
+	CoalesceBricks(bricks);
+
+	uint64_t size = 0;
+	for (const BrickBox& box : _Boxes) {
+		size += BoxBytes(box.Min, box.Max);
+	}
+
+	//The copies recorded with a staging buffer are done StagingFrames later
+	uint64_t frame = Graphics::GetFrameIndex();
+	if (frame != _StagingFrame) {
+		_StagingFrame = frame;
+		_StagingUsed = 0;
+	}
+	int32 slot = (int32)(frame % StagingFrames);
+	if (_StagingUsed + size > _StagingSize[slot]) {
+		//The queued copies keep the previous buffer alive
+		_StagingSize[slot] = glm::max(_StagingUsed + size, _StagingSize[slot] * 2);
+		_Staging[slot] = Buffer::Create(_StagingSize[slot]);
+		_StagingUsed = 0;
+	}
+
+	//Every box is packed in the staging buffer with the layout of its texels
+	Buffer staging = _Staging[slot];
+	uint8* data = size > 0 ? (uint8*)staging.getData() : nullptr;
+	std::vector<ImageRegion> regions;
+	regions.reserve(_Boxes.size());
+
+	for (const BrickBox& box : _Boxes) {
+		glm::ivec3 texels = (box.Max - box.Min + 1) * (int)BrickTexels;
+		uint8* dst = data + _StagingUsed;
+
+		for (int32 z = box.Min.z; z <= box.Max.z; z++) {
+			for (int32 y = box.Min.y; y <= box.Max.y; y++) {
+				for (int32 x = box.Min.x; x <= box.Max.x; x++) {
+					//Unchanged bricks inside the box are staged again, the free ones are never read
+					const uint8* src = _Volume.GetBrickData(x + y * AtlasBricks + z * AtlasBricks * AtlasBricks);
+					glm::ivec3 o = (glm::ivec3(x, y, z) - box.Min) * (int)BrickTexels;
+
+					for (uint32 tz = 0; tz < BrickTexels; tz++) {
+						for (uint32 ty = 0; ty < BrickTexels; ty++) {
+							size_t row = (size_t)o.x + (size_t)(o.y + ty) * texels.x + (size_t)(o.z + tz) * texels.x * texels.y;
+							memcpy(dst + row, src + ty * BrickTexels + tz * BrickTexels * BrickTexels, BrickTexels);
+						}
+					}
+				}
+			}
+		}
 
-inline void ShadowVoxSystem::SetVolumeAt(int x, int y, int z, int value) {
-	if (x < 0 || y < 0 || z < 0 || x >= _SizeX*2 || y >= _SizeY*2 || z >= _SizeZ*2)return;
-	
-	int bit = (x & 1) | ((y & 1) << 1) | ((z & 1) << 2);
-	int mask = 1 << bit;
+		glm::ivec3 min = box.Min * (int)BrickTexels;
+		regions.push_back(ImageRegion{ min.x, min.y, min.z, (uint32)texels.x, (uint32)texels.y, (uint32)texels.z, 0, 0, (int64_t)_StagingUsed });
+		_StagingUsed += BoxBytes(box.Min, box.Max);
+	}
 
-	x /= 2;
-	y /= 2;
-	z /= 2;
+	_Stats.Regions += (uint32)regions.size();
+	_Stats.Bytes += size;
 
-	uint8* data = ((uint8*)_Buffer.getData()) + ((size_t)x + ((size_t)y * (size_t)_SizeX) + ((size_t)z * (size_t)(_SizeXtimes_SizeY)));
-	*data = (*data & ~mask) | (value << bit);
+	Image atlas = _Atlas;
+	Graphics::QueueTransfer([atlas, staging, regions, newAtlas](CmdBuffer& cmd) mutable {
+		cmd.barrier(atlas, newAtlas ? ImageLayout::Undefined : ImageLayout::ShaderReadOptimal, ImageLayout::TransferDst);
+		if (!regions.empty()) {
+			cmd.copy(staging, atlas, regions);
+		}
+		cmd.barrier(atlas, ImageLayout::TransferDst, ImageLayout::ShaderReadOptimal);
+	});
 }
 
-inline bool ShadowVoxSystem::GetVolumeAt(int x, int y, int z) {
-	if (x < 0 || y < 0 || z < 0 || x >= _Volume.getExtent().width || y >= _Volume.getExtent().height || z >= _Volume.getExtent().depth)return false;
+void ShadowVoxSystem::UploadPageTable() {
+	uint8* data = (uint8*)_PageTable.getData();
 
-	int bit = (x & 1) | ((y & 1) << 1) | ((z & 1) << 2);
-	int mask = 1 << bit;
+	PageTableHeader header = {};
+	header.AtlasRID = _Atlas.getRID();
+	header.MasksRID = _BrickMasks.getRID();
+	for (int32 level = 0; level < ShadowVolume::LevelCount; level++) {
+		header.Origins[level] = glm::ivec4(_Volume.GetOrigin(level), 0);
+	}
+	memcpy(data, &header, sizeof(PageTableHeader));
+
+	int32* pages = (int32*)(data + sizeof(PageTableHeader));
+	for (int32 i = 0; i < ShadowVolume::LevelCount * ShadowVolume::PagesPerLevel; i++) {
+		pages[i] = _Volume.GetPage(i);
+	}
+}
+
+ShadowVoxSystem::ShadowVoxSystem() {
+	//The shader build checks the ShadowVolume constants of Light.frag
+	static_assert(sizeof(PageTableHeader) == 16 + 16 * ShadowVolume::LevelCount, "Must match ShadowVoxBuffer in Light.frag");
 
-	x /= 2;
-	y /= 2;
-	z /= 2;
+	//Headless has no Graphics, the worlds of the importers and the tests are never rendered
+	if (Engine::IsHeadless())return;
 
-	uint8* data = ((uint8*)_Buffer.getData()) + ((size_t)x + ((size_t)y * (size_t)_Volume.getExtent().width) + ((size_t)z * (size_t)_Volume.getExtent().width * (size_t)_Volume.getExtent().height));
-	return (*data & mask) != 1;
+	uint64_t size = sizeof(PageTableHeader) + sizeof(int32) * ShadowVolume::LevelCount * ShadowVolume::PagesPerLevel;
+	_PageTable = Buffer::Create(size, BufferUsage::Storage, MemoryType::CPU_TO_GPU);
+
+	ResizeAtlas();
+	UploadPageTable();
 }
 
 void ShadowVoxSystem::OnCreate() {
 	R->prepare<VoxRenderer>();
+	R->on_construct<VoxRenderer>().connect<&ShadowVoxSystem::OnVoxChanged>(this);
+	R->on_update<VoxRenderer>().connect<&ShadowVoxSystem::OnVoxChanged>(this);
 	R->on_destroy<VoxRenderer>().connect<&ShadowVoxSystem::OnVoxDestroyed>(this);
 
 }
@@ -116,87 +317,78 @@ void ShadowVoxSystem::OnCreate() {
 void ShadowVoxSystem::OnUpdate(float dt) {
 	PROFILE_FUNC();
 
-	R->view<Transform, VoxRenderer, Changed>().each([&](const entt::entity e, Transform& t, VoxRenderer& vr) {
-		if (!vr.Vox.IsValid())return;
-
-		AssetRefT<VoxAsset>& v = vr.Vox;
-		
-		int sx = v->GetImage().getExtent().width;
-		int sy = v->GetImage().getExtent().height;
-		int sz = v->GetImage().getExtent().depth;
-
-		glm::ivec3 startmin = glm::vec3(_Volume.getExtent().width-1, _Volume.getExtent().height-1, _Volume.getExtent().depth-1);
-		glm::ivec3 startmax = glm::vec3(0, 0, 0);
-
-		glm::ivec3 aabbmin = startmin;
-		glm::ivec3 aabbmax = startmax;
-
-		glm::mat4 previous_matrix = t.PreviousWorldMatrix;
-		previous_matrix = glm::translate(previous_matrix, -vr.Pivot);
-
-		glm::vec3 o =  previous_matrix[3];
-		glm::vec3 dx = previous_matrix[0] * 0.1f;
-		glm::vec3 dy = previous_matrix[1] * 0.1f;
-		glm::vec3 dz = previous_matrix[2] * 0.1f;
-
-		for (int z = 0; z < sz; z++) {
-			for (int y = 0; y < sy; y++) {
-				for (int x = 0; x < sx; x++) {
-					if (*v->PixelAt(x, y, z) >= 16) {
-						glm::vec3 wp = o + (float)(x) * dx + (float)(y) * dy + (float)(z) * dz;
-						glm::ivec3 fwp = glm::ivec3(wp * 10.0f);
-						aabbmin = glm::min(aabbmin, fwp);
-						aabbmax = glm::max(aabbmax, fwp);
-						//*VolumeAt(fwp.x, fwp.y, fwp.z) = 0;
-						SetVolumeAt(fwp.x, fwp.y, fwp.z, 0);
-					}
-				}
-			}
-		}
+	if (Engine::IsHeadless())return;
 
-		glm::mat4 current_matrix = t.WorldMatrix;
-		current_matrix = glm::translate(current_matrix, -vr.Pivot);
-		o =  current_matrix[3];
-		dx = current_matrix[0] * 0.1f;
-		dy = current_matrix[1] * 0.1f;
-		dz = current_matrix[2] * 0.1f;
-
-		for (int z = 0; z < sz; z++) {
-			for (int y = 0; y < sy; y++) {
-				for (int x = 0; x < sx; x++) {
-					if (*v->PixelAt(x, y, z) >= 16) {
-						glm::vec3 wp = o + (float)(x) * dx + (float)(y) * dy + (float)(z) * dz;
-						glm::ivec3 fwp = glm::ivec3(wp * 10.0f);
-						aabbmin = glm::min(aabbmin, fwp);
-						aabbmax = glm::max(aabbmax, fwp);
-						//*VolumeAt(fwp.x, fwp.y, fwp.z) = 1;
-						SetVolumeAt(fwp.x, fwp.y, fwp.z, 1);
-					}
-				}
-			}
-		}
+	_Stats = UploadStats();
 
+	//Clears the bricks that left the windows and finds the ones that entered
+	_Exposed.clear();
+	_Volume.SetFocus(_Focus, _Exposed);
 
-		//If isn't inside the ShadowVolume AABB
-		if (aabbmax != startmax){
-			aabbmin /= 2;
-			aabbmax /= 2;
+	//The moved entities and the ones with a new VoxRenderer
+	_Rewritten.clear();
+	R->view<Transform, VoxRenderer, Changed>().each([&](const entt::entity e, Transform& t, VoxRenderer& vr) {
+		_Rewritten.push_back(e);
+	});
+	for (entt::entity e : _Pending) {
+		if (R->valid(e))_Rewritten.push_back(e);
+	}
+	_Pending.clear();
+	std::sort(_Rewritten.begin(), _Rewritten.end());
+	_Rewritten.erase(std::unique(_Rewritten.begin(), _Rewritten.end()), _Rewritten.end());
 
-			aabbmin = glm::max(aabbmin, glm::ivec3(0, 0, 0));
-			aabbmax = glm::min(aabbmax, startmin);
+	_Updates.clear();
+	for (entt::entity e : _Rewritten) {
+		RewriteEntity(e);
+	}
 
-			glm::ivec3 size = aabbmax - aabbmin + glm::ivec3(1, 1, 1);
-			_UpdateRegions.push_back(ImageRegion{ aabbmin.x, aabbmin.y, aabbmin.z, (uint32)size.x, (uint32)size.y, (uint32)size.z, 0 });
-		}
-	});
-	
-	if (!_UpdateRegions.empty()) {
-		Graphics::Transfer([&](CmdBuffer& cmd) {
-			cmd.barrier(_Volume, ImageLayout::ShaderReadOptimal, ImageLayout::TransferDst);
-			cmd.copy(_Buffer, _Volume, _UpdateRegions);
-			cmd.barrier(_Volume, ImageLayout::TransferDst, ImageLayout::ShaderReadOptimal);
+	//The entities with assets edited since they were written
+	if (VoxAsset::GetEditCount() != _EditCount) {
+		_EditCount = VoxAsset::GetEditCount();
+		RewriteEdited();
+	}
+
+	//The entities touching the entered bricks write them again, the same surface they have in the rest of the volume
+	for (int32 i = 0; i < (int32)_Exposed.size(); i++) {
+		AABB bounds;
+		_Volume.GetRegionWorldBounds(_Exposed[i], bounds.Min, bounds.Max);
+		W->Physics->QueryBox(bounds, [&](entt::entity e) {
+			if (std::binary_search(_Rewritten.begin(), _Rewritten.end(), e))return true;
+
+			auto it = _Written.find(e);
+			if (it == _Written.end())return true;
+
+			SurfaceUpdate update;
+			update.Surface = it->second.Surface;
+			update.Current = it->second.GridToWorld;
+			update.Region = i;
+			_Updates.push_back(update);
+			return true;
 		});
-		_UpdateRegions.clear();
 	}
-}
 
+	if (!_Updates.empty()) {
+		//Every entity is erased before any is written, so an erase never clears a new position
+		WriteSurfaces(0);
+		WriteSurfaces(1);
+	}
+
+	_ChangedBricks.clear();
+	for (std::vector<int32>& dirty : _GroupDirty) {
+		_Volume.Flush(dirty, _ChangedBricks);
+		dirty.clear();
+	}
+
+	bool newAtlas = _Volume.GetChunkCount() > _AtlasChunks;
+	if (newAtlas) {
+		ResizeAtlas();
+	}
+	else {
+		UploadMasks(_ChangedBricks);
+		UploadBricks(_ChangedBricks, false);
+	}
+
+	if (_Volume.ConsumePagesChanged() || newAtlas || !_Exposed.empty()) {
+		UploadPageTable();
+	}
+}
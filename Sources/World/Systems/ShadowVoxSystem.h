@@ -2,34 +2,122 @@
 
 #include "System.h"
 
+#include "Asset/VoxAsset.h"
 #include "Graphics/Graphics.h"
+#include "Vox/ShadowVolume.h"
+#include "Vox/VoxSurface.h"
+
+#include <memory>
+#include <unordered_map>
 
 class ShadowVoxSystem : public System {
-	Buffer _Buffer;
-	Image _Volume;
-	std::vector<ImageRegion> _UpdateRegions;
+public:
+	// Upload counters of the last update
+	struct UploadStats {
+		uint32 Bricks{ 0 };  // Changed bricks
+		uint32 Regions{ 0 }; // Copies recorded
+		uint64_t Bytes{ 0 }; // Staged bytes, with the unchanged bricks merged in the regions
+	};
+
+private:
+	ShadowVolume _Volume;
+	glm::vec3 _Focus{ 0.0f, 0.0f, 0.0f };
+
+	// Bricks in a 3D image of 16x16 bricks per slice, one slice per ShadowVolume chunk
+	Image _Atlas;
+	int32 _AtlasChunks{ 0 };
 
+	// Bricks are uploaded from a staging buffer per frame in flight, recorded in the next Frame without waiting
+	inline static constexpr int32 StagingFrames = 2;
+	Buffer _Staging[StagingFrames];
+	uint64_t _StagingSize[StagingFrames]{};
+	uint64_t _StagingUsed{ 0 };
+	uint64_t _StagingFrame{ UINT64_MAX };
 
-	uint32 _SizeX;
-	uint32 _SizeY;
-	uint32 _SizeZ;
-	uint32 _SizeXtimes_SizeY;
+	// Box of atlas bricks uploaded with one copy
+	struct BrickBox {
+		glm::ivec3 Min;
+		glm::ivec3 Max;
+	};
+	std::vector<BrickBox> _Boxes;
 
-	std::vector<uint8> _Data;
+	// Read by the shaders, the atlas, the window origins and the brick of every window slot
+	struct PageTableHeader {
+		int32 AtlasRID;
+		int32 MasksRID;
+		int32 Pad[2];
+		glm::ivec4 Origins[ShadowVolume::LevelCount];
+	};
+	Buffer _PageTable;
+	// Mask of the 4^3 cells blocks of every brick, same index as the atlas
+	Buffer _BrickMasks;
 
+	// The surface written for every entity, it's removed with the same cells
+	struct WrittenSurface {
+		AssetRefT<VoxAsset> Vox;
+		std::shared_ptr<const VoxSurface> Surface;
+		glm::mat4 GridToWorld;
+		uint32 Revision; // Of the asset when Surface was written
+	};
+	std::unordered_map<entt::entity, WrittenSurface> _Written;
+	// Entities with the VoxRenderer created or replaced, written again even if they didn't move
+	std::vector<entt::entity> _Pending;
+	std::vector<entt::entity> _Rewritten;
+
+	// A surface being revoxelized this frame
+	struct SurfaceUpdate {
+		std::shared_ptr<const VoxSurface> PreviousSurface; // nullptr when nothing was written
+		std::shared_ptr<const VoxSurface> Surface;         // nullptr when is only removed
+		glm::mat4 Previous;
+		glm::mat4 Current;
+		int32 Region; // Exposed region to fill, -1 for the Changed entities
+	};
+	std::vector<SurfaceUpdate> _Updates;
+	// VoxAsset::GetEditCount() when the edited assets were last checked
+	uint32 _EditCount{ 0 };
+	// Edited part of the previous and current surfaces, by previous surface, shared by the entities with the same asset
+	std::unordered_map<const VoxSurface*, std::pair<std::shared_ptr<VoxSurface>, std::shared_ptr<VoxSurface>>> _EditedParts;
+	std::vector<ShadowVolume::Region> _Exposed;
+	// Volume cells of the surface being written and the pages changed, one per Jobs group
+	std::vector<std::vector<glm::ivec3>> _GroupCells;
+	std::vector<std::vector<int32>> _GroupDirty;
+	std::vector<int32> _ChangedBricks;
+	UploadStats _Stats;
+
+	void OnVoxChanged(entt::registry& r, entt::entity e);
 	void OnVoxDestroyed(entt::registry& r, entt::entity e);
+	// Removes what was written for the entity and writes its current surface
+	void RewriteEntity(entt::entity e);
+	// Rewrites the edited bounds of the entities with assets edited after they were written
+	// all the surface when the bounds are not known or the windows moved
+	void RewriteEdited();
+
+	// Sets the volume cells of the surface voxels to value inside bounds
+	// Can be called from the Jobs threads, each with its own cells and dirty
+	void WriteSurface(const VoxSurface& surface, const glm::mat4& gridToWorld, int value, const ShadowVolume::Bounds& bounds, std::vector<glm::ivec3>& cells, std::vector<int32>& dirty);
+	void WriteSurfaces(int value);
+
+	// Recreates the atlas when the volume has more chunks, all the bricks are uploaded again
+	void ResizeAtlas();
+	// Merges the bricks in boxes, when a box costs less than the copies it replaces
+	void CoalesceBricks(std::vector<int32>& bricks);
+	void UploadBricks(std::vector<int32>& bricks, bool newAtlas);
+	void UploadPageTable();
+	void UploadMasks(const std::vector<int32>& bricks);
 
 public:
 
 	ShadowVoxSystem();
 
-	inline void SetVolumeAt(int x, int y, int z, int value);
-	inline bool GetVolumeAt(int x, int y, int z);
+	// The windows of the volume follow this point, usually the camera
+	void SetFocus(const glm::vec3& position) { _Focus = position; }
 
-	Image& GetVolumeImage() { return _Volume; }
+	const ShadowVolume& GetVolume() const { return _Volume; }
+	Buffer& GetPageTable() { return _PageTable; }
+	const UploadStats& GetUploadStats() const { return _Stats; }
 
 	virtual void OnCreate();
 	virtual void OnUpdate(float dt);
 	virtual void OnEvent(Event& e) {}
 	virtual void OnDestroy() {}
-};
\ No newline at end of file
+};
@@ -39,8 +39,11 @@ void World::Update(float dt) {
 	}
 
 	Character->OnUpdate(dt);
+	//Moved with the velocity the characters set this frame
+	if (_isSimulating)Physics->UpdateControllers(dt);
 	Transform->OnUpdate(dt);
 	IK->OnUpdate(dt);
+	Physics->UpdateBroadphase();
 	ShadowVox->OnUpdate(dt);
 }
 
@@ -75,6 +78,8 @@ void World::SetParent(entt::entity child, entt::entity parent) {
 		if (!_Registry.has<Hierarchy>(parent))_Registry.emplace<Hierarchy>(parent);
 		_Registry.get<Hierarchy>(parent).Children.push_back(child);
 	}
+
+	_Registry.patch<Hierarchy>(child);
 }
 
 const std::string& World::GetName(entt::entity e) { return _Registry.get<Hierarchy>(e).Name; }
@@ -760,11 +760,12 @@ namespace evk {
 		auto extent = image.getExtent();
 
 		for (auto& region : regions) {
+			bool packed = region.bufferOffset >= 0;
 			state->cmd.copyBufferToImage(buffer.state->buffer, image.state->image, vk::ImageLayout::eTransferDstOptimal,
 				vk::BufferImageCopy()
-				.setBufferOffset(region.x + region.y * extent.width + region.z * extent.width * extent.height)
-				.setBufferRowLength(extent.width)
-				.setBufferImageHeight(extent.height)
+				.setBufferOffset(packed ? region.bufferOffset : region.x + region.y * extent.width + region.z * extent.width * extent.height)
+				.setBufferRowLength(packed ? 0 : extent.width)
+				.setBufferImageHeight(packed ? 0 : extent.height)
 				.setImageSubresource(vk::ImageSubresourceLayers()
 					.setAspectMask(vk::ImageAspectFlagBits::eColor)
 					.setMipLevel(region.mip)
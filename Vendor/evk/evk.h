@@ -152,6 +152,7 @@ namespace evk {
 	struct ImageRegion {
 		int x, y, z;
 		uint32_t width, height, depth, mip{ 0 }, layer{ 0 };
+		int64_t bufferOffset{ -1 }; // Tightly packed data at this offset, -1 when the buffer has the layout of the whole image
 	};
 	struct TimestampEntry {
 		double start, end;